@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+   Tiny benchmark harness for Aerial
+   -----------------------------------------
+   Each case is a function that runs its body `state.iterations` times.
+   The runner picks the iteration count, times the call and, because
+   bench_main.cpp replaces global operator new, also reports how many
+   allocations / bytes each iteration cost.
+
+       AERIAL_BENCH(reply_status) {
+           Fixture& f = fixture();   // built once, on the first call
+           state.resetTimer();
+           for (size_t i = 0; i < state.iterations; ++i) { ... }
+       }
+*/
+
+namespace bench {
+
+struct State {
+    size_t iterations = 1;
+
+    // Restarts the clock and the allocation counts. Call it after any
+    // setup that is not part of what the case measures, e.g. building a
+    // large fixture on the first call.
+    void resetTimer();
+
+    // Extra per-case numbers printed next to the timing (e.g. rows/sec).
+    void report(const std::string& name, double value) {
+        extras.emplace_back(name, value);
+    }
+
+    std::vector<std::pair<std::string, double>> extras;
+};
+
+using Fn = void (*)(State&);
+
+struct Case {
+    const char* name;
+    Fn fn;
+};
+
+std::vector<Case>& registry();
+
+struct Registrar {
+    Registrar(const char* name, Fn fn) { registry().push_back({name, fn}); }
+};
+
+// Defeats dead-code elimination of benchmark results.
+template <typename T>
+inline void keep(T&& value) {
+#if defined(_MSC_VER)
+    static const void* volatile sink;
+    sink = &value;
+#else
+    asm volatile("" : : "g"(&value) : "memory");
+#endif
+}
+
+} // namespace bench
+
+#define AERIAL_BENCH(name)                                          \
+    static void name(bench::State& state);                          \
+    static bench::Registrar name##_registrar(#name, name);          \
+    static void name(bench::State& state)
@@ -0,0 +1,77 @@
+// Command parsing as every front-end does it (parse_command), over a mix
+// of the commands clients send. Before the first timing it checks that
+// the edge cases below are accepted or refused as intended, and stops the
+// run if one is not: a non-finite or out-of-range argument must never
+// reach execute_command.
+
+#include "bench.hpp"
+
+#include "Commands.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+
+static void check_edge_cases() {
+    struct Case { std::string_view text; bool accepted; };
+    static const Case cases[] = {
+        {"vol 40",        true},
+        {"vol 0",         true},
+        {"vol 100",       true},
+        {"vol -0",        true},
+        {"vol 101",       false},
+        {"vol -1",        false},
+        {"vol nan",       false},
+        {"vol inf",       false},
+        {"vol 1e300",     false},
+        {"seek 0",        true},
+        {"seek 30.5",     true},
+        {"seek 86400",    true},
+        {"seek 86401",    false},
+        {"seek -5",       false},
+        {"seek inf",      false},
+        {"seek -inf",     false},
+        {"seek nan",      false},
+        {"seek 1e300",    false},
+        {"jump 3",        true},
+        {"jump -1",       false},
+        {"jump 1.5",      false},
+        {"jump nan",      false},
+        {"jump 1e300",    false},
+        {"qmove 5 0",     true},
+        {"qmove 5 inf",   false},
+        {"qinsert 0 nan", false},
+    };
+
+    bool ok = true;
+    for (const Case& c : cases) {
+        Command cmd;
+        if (parse_command(c.text, cmd) != c.accepted) {
+            std::fprintf(stderr, "bench_commands: parse_command(\"%.*s\") %s, expected it %s\n",
+                         static_cast<int>(c.text.size()), c.text.data(),
+                         c.accepted ? "refused" : "accepted", c.accepted ? "accepted" : "refused");
+            ok = false;
+        }
+    }
+    if (!ok)
+        std::exit(1);
+}
+
+AERIAL_BENCH(command_parse_mix) {
+    static const bool checked = (check_edge_cases(), true);
+    bench::keep(checked);
+    state.resetTimer();
+
+    static const std::string_view mix[] = {
+        "next", "pause", "resume", "vol 40", "seek 30", "jump 1234",
+        "queue 17", "qmove 5 0", "@main prev", "VOLUP",
+    };
+    constexpr size_t kMix = sizeof(mix) / sizeof(mix[0]);
+    Command cmd;
+    size_t accepted = 0;
+    for (size_t i = 0; i < state.iterations; ++i) {
+        accepted += parse_command(mix[i % kMix], cmd);
+        bench::keep(cmd);
+    }
+    bench::keep(accepted);
+}
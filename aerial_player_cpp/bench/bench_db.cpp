@@ -0,0 +1,88 @@
+// PlayDatabase insert throughput: the original prepare-per-event path on
+// SQLite's default rollback journal versus the write-behind queue under
+// each pragma profile (timed through flush(), i.e. until committed).
+// Databases live in the system temp directory.
+
+#include "bench.hpp"
+
+#include "DB.hpp"
+
+#include <sqlite3.h>
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+
+namespace fs = std::filesystem;
+
+static std::string fresh_db_path(const char* name) {
+    fs::path p = fs::temp_directory_path() / (std::string("aerial_bench_") + name + ".db");
+    for (const char* suffix : {"", "-wal", "-shm", "-journal"}) {
+        std::error_code ec;
+        fs::remove(p.string() + suffix, ec);
+    }
+    return p.string();
+}
+
+static const std::string kTrack = "/music/Artist/Album/03 - Some Track Title.flac";
+
+// Reproduces logEvent before statements were cached and WAL was enabled.
+AERIAL_BENCH(db_insert_legacy_prepare_per_event) {
+    std::string path = fresh_db_path("legacy");
+    sqlite3* db = nullptr;
+    sqlite3_open(path.c_str(), &db);
+    sqlite3_exec(db,
+                 "CREATE TABLE IF NOT EXISTS plays ("
+                 "  id INTEGER PRIMARY KEY AUTOINCREMENT,"
+                 "  track_path TEXT NOT NULL, track_title TEXT NOT NULL,"
+                 "  event_type TEXT NOT NULL,"
+                 "  created_at DATETIME DEFAULT CURRENT_TIMESTAMP);",
+                 nullptr, nullptr, nullptr);
+
+    for (size_t i = 0; i < state.iterations; ++i) {
+        sqlite3_stmt* stmt = nullptr;
+        sqlite3_prepare_v2(db,
+                           "INSERT INTO plays (track_path, track_title, event_type) VALUES (?, ?, ?);",
+                           -1, &stmt, nullptr);
+        sqlite3_bind_text(stmt, 1, kTrack.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 2, "03 - Some Track Title.flac", -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 3, "play", -1, SQLITE_TRANSIENT);
+        sqlite3_step(stmt);
+        sqlite3_finalize(stmt);
+    }
+
+    sqlite3_close(db);
+}
+
+using BenchClock = std::chrono::steady_clock;
+
+static void run_profile(bench::State& state, const char* profile) {
+    std::string path = fresh_db_path(profile);
+    DbOptions options = DbOptions::fromProfile(profile);
+    options.queue_capacity = 1 << 16;
+    options.overflow = "block";  // measure the writer, not the drop path
+    PlayDatabase db(path, options);
+
+    auto t0 = BenchClock::now();
+    for (size_t i = 0; i < state.iterations; ++i) {
+        db.logPlay(kTrack);
+    }
+    auto t1 = BenchClock::now();
+    db.flush();
+
+    // What the control thread actually pays per logPlay().
+    state.report("caller ns/event",
+                 std::chrono::duration<double, std::nano>(t1 - t0).count() / state.iterations);
+}
+
+AERIAL_BENCH(db_insert_profile_safe) {
+    run_profile(state, "safe");
+}
+
+AERIAL_BENCH(db_insert_profile_balanced) {
+    run_profile(state, "balanced");
+}
+
+AERIAL_BENCH(db_insert_profile_fast) {
+    run_profile(state, "fast");
+}
@@ -0,0 +1,173 @@
+// Play history layout: the original denormalized `plays` table versus
+// tracks/events after PlayDatabase's online migration, on a synthetic
+// multi-million-event history. Reports file size and a few typical
+// queries on each. Runs once; set AERIAL_BENCH_EVENTS to change the size
+// (default 2,000,000 events over 20,000 tracks).
+
+#include "bench.hpp"
+
+#include "DB.hpp"
+
+#include <sqlite3.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+using BenchClock = std::chrono::steady_clock;
+
+static std::string history_db_path(const char* name) {
+    fs::path p = fs::temp_directory_path() / (std::string("aerial_bench_") + name + ".db");
+    for (const char* suffix : {"", "-wal", "-shm", "-journal"}) {
+        std::error_code ec;
+        fs::remove(p.string() + suffix, ec);
+    }
+    return p.string();
+}
+
+static double elapsed_ms(BenchClock::time_point since) {
+    return std::chrono::duration<double, std::milli>(BenchClock::now() - since).count();
+}
+
+// Best of three, in milliseconds.
+static double time_query(sqlite3* db, const char* sql) {
+    double best = 1e300;
+    for (int run = 0; run < 3; ++run) {
+        auto t0 = BenchClock::now();
+        sqlite3_stmt* stmt = nullptr;
+        sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            bench::keep(sqlite3_column_int64(stmt, 0));
+        }
+        sqlite3_finalize(stmt);
+        best = std::min(best, elapsed_ms(t0));
+    }
+    return best;
+}
+
+// The version 0 schema, plus the (track_path, created_at) index anyone
+// querying it per track would have added.
+static void build_legacy_history(const std::string& path, size_t events, size_t tracks) {
+    sqlite3* db = nullptr;
+    sqlite3_open(path.c_str(), &db);
+    sqlite3_exec(db,
+                 "PRAGMA journal_mode=WAL; PRAGMA synchronous=OFF;"
+                 "CREATE TABLE plays ("
+                 "  id INTEGER PRIMARY KEY AUTOINCREMENT,"
+                 "  track_path TEXT NOT NULL, track_title TEXT NOT NULL,"
+                 "  event_type TEXT NOT NULL,"
+                 "  created_at DATETIME DEFAULT CURRENT_TIMESTAMP);"
+                 "CREATE INDEX plays_track ON plays(track_path, created_at);"
+                 "BEGIN;",
+                 nullptr, nullptr, nullptr);
+
+    sqlite3_stmt* stmt = nullptr;
+    sqlite3_prepare_v2(db,
+                       "INSERT INTO plays (track_path, track_title, event_type, created_at) "
+                       "VALUES (?, ?, ?, datetime(?, 'unixepoch'));",
+                       -1, &stmt, nullptr);
+
+    static const char* kinds[] = {"play", "play", "play", "skip", "finished"};
+    const int64_t start = 1600000000;  // Sept 2020, ~4 events a minute since
+    uint64_t rng = 88172645463325252ull;
+    char trackPath[160];  // both fit their formats with every %zu at its widest
+    char title[64];
+    for (size_t i = 0; i < events; ++i) {
+        rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+        // Skewed popularity: low track numbers are played far more often.
+        size_t track = static_cast<size_t>((rng % tracks) * ((rng >> 32) % tracks) / tracks);
+        std::snprintf(title, sizeof(title), "%02zu - Track Title %05zu.flac", track % 20 + 1, track);
+        std::snprintf(trackPath, sizeof(trackPath), "/home/user/Music/Artist %04zu/Album %03zu/%s",
+                      track / 200, track / 20, title);
+
+        sqlite3_bind_text(stmt, 1, trackPath, -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, title, -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 3, kinds[(rng >> 20) % 5], -1, SQLITE_STATIC);
+        sqlite3_bind_int64(stmt, 4, start + static_cast<int64_t>(i) * 15);
+        sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+    sqlite3_exec(db, "COMMIT; PRAGMA wal_checkpoint(TRUNCATE);", nullptr, nullptr, nullptr);
+    sqlite3_close(db);
+}
+
+struct HistoryQueries {
+    const char* topPlayed;
+    const char* trackHistory;
+    const char* perDay;
+};
+
+static const HistoryQueries kLegacyQueries = {
+    "SELECT track_path, COUNT(*) AS n FROM plays WHERE event_type = 'play' "
+    "GROUP BY track_path ORDER BY n DESC LIMIT 10;",
+    "SELECT COUNT(*) FROM plays WHERE track_path = "
+    "'/home/user/Music/Artist 0000/Album 000/04 - Track Title 00003.flac' "
+    "AND created_at >= '2021-01-01';",
+    "SELECT date(created_at) AS d, COUNT(*) FROM plays GROUP BY d;",
+};
+
+static const HistoryQueries kNormalizedQueries = {
+    "SELECT t.path, n FROM (SELECT track_id, COUNT(*) AS n FROM events WHERE event = 1 "
+    "GROUP BY track_id ORDER BY n DESC LIMIT 10) JOIN tracks t ON t.id = track_id;",
+    "SELECT COUNT(*) FROM events WHERE track_id = (SELECT id FROM tracks WHERE path = "
+    "'/home/user/Music/Artist 0000/Album 000/04 - Track Title 00003.flac') "
+    "AND ts >= 1609459200;",
+    "SELECT ts / 86400 AS d, COUNT(*) FROM events GROUP BY d;",
+};
+
+static void report_queries(bench::State& state, const std::string& path,
+                           const char* label, const HistoryQueries& q) {
+    sqlite3* db = nullptr;
+    sqlite3_open(path.c_str(), &db);
+    std::error_code ec;
+    state.report(std::string(label) + " MiB", fs::file_size(path, ec) / (1024.0 * 1024.0));
+    state.report(std::string(label) + " top-10 played ms", time_query(db, q.topPlayed));
+    state.report(std::string(label) + " one track history ms", time_query(db, q.trackHistory));
+    state.report(std::string(label) + " events per day ms", time_query(db, q.perDay));
+    sqlite3_close(db);
+}
+
+AERIAL_BENCH(db_history_normalization) {
+    const char* env = std::getenv("AERIAL_BENCH_EVENTS");
+    const size_t events = env ? std::strtoull(env, nullptr, 10) : 2000000;
+    const size_t tracks = 20000;
+
+    std::string path = history_db_path("history");
+    build_legacy_history(path, events, tracks);
+    report_queries(state, path, "legacy", kLegacyQueries);
+
+    {
+        DbOptions options = DbOptions::fromProfile("fast");
+        auto t0 = BenchClock::now();
+        PlayDatabase db(path, options);
+        state.report("migration startup ms", elapsed_ms(t0));
+
+        // Rows are copied by the writer thread after the constructor returns.
+        while (db.migrating()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        double secs = elapsed_ms(t0) / 1000.0;
+        state.report("migration total s", secs);
+        state.report("migration rows/s", events / secs);
+    }
+
+    sqlite3* db = nullptr;
+    sqlite3_open(path.c_str(), &db);
+    sqlite3_exec(db, "VACUUM; PRAGMA wal_checkpoint(TRUNCATE);", nullptr, nullptr, nullptr);
+    sqlite3_close(db);
+    report_queries(state, path, "normalized", kNormalizedQueries);
+
+    // What "most played" costs now that the totals are kept up to date.
+    sqlite3_open(path.c_str(), &db);
+    state.report("track_stats top-10 played ms",
+                 time_query(db, "SELECT t.path, s.plays FROM track_stats s "
+                                "JOIN tracks t ON t.id = s.track_id "
+                                "ORDER BY s.plays DESC LIMIT 10;"));
+    sqlite3_close(db);
+}
@@ -0,0 +1,109 @@
+// HTTP request handling over loopback: a fresh connection per request
+// (the server closes after each reply) against the real server, for a
+// small JSON reply, a 100-track /tracks page, /metrics and a 404.
+// The server gets a 10k-track playlist and a player that is never
+// initialised, so no route here touches audio. Port 18080, or
+// AERIAL_BENCH_HTTP_PORT.
+
+#ifndef _WIN32
+
+#include "bench.hpp"
+
+#include "Player.hpp"
+#include "Playlist.hpp"
+#include "server.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+
+static int http_port() {
+    static const int port = [] {
+        const char* env = std::getenv("AERIAL_BENCH_HTTP_PORT");
+        return env ? std::atoi(env) : 18080;
+    }();
+    return port;
+}
+
+static int connect_loopback() {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(http_port()));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+// Starts the server once and waits until it accepts connections.
+static bool server_ready() {
+    static const bool ready = [] {
+        static Player player;
+        auto playlist = std::make_shared<Playlist>();
+        char buf[128];  // fits the format with every %zu at its widest
+        for (size_t i = 0; i < 10000; ++i) {
+            std::snprintf(buf, sizeof(buf), "/music/Artist %04zu/Album %03zu/%02zu - Track Title %zu.flac",
+                          i / 200, i / 20, i % 20 + 1, i);
+            playlist->addTrack(buf);
+        }
+        start_http_server(player, playlist, nullptr, http_port());
+        for (int attempt = 0; attempt < 200; ++attempt) {
+            int fd = connect_loopback();
+            if (fd >= 0) {
+                ::close(fd);
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        std::fprintf(stderr, "bench_http: server did not start on port %d\n", http_port());
+        return false;
+    }();
+    return ready;
+}
+
+// One request, reading the reply until the server closes; returns its size.
+static size_t round_trip(const std::string& request) {
+    int fd = connect_loopback();
+    if (fd < 0) return 0;
+    ::send(fd, request.data(), request.size(), 0);
+    char buf[16384];
+    size_t total = 0;
+    ssize_t n;
+    while ((n = ::recv(fd, buf, sizeof(buf), 0)) > 0)
+        total += static_cast<size_t>(n);
+    ::close(fd);
+    return total;
+}
+
+static void requests(bench::State& state, const char* target) {
+    if (!server_ready()) return;
+    const std::string request = std::string("GET ") + target + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    size_t bytes = 0;
+    for (size_t i = 0; i < state.iterations; ++i) {
+        bytes = round_trip(request);
+        bench::keep(bytes);
+    }
+    state.report("reply bytes", static_cast<double>(bytes));
+}
+
+AERIAL_BENCH(http_status)         { requests(state, "/status"); }
+AERIAL_BENCH(http_tracks_page)    { requests(state, "/tracks?cursor=5000&limit=100"); }
+AERIAL_BENCH(http_metrics)        { requests(state, "/metrics"); }
+AERIAL_BENCH(http_not_found)      { requests(state, "/nope"); }
+
+#endif // _WIN32
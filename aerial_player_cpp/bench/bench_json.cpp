@@ -0,0 +1,160 @@
+// JSON reading and writing: src/config.json as shipped, the largest
+// POST /batch body the HTTP server accepts (256 commands), and a page of
+// /tracks output. The *_mini_json cases run the parser json.hpp replaced,
+// and json_write_tracks_legacy the string escaping server.cpp used
+// before json::Writer, for comparison.
+
+#include "bench.hpp"
+
+#include "OutBuffer.hpp"
+#include "json.hpp"
+#include "mini_json_legacy.hpp"
+
+#include <string>
+#include <vector>
+
+static const std::string kConfig = R"({
+  "db_path": "D:/Code/aerial_player/cli/aerial.db",
+  "db_profile": "balanced",
+  "db_retention_days": 0,
+  "shuffle": "off",
+  "shuffle_cooldown": 50,
+  "log_level": "info",
+  "ui_fps": 30,
+  "port": 5050,
+  "scan_recursive": true,
+  "control_socket": ""
+})";
+
+static std::string batch_body() {
+    static const char* const commands[] = {"next", "vol 50", "seek 30", "pause", "resume", "jump 12"};
+    std::string body = "[";
+    for (int i = 0; i < 256; ++i) {
+        if (i) body += ", ";
+        body += '"';
+        body += commands[i % 6];
+        body += '"';
+    }
+    return body + "]";
+}
+
+// Touches every event, as Config.cpp and the batch handler do.
+struct CountingHandler : json::Handler {
+    size_t events = 0;
+    bool onNull() override { ++events; return true; }
+    bool onBool(bool) override { ++events; return true; }
+    bool onNumber(const json::Number& n) override { events += n.integer ? 1 : 2; return true; }
+    bool onString(std::string_view s) override { events += s.size(); return true; }
+    bool onKey(std::string_view k) override { events += k.size(); return true; }
+};
+
+AERIAL_BENCH(json_parse_config) {
+    json::Reader reader;
+    CountingHandler h;
+    for (size_t i = 0; i < state.iterations; ++i) {
+        bench::keep(reader.parse(kConfig, h));
+    }
+    bench::keep(h.events);
+    state.report("bytes", static_cast<double>(kConfig.size()));
+}
+
+AERIAL_BENCH(json_parse_config_mini_json) {
+    size_t keys = 0;
+    for (size_t i = 0; i < state.iterations; ++i) {
+        mini_json::json j = mini_json::json::parse(kConfig);
+        keys = j.size();
+        bench::keep(keys);
+    }
+    state.report("bytes", static_cast<double>(kConfig.size()));
+}
+
+AERIAL_BENCH(json_parse_batch_256) {
+    const std::string body = batch_body();
+    json::Reader reader;
+    CountingHandler h;
+    for (size_t i = 0; i < state.iterations; ++i) {
+        bench::keep(reader.parse(body, h));
+    }
+    bench::keep(h.events);
+    state.report("bytes", static_cast<double>(body.size()));
+}
+
+AERIAL_BENCH(json_parse_batch_256_mini_json) {
+    const std::string body = batch_body();
+    for (size_t i = 0; i < state.iterations; ++i) {
+        mini_json::json j = mini_json::json::parse(body);
+        bench::keep(j.size());
+    }
+    state.report("bytes", static_cast<double>(body.size()));
+}
+
+struct TrackRow {
+    std::string title;
+    std::string path;
+};
+
+static std::vector<TrackRow> track_rows() {
+    std::vector<TrackRow> rows;
+    for (int i = 0; i < 100; ++i) {
+        const std::string name = "Artist " + std::to_string(i % 17) + " - Song \"" +
+                                 std::to_string(i) + "\" (Live)";
+        rows.push_back({name, "/home/user/Music/Album " + std::to_string(i / 10) + "/" + name + ".mp3"});
+    }
+    return rows;
+}
+
+// server.cpp's append_json_string before json::Writer (no UTF-8 checks).
+static void legacy_append_string(OutBuffer& out, std::string_view s) {
+    static const char hex[] = "0123456789abcdef";
+    out << '"';
+    for (char ch : s) {
+        unsigned char c = static_cast<unsigned char>(ch);
+        switch (c) {
+        case '"':  out << "\\\""; break;
+        case '\\': out << "\\\\"; break;
+        case '\n': out << "\\n"; break;
+        case '\r': out << "\\r"; break;
+        case '\t': out << "\\t"; break;
+        default:
+            if (c < 0x20) out << "\\u00" << hex[c >> 4] << hex[c & 0xF];
+            else out << ch;
+        }
+    }
+    out << '"';
+}
+
+AERIAL_BENCH(json_write_tracks) {
+    const std::vector<TrackRow> rows = track_rows();
+    OutBuffer out(1 << 16);
+    for (size_t i = 0; i < state.iterations; ++i) {
+        out.clear();
+        json::Writer w(out);
+        w.beginArray();
+        for (size_t id = 0; id < rows.size(); ++id)
+            w.beginObject().field("id", id).field("title", rows[id].title)
+                .field("path", rows[id].path).endObject();
+        w.endArray();
+        bench::keep(out.size());
+    }
+    state.report("bytes", static_cast<double>(out.size()));
+}
+
+AERIAL_BENCH(json_write_tracks_legacy) {
+    const std::vector<TrackRow> rows = track_rows();
+    OutBuffer out(1 << 16);
+    for (size_t i = 0; i < state.iterations; ++i) {
+        out.clear();
+        out << '[';
+        for (size_t id = 0; id < rows.size(); ++id) {
+            if (id) out << ',';
+            out << "{\"id\":" << id << ",\"title\":";
+            legacy_append_string(out, rows[id].title);
+            out << ",\"path\":";
+            legacy_append_string(out, rows[id].path);
+            out << '}';
+        }
+        out << ']';
+        bench::keep(out.size());
+    }
+    state.report("bytes", static_cast<double>(out.size()));
+}
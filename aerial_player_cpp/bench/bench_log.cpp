@@ -0,0 +1,129 @@
+// Console logging cost: the old pattern (operator<< on an unbuffered
+// stream, the way std::cerr flushes after every insertion) against the
+// asynchronous logger, single-threaded and with four threads logging at
+// once. Both write to the null device so only the logging path is timed.
+
+#include "bench.hpp"
+
+#include "Log.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+static const char* kNullDevice = "NUL";
+#else
+static const char* kNullDevice = "/dev/null";
+#endif
+
+static const std::string kPath = "/music/Artist/Album/03 - Some Track Title.flac";
+static const size_t kThreads = 4;
+
+// Lines logged between flushes in the async cases; below the per-thread
+// ring size, so nothing is dropped and the sink's formatting and write
+// are part of the measurement.
+static const size_t kBurst = 200;
+
+static std::FILE* null_file() {
+    static std::FILE* f = std::fopen(kNullDevice, "w");
+    return f;
+}
+
+static void iostream_lines(std::ostream& out, std::mutex* mutex, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        std::unique_lock<std::mutex> lock;
+        if (mutex) lock = std::unique_lock<std::mutex>(*mutex);
+        out << "[HTTP] stream done: " << i << " KiB in " << 12 << " ms (" << 340
+            << " MiB/s), " << 3 << " still active, " << kPath << "\n";
+    }
+}
+
+static void async_lines(size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        AERIAL_INFO("HTTP", "stream done: ", i, " KiB in ", 12, " ms (", 340,
+                    " MiB/s), ", 3, " still active, ", kPath);
+        if (i % kBurst == kBurst - 1)
+            logging::flush();
+    }
+}
+
+template <typename Fn>
+static void on_threads(size_t total, Fn fn) {
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < kThreads; ++t)
+        threads.emplace_back(fn, total / kThreads);
+    for (auto& t : threads)
+        t.join();
+}
+
+AERIAL_BENCH(log_iostream_unitbuf_1t) {
+    std::ofstream out(kNullDevice);
+    out << std::unitbuf;
+    iostream_lines(out, nullptr, state.iterations);
+}
+
+AERIAL_BENCH(log_iostream_unitbuf_4t) {
+    std::ofstream out(kNullDevice);
+    out << std::unitbuf;
+    std::mutex mutex;
+    on_threads(state.iterations, [&](size_t n) { iostream_lines(out, &mutex, n); });
+}
+
+AERIAL_BENCH(log_async_1t) {
+    logging::setOutput(null_file());
+    async_lines(state.iterations);
+    logging::flush();
+    logging::setOutput(nullptr);
+    state.report("dropped", static_cast<double>(logging::dropped()));
+}
+
+AERIAL_BENCH(log_async_4t) {
+    logging::setOutput(null_file());
+    on_threads(state.iterations, async_lines);
+    logging::flush();
+    logging::setOutput(nullptr);
+    state.report("dropped", static_cast<double>(logging::dropped()));
+}
+
+// What the calling thread alone pays per line while the ring has room.
+AERIAL_BENCH(log_async_caller_only) {
+    logging::setOutput(null_file());
+    std::chrono::steady_clock::duration spent{};
+    for (size_t done = 0; done < state.iterations; done += kBurst) {
+        const size_t n = std::min(kBurst, state.iterations - done);
+        auto t0 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < n; ++i) {
+            AERIAL_INFO("HTTP", "stream done: ", i, " KiB in ", 12, " ms (", 340,
+                        " MiB/s), ", 3, " still active, ", kPath);
+        }
+        spent += std::chrono::steady_clock::now() - t0;
+        logging::flush();
+    }
+    logging::setOutput(nullptr);
+    state.report("caller ns/line",
+                 std::chrono::duration<double, std::nano>(spent).count() /
+                     static_cast<double>(state.iterations));
+}
+
+// A debug line with the runtime level at info: one relaxed load.
+AERIAL_BENCH(log_disabled_runtime) {
+    logging::setLevel(LogLevel::Info);
+    for (size_t i = 0; i < state.iterations; ++i) {
+        AERIAL_DEBUG("PLAYER", "Attempting to play: ", kPath, " #", i);
+        bench::keep(i);
+    }
+}
+
+// A trace line below AERIAL_LOG_MIN_LEVEL: compiled out.
+AERIAL_BENCH(log_disabled_compile_time) {
+    for (size_t i = 0; i < state.iterations; ++i) {
+        AERIAL_TRACE("PLAYER", "Attempting to play: ", kPath, " #", i);
+        bench::keep(i);
+    }
+}
@@ -0,0 +1,208 @@
+#include "bench.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <new>
+#include <string>
+
+// ───────────── Allocation accounting ─────────────
+//
+// Replacing the global operator new lets every case report allocations
+// per iteration without any cooperation from the code under test.
+
+static std::atomic<uint64_t> g_allocCount{0};
+static std::atomic<uint64_t> g_allocBytes{0};
+
+void* operator new(std::size_t size) {
+    g_allocCount.fetch_add(1, std::memory_order_relaxed);
+    g_allocBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+namespace bench {
+
+std::vector<Case>& registry() {
+    static std::vector<Case> cases;
+    return cases;
+}
+
+} // namespace bench
+
+using Clock = std::chrono::steady_clock;
+
+struct Sample {
+    double seconds = 0;
+    uint64_t allocs = 0;
+    uint64_t bytes = 0;
+};
+
+struct Result {
+    const char* name;
+    size_t iterations;
+    Sample sample;
+    std::vector<std::pair<std::string, double>> extras;
+};
+
+// Where the running case's measurement starts; moved by resetTimer().
+static Clock::time_point g_start;
+static uint64_t g_startCount = 0;
+static uint64_t g_startBytes = 0;
+
+void bench::State::resetTimer() {
+    g_startCount = g_allocCount.load();
+    g_startBytes = g_allocBytes.load();
+    g_start = Clock::now();
+}
+
+static Sample run_once(const bench::Case& c, bench::State& st) {
+    Sample s;
+    st.resetTimer();
+    c.fn(st);
+    auto t1 = Clock::now();
+    s.seconds = std::chrono::duration<double>(t1 - g_start).count();
+    s.allocs = g_allocCount.load() - g_startCount;
+    s.bytes = g_allocBytes.load() - g_startBytes;
+    return s;
+}
+
+static void append_json_string(std::string& out, const std::string& s) {
+    out += '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    out += '"';
+}
+
+static void append_json_number(std::string& out, double v) {
+    char tmp[32];
+    std::snprintf(tmp, sizeof(tmp), "%.6g", v);
+    out += tmp;
+}
+
+// One object per case; field names are stable so runs from different
+// commits can be diffed (see bench/compare.py).
+static bool write_json(const char* path, const std::vector<Result>& results, double targetSeconds) {
+    char date[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+    std::string out = "{\n  \"context\": {\"date\": \"";
+    out += date;
+    out += "\", \"compiler\": ";
+#if defined(__clang__)
+    append_json_string(out, std::string("clang ") + __clang_version__);
+#elif defined(__GNUC__)
+    append_json_string(out, std::string("gcc ") + __VERSION__);
+#elif defined(_MSC_FULL_VER)
+    append_json_string(out, "MSVC " + std::to_string(_MSC_FULL_VER));
+#else
+    append_json_string(out, "unknown");
+#endif
+#ifdef NDEBUG
+    out += ", \"assertions\": false";
+#else
+    out += ", \"assertions\": true";
+#endif
+    out += ", \"target_seconds\": ";
+    append_json_number(out, targetSeconds);
+    out += "},\n  \"benchmarks\": [";
+
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        const double n = static_cast<double>(r.iterations);
+        out += i ? ",\n    {" : "\n    {";
+        out += "\"name\": ";
+        append_json_string(out, r.name);
+        out += ", \"iterations\": " + std::to_string(r.iterations);
+        out += ", \"ns_per_op\": ";
+        append_json_number(out, r.sample.seconds * 1e9 / n);
+        out += ", \"allocs_per_op\": ";
+        append_json_number(out, r.sample.allocs / n);
+        out += ", \"bytes_per_op\": ";
+        append_json_number(out, r.sample.bytes / n);
+        out += ", \"ops_per_sec\": ";
+        append_json_number(out, n / r.sample.seconds);
+        out += ", \"extras\": {";
+        for (size_t e = 0; e < r.extras.size(); ++e) {
+            if (e) out += ", ";
+            append_json_string(out, r.extras[e].first);
+            out += ": ";
+            append_json_number(out, r.extras[e].second);
+        }
+        out += "}}";
+    }
+    out += "\n  ]\n}\n";
+
+    std::FILE* f = std::fopen(path, "wb");
+    if (!f) return false;
+    const bool ok = std::fwrite(out.data(), 1, out.size(), f) == out.size();
+    return std::fclose(f) == 0 && ok;
+}
+
+// aerial_bench [filter] [--json <file>]
+int main(int argc, char* argv[]) {
+    const char* filter = nullptr;
+    const char* jsonPath = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+            jsonPath = argv[++i];
+        else
+            filter = argv[i];
+    }
+    const double targetSeconds = 0.2;
+    std::vector<Result> results;
+
+    std::printf("%-36s %12s %14s %12s %12s   %15s\n",
+                "case", "iterations", "ns/op", "allocs/op", "bytes/op", "throughput");
+
+    for (const auto& c : bench::registry()) {
+        if (filter && !std::strstr(c.name, filter))
+            continue;
+
+        // Grow the iteration count until one run takes long enough to
+        // time; the last run is the one that gets reported.
+        bench::State st;
+        Sample sample = run_once(c, st);
+        while (sample.seconds < targetSeconds && st.iterations < (size_t(1) << 30)) {
+            double scale = sample.seconds > 0 ? 1.2 * targetSeconds / sample.seconds : 100.0;
+            if (scale > 100.0) scale = 100.0;
+            if (scale < 2.0) scale = 2.0;
+            size_t iters = static_cast<size_t>(st.iterations * scale) + 1;
+            st = bench::State{};
+            st.iterations = iters;
+            sample = run_once(c, st);
+        }
+
+        double n = static_cast<double>(st.iterations);
+        std::printf("%-36s %12zu %14.1f %12.2f %12.1f   %12.0f op/s\n",
+                    c.name, st.iterations, sample.seconds * 1e9 / n,
+                    sample.allocs / n, sample.bytes / n, n / sample.seconds);
+        for (const auto& [name, value] : st.extras) {
+            std::printf("    %-32s %14.1f\n", name.c_str(), value);
+        }
+        std::fflush(stdout);
+        results.push_back({c.name, st.iterations, sample, std::move(st.extras)});
+    }
+
+    if (jsonPath && !write_json(jsonPath, results, targetSeconds)) {
+        std::fprintf(stderr, "could not write %s\n", jsonPath);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,73 @@
+// Metrics: what one update costs on the hot paths that record them — a
+// counter add, a histogram record (single thread and with four threads
+// hammering the same histogram), a full ScopedTimer round trip — and how
+// long a /metrics scrape takes to render.
+
+#include "bench.hpp"
+
+#include "Metrics.hpp"
+#include "OutBuffer.hpp"
+
+#include <thread>
+#include <vector>
+
+AERIAL_BENCH(metrics_counter_add) {
+    static Counter counter;
+    for (size_t i = 0; i < state.iterations; ++i)
+        counter.add();
+    bench::keep(counter.value());
+}
+
+AERIAL_BENCH(metrics_histogram_record) {
+    static Histogram h;
+    uint64_t v = 12345;
+    for (size_t i = 0; i < state.iterations; ++i) {
+        h.record(v);
+        v = v * 6364136223846793005ull + 1442695040888963407ull;
+        v >>= 40;  // spread over ~24 bits of nanoseconds
+    }
+    bench::keep(h.sum());
+}
+
+// Per-record cost with four threads sharing one histogram, as when stdin,
+// TCP, HTTP and the player all record at once.
+AERIAL_BENCH(metrics_histogram_record_4_threads) {
+    static Histogram h;
+    const size_t perThread = state.iterations;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([perThread, t] {
+            uint64_t v = 1000 + t;
+            for (size_t i = 0; i < perThread; ++i) {
+                h.record(v);
+                v = (v * 2862933555777941757ull + 3037000493ull) >> 42;
+            }
+        });
+    }
+    for (auto& th : threads)
+        th.join();
+    bench::keep(h.sum());
+}
+
+AERIAL_BENCH(metrics_scoped_timer) {
+    static Histogram h;
+    for (size_t i = 0; i < state.iterations; ++i) {
+        ScopedTimer timer(h);
+    }
+    bench::keep(h.count());
+}
+
+AERIAL_BENCH(metrics_scrape) {
+    Metrics& m = metrics();
+    for (uint64_t v = 1; v < 1000000000; v = v * 3 / 2 + 1) {
+        m.command(CommandSource::Tcp).record(v);
+        m.trackLoadSeconds.record(v);
+    }
+    OutBuffer out(16384);
+    for (size_t i = 0; i < state.iterations; ++i) {
+        out.clear();
+        appendPrometheus(out);
+        bench::keep(out.size());
+    }
+    state.report("bytes", static_cast<double>(out.size()));
+}
@@ -0,0 +1,119 @@
+// The up-next queue (PlayQueue) at 1M entries: building it, inserting
+// and removing at random positions, moving an entry, reading by position
+// and paging through it as GET /queue does. The *_vector cases do the
+// same edits on a std::vector<uint32_t>, the O(n) way, for comparison.
+// The 1M-entry fixtures are built on first use, outside the timed region.
+
+#include "bench.hpp"
+
+#include "PlayQueue.hpp"
+
+#include <cstdint>
+#include <vector>
+
+static const size_t kQueueEntries = 1000000;
+
+static uint64_t next_random(uint64_t& rng) {
+    rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+    return rng;
+}
+
+static PlayQueue& full_queue() {
+    static PlayQueue* queue = [] {
+        auto* q = new PlayQueue();
+        for (size_t i = 0; i < kQueueEntries; ++i)
+            q->pushBack(static_cast<uint32_t>(i));
+        return q;
+    }();
+    return *queue;
+}
+
+static std::vector<uint32_t>& full_vector() {
+    static std::vector<uint32_t>* v = [] {
+        auto* out = new std::vector<uint32_t>(kQueueEntries);
+        for (size_t i = 0; i < kQueueEntries; ++i)
+            (*out)[i] = static_cast<uint32_t>(i);
+        return out;
+    }();
+    return *v;
+}
+
+AERIAL_BENCH(queue_build_1m) {
+    for (size_t i = 0; i < state.iterations; ++i) {
+        PlayQueue q;
+        for (size_t t = 0; t < kQueueEntries; ++t)
+            q.pushBack(static_cast<uint32_t>(t));
+        bench::keep(q);
+    }
+    state.report("entries", static_cast<double>(kQueueEntries));
+}
+
+// One insert and one erase per iteration, so the size stays at 1M.
+AERIAL_BENCH(queue_insert_erase_1m) {
+    PlayQueue& q = full_queue();
+    state.resetTimer();
+    uint64_t rng = 88172645463325252ull;
+    for (size_t i = 0; i < state.iterations; ++i) {
+        q.insert(next_random(rng) % (q.size() + 1), static_cast<uint32_t>(i));
+        bench::keep(q.erase(next_random(rng) % q.size()));
+    }
+}
+
+AERIAL_BENCH(queue_insert_erase_1m_vector) {
+    std::vector<uint32_t>& v = full_vector();
+    state.resetTimer();
+    uint64_t rng = 88172645463325252ull;
+    for (size_t i = 0; i < state.iterations; ++i) {
+        v.insert(v.begin() + static_cast<ptrdiff_t>(next_random(rng) % (v.size() + 1)), static_cast<uint32_t>(i));
+        const size_t pos = next_random(rng) % v.size();
+        bench::keep(v[pos]);
+        v.erase(v.begin() + static_cast<ptrdiff_t>(pos));
+    }
+}
+
+AERIAL_BENCH(queue_move_1m) {
+    PlayQueue& q = full_queue();
+    state.resetTimer();
+    uint64_t rng = 2685821657736338717ull;
+    for (size_t i = 0; i < state.iterations; ++i)
+        q.move(next_random(rng) % q.size(), next_random(rng) % q.size());
+    bench::keep(q);
+}
+
+AERIAL_BENCH(queue_move_1m_vector) {
+    std::vector<uint32_t>& v = full_vector();
+    state.resetTimer();
+    uint64_t rng = 2685821657736338717ull;
+    for (size_t i = 0; i < state.iterations; ++i) {
+        const size_t from = next_random(rng) % v.size();
+        const size_t to = next_random(rng) % v.size();
+        const uint32_t track = v[from];
+        v.erase(v.begin() + static_cast<ptrdiff_t>(from));
+        v.insert(v.begin() + static_cast<ptrdiff_t>(to), track);
+    }
+    bench::keep(v);
+}
+
+AERIAL_BENCH(queue_at_1m) {
+    const PlayQueue& q = full_queue();
+    state.resetTimer();
+    uint64_t rng = 1181783497276652981ull;
+    uint64_t sum = 0;
+    for (size_t i = 0; i < state.iterations; ++i)
+        sum += q.at(next_random(rng) % q.size());
+    bench::keep(sum);
+}
+
+// A GET /queue page of 50 from a random offset.
+AERIAL_BENCH(queue_page_1m) {
+    const PlayQueue& q = full_queue();
+    state.resetTimer();
+    uint64_t rng = 1181783497276652981ull;
+    std::vector<uint32_t> page;
+    page.reserve(50);
+    for (size_t i = 0; i < state.iterations; ++i) {
+        page.clear();
+        q.copyRange(next_random(rng) % q.size(), 50, page);
+        bench::keep(page);
+    }
+}
@@ -0,0 +1,59 @@
+// Control-reply construction: the pre-OutBuffer ostringstream path versus
+// the per-connection buffer + cached now-playing box used by server.cpp.
+
+#include "bench.hpp"
+
+#include "OutBuffer.hpp"
+#include "Playlist.hpp"
+#include "UI.hpp"
+
+#include <sstream>
+#include <string>
+#include <string_view>
+
+static Playlist& sample_playlist() {
+    static Playlist playlist = [] {
+        Playlist p;
+        p.addTrack("/music/Artist/Album/01 - First Song.mp3");
+        p.addTrack("/music/Artist/Album/02 - Second Song.flac");
+        p.addTrack("/music/Artist/Album/03 - Third Song.ogg");
+        return p;
+    }();
+    return playlist;
+}
+
+// What handle_tcp_client used to do for every "next"/"pause"/... reply.
+static std::string legacy_reply(const Playlist& playlist, double pos) {
+    std::ostringstream reply;
+    reply << "OK pause\r\n";
+    reply << renderNowPlayingBoxPlain(playlist.current(), playlist.peekNext());
+    reply << renderProgressBar(pos);
+    return reply.str();
+}
+
+AERIAL_BENCH(reply_legacy_ostringstream) {
+    const Playlist& playlist = sample_playlist();
+    size_t total = 0;
+    for (size_t i = 0; i < state.iterations; ++i) {
+        std::string out = legacy_reply(playlist, static_cast<double>(i % 300));
+        total += out.size();
+    }
+    bench::keep(total);
+}
+
+AERIAL_BENCH(reply_outbuffer_cached_box) {
+    const Playlist& playlist = sample_playlist();
+    OutBuffer head(256);
+    OutBuffer tail(128);
+    NowPlayingCache nowPlaying;
+    size_t total = 0;
+    for (size_t i = 0; i < state.iterations; ++i) {
+        head.clear();
+        tail.clear();
+        head << "OK pause\r\n";
+        std::string_view box = nowPlaying.get(playlist);
+        appendProgressBar(tail, static_cast<double>(i % 300));
+        total += head.size() + box.size() + tail.size();
+    }
+    bench::keep(total);
+}
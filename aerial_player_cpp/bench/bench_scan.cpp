@@ -0,0 +1,67 @@
+// Folder scan: buildPlaylistFromFolder over a synthetic library tree
+// (artist / album / track, plus a cover image and a text file per album
+// that the scan must skip), created once in the system temp directory.
+
+#include "bench.hpp"
+
+#include "Library.hpp"
+#include "Playlist.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace fs = std::filesystem;
+
+static const int kArtists = 50;
+static const int kAlbums = 10;  // per artist
+static const int kTracks = 12;  // per album
+static const char* const kExtensions[] = {".mp3", ".flac", ".ogg", ".m4a"};
+
+static const std::string& library_root() {
+    static const std::string root = [] {
+        fs::path dir = fs::temp_directory_path() / "aerial_bench_scan";
+        std::error_code ec;
+        fs::remove_all(dir, ec);
+        char name[64];
+        for (int a = 0; a < kArtists; ++a) {
+            for (int b = 0; b < kAlbums; ++b) {
+                std::snprintf(name, sizeof(name), "Artist %02d/Album %02d", a, b);
+                fs::path album = dir / name;
+                fs::create_directories(album);
+                std::ofstream(album / "cover.jpg");
+                std::ofstream(album / "notes.txt");
+                for (int t = 0; t < kTracks; ++t) {
+                    std::snprintf(name, sizeof(name), "%02d - Track %d%s", t + 1, t,
+                                  kExtensions[t % 4]);
+                    std::ofstream(album / name);
+                }
+            }
+        }
+        return dir.string();
+    }();
+    return root;
+}
+
+AERIAL_BENCH(scan_folder_6k) {
+    const std::string& root = library_root();
+    size_t files = 0;
+    for (size_t i = 0; i < state.iterations; ++i) {
+        auto playlist = buildPlaylistFromFolder(root);
+        files = playlist->size();
+        bench::keep(files);
+    }
+    state.report("tracks", static_cast<double>(files));
+}
+
+AERIAL_BENCH(scan_is_audio_file) {
+    static const fs::path paths[] = {
+        "/music/Artist/Album/01 - Track.mp3", "/music/Artist/Album/02 - Track.FLAC",
+        "/music/Artist/Album/cover.jpg",      "/music/Artist/Album/notes.txt",
+    };
+    size_t hits = 0;
+    for (size_t i = 0; i < state.iterations; ++i)
+        hits += isAudioFile(paths[i % 4]) ? 1 : 0;
+    bench::keep(hits);
+}
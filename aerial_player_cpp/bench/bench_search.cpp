@@ -0,0 +1,43 @@
+// Playlist::search over 10k / 100k / 1M-track libraries, for a query
+// that matches a handful of tracks and one that matches most of them.
+// Each library is built on first use, outside the timed region.
+
+#include "bench.hpp"
+
+#include "Playlist.hpp"
+
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <string>
+
+static Playlist& library(size_t tracks) {
+    static std::map<size_t, std::unique_ptr<Playlist>> libraries;
+    auto& p = libraries[tracks];
+    if (!p) {
+        p = std::make_unique<Playlist>();
+        char buf[128];  // fits the format with every %zu at its widest
+        for (size_t i = 0; i < tracks; ++i) {
+            std::snprintf(buf, sizeof(buf), "/music/Artist %04zu/Album %03zu/%02zu - Track Title %zu.flac",
+                          i / 200, i / 20, i % 20 + 1, i);
+            p->addTrack(buf);
+        }
+    }
+    return *p;
+}
+
+static void search(bench::State& state, size_t tracks, const std::string& query) {
+    Playlist& playlist = library(tracks);
+    state.resetTimer();
+    size_t matches = 0;
+    for (size_t i = 0; i < state.iterations; ++i) {
+        matches = playlist.search(query).size();
+        bench::keep(matches);
+    }
+    state.report("matches", static_cast<double>(matches));
+}
+
+AERIAL_BENCH(search_10k_rare)   { search(state, 10000, "title 4242"); }
+AERIAL_BENCH(search_100k_rare)  { search(state, 100000, "title 4242"); }
+AERIAL_BENCH(search_1m_rare)    { search(state, 1000000, "title 4242"); }
+AERIAL_BENCH(search_1m_common)  { search(state, 1000000, "track"); }
@@ -0,0 +1,122 @@
+// Smart shuffle on a 1M-track library: building the weights from history,
+// drawing the next track (with and without a long cooldown), and folding
+// one new event into the table incrementally versus rebuilding it whole.
+
+#include "bench.hpp"
+
+#include "Playlist.hpp"
+#include "SmartShuffle.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+static const size_t kShuffleTracks = 1000000;
+
+// Deterministic, skewed history: most tracks unplayed, some played
+// through, some mostly skipped.
+static void load_history(SmartShuffle& shuffle) {
+    uint64_t rng = 88172645463325252ull;
+    for (size_t i = 0; i < shuffle.size(); ++i) {
+        rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+        const uint32_t plays = static_cast<uint32_t>(rng % 4 == 0 ? rng % 40 : 0);
+        const uint32_t skips = static_cast<uint32_t>(plays ? (rng >> 16) % (plays + 1) : 0);
+        shuffle.setHistory(i, plays, skips, 0);
+    }
+}
+
+static SmartShuffle& library_shuffle() {
+    static SmartShuffle shuffle = [] {
+        SmartShuffle s(50);
+        s.resize(kShuffleTracks);
+        load_history(s);
+        s.rebuild();
+        return s;
+    }();
+    return shuffle;
+}
+
+AERIAL_BENCH(shuffle_build_1m) {
+    for (size_t i = 0; i < state.iterations; ++i) {
+        SmartShuffle s(50);
+        s.resize(kShuffleTracks);
+        load_history(s);
+        s.rebuild();
+        bench::keep(s);
+    }
+    state.report("tracks", static_cast<double>(kShuffleTracks));
+}
+
+AERIAL_BENCH(shuffle_pick_1m) {
+    SmartShuffle& s = library_shuffle();
+    s.setCooldown(50);
+    size_t current = 0;
+    for (size_t i = 0; i < state.iterations; ++i)
+        current = s.pick(current);
+    bench::keep(current);
+}
+
+AERIAL_BENCH(shuffle_pick_1m_cooldown_100k) {
+    SmartShuffle& s = library_shuffle();
+    s.setCooldown(100000);
+    size_t current = 0;
+    for (size_t i = 0; i < state.iterations; ++i)
+        current = s.pick(current);
+    s.setCooldown(50);
+    bench::keep(current);
+}
+
+// What a play/skip costs the control thread with the block-wise table.
+AERIAL_BENCH(shuffle_record_skip_incremental_1m) {
+    SmartShuffle& s = library_shuffle();
+    uint64_t rng = 0x2545F4914F6CDD1Dull;
+    for (size_t i = 0; i < state.iterations; ++i) {
+        rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+        s.recordSkip(rng % kShuffleTracks);
+    }
+}
+
+// The same update if the whole alias table were rebuilt per event.
+AERIAL_BENCH(shuffle_record_skip_full_rebuild_1m) {
+    SmartShuffle& s = library_shuffle();
+    for (size_t i = 0; i < state.iterations; ++i)
+        s.rebuild();
+}
+
+// A 1M-track Playlist with smart shuffle on, built by the first case
+// that uses it.
+static Playlist& library_playlist(bench::State* report = nullptr) {
+    static std::unique_ptr<Playlist> playlist;
+    if (!playlist) {
+        playlist = std::make_unique<Playlist>();
+        char buf[96];
+        for (size_t i = 0; i < kShuffleTracks; ++i) {
+            std::snprintf(buf, sizeof(buf), "/music/Artist %04zu/Album %03zu/%02zu - Track.flac",
+                          i / 200, i / 20, i % 20 + 1);
+            playlist->addTrack(buf);
+        }
+        auto t0 = std::chrono::steady_clock::now();
+        playlist->enableSmartShuffle(50);
+        if (report) {
+            report->report("enable ms", std::chrono::duration<double, std::milli>(
+                                            std::chrono::steady_clock::now() - t0).count());
+        }
+    }
+    return *playlist;
+}
+
+// Enabling smart shuffle on a loaded 1M-track playlist (path index +
+// alias table).
+AERIAL_BENCH(shuffle_playlist_enable_1m) {
+    library_playlist(&state);
+}
+
+// Playlist::next() end to end in smart-shuffle mode.
+AERIAL_BENCH(shuffle_playlist_next_1m) {
+    Playlist& playlist = library_playlist();
+    size_t total = 0;
+    for (size_t i = 0; i < state.iterations; ++i)
+        total += playlist.next().size();
+    bench::keep(total);
+}
@@ -0,0 +1,307 @@
+// PlayDatabase history queries, bulk export/import and retention on a
+// synthetic history. The first case builds the database (10,000,000
+// events over 50,000 tracks, one event every 15 s up to now; set
+// AERIAL_BENCH_EVENTS to change it) and the rest time each query method
+// on it.
+
+#include "bench.hpp"
+
+#include "DB.hpp"
+
+#include <sqlite3.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <memory>
+#include <string>
+
+namespace fs = std::filesystem;
+
+using BenchClock = std::chrono::steady_clock;
+
+static const size_t kStatsTracks = 50000;
+static const int64_t kEventSpacing = 15;  // seconds between events
+
+static std::string stats_track_path(size_t track) {
+    char buf[160];  // fits the format with every %zu at its widest
+    std::snprintf(buf, sizeof(buf),
+                  "/home/user/Music/Artist %04zu/Album %03zu/%02zu - Track Title %05zu.flac",
+                  track / 200, track / 20, track % 20 + 1, track);
+    return buf;
+}
+
+// Writes tracks, events and the aggregate tables straight into the schema that
+// PlayDatabase created, then lets PlayDatabase rebuild the event indexes
+// on open (bulk load first, index once).
+static void build_stats_history(const std::string& path, size_t events) {
+    { PlayDatabase create(path, DbOptions::fromProfile("fast")); }
+
+    sqlite3* db = nullptr;
+    sqlite3_open(path.c_str(), &db);
+    sqlite3_exec(db,
+                 "PRAGMA journal_mode=WAL; PRAGMA synchronous=OFF; PRAGMA cache_size=-65536;"
+                 "DROP INDEX events_track_ts; DROP INDEX events_event_ts;"
+                 "BEGIN;",
+                 nullptr, nullptr, nullptr);
+
+    sqlite3_stmt* track = nullptr;
+    sqlite3_prepare_v2(db, "INSERT INTO tracks (id, path, title) VALUES (?, ?, ?);", -1, &track, nullptr);
+    for (size_t t = 0; t < kStatsTracks; ++t) {
+        std::string p = stats_track_path(t);
+        sqlite3_bind_int64(track, 1, static_cast<int64_t>(t + 1));
+        sqlite3_bind_text(track, 2, p.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(track, 3, p.c_str() + p.rfind('/') + 1, -1, SQLITE_TRANSIENT);
+        sqlite3_step(track);
+        sqlite3_reset(track);
+    }
+    sqlite3_finalize(track);
+
+    sqlite3_stmt* event = nullptr;
+    sqlite3_prepare_v2(db, "INSERT INTO events (track_id, event, ts) VALUES (?, ?, ?);", -1, &event, nullptr);
+    static const int kinds[] = {1, 1, 1, 2, 3};  // play, play, play, skip, finished
+    const int64_t start = static_cast<int64_t>(std::time(nullptr)) -
+                          static_cast<int64_t>(events) * kEventSpacing;
+    uint64_t rng = 88172645463325252ull;
+    for (size_t i = 0; i < events; ++i) {
+        rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+        // Skewed popularity: low track numbers are played far more often.
+        size_t t = static_cast<size_t>((rng % kStatsTracks) * ((rng >> 32) % kStatsTracks) / kStatsTracks);
+        sqlite3_bind_int64(event, 1, static_cast<int64_t>(t + 1));
+        sqlite3_bind_int(event, 2, kinds[(rng >> 20) % 5]);
+        sqlite3_bind_int64(event, 3, start + static_cast<int64_t>(i) * kEventSpacing);
+        sqlite3_step(event);
+        sqlite3_reset(event);
+    }
+    sqlite3_finalize(event);
+
+    sqlite3_exec(db,
+                 "INSERT INTO track_stats (track_id, plays, skips, finishes, last_played, score)"
+                 "  SELECT track_id, SUM(event = 1), SUM(event = 2), SUM(event = 3),"
+                 "         MAX(CASE WHEN event = 1 THEN ts END),"
+                 "         SUM(CASE event WHEN 1 THEN 3 WHEN 2 THEN -2 WHEN 3 THEN 1 ELSE 0 END)"
+                 "  FROM events GROUP BY track_id;"
+                 "INSERT INTO daily_stats (day, plays, skips, finishes)"
+                 "  SELECT ts / 86400, SUM(event = 1), SUM(event = 2), SUM(event = 3)"
+                 "  FROM events GROUP BY ts / 86400;"
+                 "COMMIT; PRAGMA wal_checkpoint(TRUNCATE);",
+                 nullptr, nullptr, nullptr);
+    sqlite3_close(db);
+}
+
+static size_t stats_event_count() {
+    const char* env = std::getenv("AERIAL_BENCH_EVENTS");
+    return env ? std::strtoull(env, nullptr, 10) : 10000000;
+}
+
+// Built once, on first use, and shared by every case below.
+static PlayDatabase& stats_db(bench::State* report = nullptr) {
+    static std::unique_ptr<PlayDatabase> db;
+    if (!db) {
+        fs::path p = fs::temp_directory_path() / "aerial_bench_stats.db";
+        for (const char* suffix : {"", "-wal", "-shm", "-journal"}) {
+            std::error_code ec;
+            fs::remove(p.string() + suffix, ec);
+        }
+
+        const size_t events = stats_event_count();
+        auto t0 = BenchClock::now();
+        build_stats_history(p.string(), events);
+        db = std::make_unique<PlayDatabase>(p.string(), DbOptions::fromProfile("fast"));
+        double secs = std::chrono::duration<double>(BenchClock::now() - t0).count();
+
+        if (report) {
+            std::error_code ec;
+            report->report("events", static_cast<double>(events));
+            report->report("build rows/s", events / secs);
+            report->report("db MiB", fs::file_size(p, ec) / (1024.0 * 1024.0));
+        }
+    }
+    return *db;
+}
+
+static StatsWindow last_days(int days) {
+    StatsWindow w;
+    w.to = static_cast<int64_t>(std::time(nullptr)) + 1;
+    w.from = w.to - static_cast<int64_t>(days) * 86400;
+    return w;
+}
+
+AERIAL_BENCH(stats_build_history) {
+    stats_db(&state);
+}
+
+AERIAL_BENCH(stats_top_played_all_time) {
+    PlayDatabase& db = stats_db();
+    std::vector<TrackCount> out;
+    for (size_t i = 0; i < state.iterations; ++i) {
+        db.topPlayed(10, StatsWindow(), out);
+        bench::keep(out);
+    }
+}
+
+AERIAL_BENCH(stats_top_played_7d) {
+    PlayDatabase& db = stats_db();
+    std::vector<TrackCount> out;
+    StatsWindow w = last_days(7);
+    for (size_t i = 0; i < state.iterations; ++i) {
+        db.topPlayed(10, w, out);
+        bench::keep(out);
+    }
+}
+
+AERIAL_BENCH(stats_most_skipped_all_time) {
+    PlayDatabase& db = stats_db();
+    std::vector<TrackCount> out;
+    for (size_t i = 0; i < state.iterations; ++i) {
+        db.mostSkipped(10, StatsWindow(), out);
+        bench::keep(out);
+    }
+}
+
+AERIAL_BENCH(stats_most_skipped_30d) {
+    PlayDatabase& db = stats_db();
+    std::vector<TrackCount> out;
+    StatsWindow w = last_days(30);
+    for (size_t i = 0; i < state.iterations; ++i) {
+        db.mostSkipped(10, w, out);
+        bench::keep(out);
+    }
+}
+
+AERIAL_BENCH(stats_recently_played_50) {
+    PlayDatabase& db = stats_db();
+    std::vector<RecentPlay> out;
+    for (size_t i = 0; i < state.iterations; ++i) {
+        db.recentlyPlayed(50, out);
+        bench::keep(out);
+    }
+}
+
+AERIAL_BENCH(stats_daily_counts_30d) {
+    PlayDatabase& db = stats_db();
+    std::vector<DayCount> out;
+    StatsWindow w = last_days(30);
+    for (size_t i = 0; i < state.iterations; ++i) {
+        db.dailyCounts(w, out);
+        bench::keep(out);
+    }
+}
+
+AERIAL_BENCH(stats_daily_counts_365d) {
+    PlayDatabase& db = stats_db();
+    std::vector<DayCount> out;
+    StatsWindow w = last_days(365);
+    for (size_t i = 0; i < state.iterations; ++i) {
+        db.dailyCounts(w, out);
+        bench::keep(out);
+    }
+}
+
+AERIAL_BENCH(stats_track_lookup) {
+    PlayDatabase& db = stats_db();
+    TrackStats st;
+    const std::string path = stats_track_path(1234);
+    for (size_t i = 0; i < state.iterations; ++i) {
+        db.getTrackStats(path, st);
+        bench::keep(st);
+    }
+}
+
+// Bulk export of the whole fixture, binary and CSV, for comparison with
+// `sqlite3 -csv` over the same JOIN.
+static void report_transfer(bench::State& state, const HistoryTransfer& t) {
+    state.report("rows", static_cast<double>(t.rows));
+    state.report("rows/s", t.rows / t.seconds);
+    state.report("file MiB", t.bytes / (1024.0 * 1024.0));
+}
+
+AERIAL_BENCH(stats_export_binary) {
+    fs::path out = fs::temp_directory_path() / "aerial_bench_history.aeh";
+    HistoryTransfer t;
+    for (size_t i = 0; i < state.iterations; ++i)
+        stats_db().exportHistory(out.string(), HistoryFormat::Binary, t);
+    report_transfer(state, t);
+}
+
+AERIAL_BENCH(stats_export_csv) {
+    fs::path out = fs::temp_directory_path() / "aerial_bench_history.csv";
+    HistoryTransfer t;
+    for (size_t i = 0; i < state.iterations; ++i)
+        stats_db().exportHistory(out.string(), HistoryFormat::Csv, t);
+    report_transfer(state, t);
+    std::error_code ec;
+    fs::remove(out, ec);
+}
+
+// Re-imports the first 1,000,000 exported events into an empty database
+// (the events indexes and aggregates are maintained as rows go in).
+AERIAL_BENCH(stats_import_binary_1m) {
+    fs::path src = fs::temp_directory_path() / "aerial_bench_import_src.db";
+    fs::path in = fs::temp_directory_path() / "aerial_bench_import.aeh";
+    fs::path dst = fs::temp_directory_path() / "aerial_bench_import.db";
+    for (const fs::path& p : {src, dst}) {
+        for (const char* suffix : {"", "-wal", "-shm", "-journal"}) {
+            std::error_code ec;
+            fs::remove(p.string() + suffix, ec);
+        }
+    }
+    build_stats_history(src.string(), 1000000);
+    HistoryTransfer t;
+    {
+        PlayDatabase db(src.string(), DbOptions::fromProfile("fast"));
+        db.exportHistory(in.string(), HistoryFormat::Binary, t);
+    }
+
+    PlayDatabase db(dst.string(), DbOptions::fromProfile("fast"));
+    db.importHistory(in.string(), t);
+    report_transfer(state, t);
+}
+
+// Retention on a year of history (2,000,000 events at 15 s spacing) with
+// a 90-day limit. While the pass runs, the bench keeps logging events and
+// records how long flush() takes, i.e. how long a writer can be held up
+// by a compaction chunk.
+AERIAL_BENCH(stats_retention_compaction) {
+    fs::path p = fs::temp_directory_path() / "aerial_bench_retention.db";
+    for (const char* suffix : {"", "-wal", "-shm", "-journal"}) {
+        std::error_code ec;
+        fs::remove(p.string() + suffix, ec);
+    }
+    const size_t events = 2000000;
+    build_stats_history(p.string(), events);
+    // Open once without retention so the event indexes are rebuilt and
+    // checkpointed into the main file before measuring.
+    { PlayDatabase rebuild(p.string(), DbOptions::fromProfile("fast")); }
+
+    std::error_code ec;
+    const double mibBefore = fs::file_size(p, ec) / (1024.0 * 1024.0);
+
+    DbOptions options = DbOptions::fromProfile("fast");
+    options.retention_days = 90;
+    options.compact_interval_s = 24 * 3600;  // only the pass started below
+    auto db = std::make_unique<PlayDatabase>(p.string(), options);
+
+    const std::string track = stats_track_path(42);
+    double worstFlushMs = 0;
+    auto t0 = BenchClock::now();
+    db->compactNow();
+    while (db->compactionStats().runs == 0) {
+        auto f0 = BenchClock::now();
+        db->logPlay(track);
+        db->flush();
+        worstFlushMs = std::max(worstFlushMs,
+                                std::chrono::duration<double, std::milli>(BenchClock::now() - f0).count());
+    }
+    const double secs = std::chrono::duration<double>(BenchClock::now() - t0).count();
+    CompactionStats cs = db->compactionStats();
+    db.reset();  // checkpoints the WAL into the main file
+    state.report("events rolled up", static_cast<double>(cs.eventsRolledUp));
+    state.report("rolled up rows/s", cs.eventsRolledUp / secs);
+    state.report("MiB reclaimed", cs.bytesReclaimed / (1024.0 * 1024.0));
+    state.report("db MiB before", mibBefore);
+    state.report("db MiB after", fs::file_size(p, ec) / (1024.0 * 1024.0));
+    state.report("worst logPlay+flush ms", worstFlushMs);
+}
@@ -0,0 +1,80 @@
+// Terminal status area: what one frame costs to build and diff, and how
+// many bytes reach the terminal, when nothing changed, when the progress
+// line ticks, on a track change, and for a full redraw. The old path
+// printed the whole box through std::cout on every command.
+
+#include "bench.hpp"
+
+#include "Playlist.hpp"
+#include "StatusArea.hpp"
+#include "UI.hpp"
+
+#include <sstream>
+#include <string>
+
+static const size_t kCols = 120;
+static const std::string kNowPath  = "/music/Artist 0001/Album 012/03 - Some Track Title.flac";
+static const std::string kNextPath = "/music/Artist 0001/Album 012/04 - Another Track Title.flac";
+static const std::string_view kNow  = Playlist::displayTitle(kNowPath);
+static const std::string_view kNext = Playlist::displayTitle(kNextPath);
+
+static StatusFrame frame_at(std::string_view now, std::string_view next, double secs) {
+    StatusFrame f;
+    f.resize(kNowPlayingRows, kCols);
+    drawNowPlaying(f, now, next, secs, false, 80);
+    return f;
+}
+
+// Builds a fresh frame from the source and diffs it against `shown`,
+// like one tick of the render thread.
+static void frames(bench::State& state, const StatusFrame& shown,
+                   std::string_view now, std::string_view next, double secs) {
+    StatusFrame next_;
+    std::string out;
+    size_t bytes = 0;
+    for (size_t i = 0; i < state.iterations; ++i) {
+        next_.resize(kNowPlayingRows, kCols);
+        drawNowPlaying(next_, now, next, secs, false, 80);
+        out.clear();
+        StatusArea::diffFrames(shown, next_, 25, out);
+        bytes = out.size();
+        bench::keep(out);
+    }
+    state.report("bytes/frame", static_cast<double>(bytes));
+}
+
+AERIAL_BENCH(status_frame_idle) {
+    frames(state, frame_at(kNow, kNext, 12.0), kNow, kNext, 12.0);
+}
+
+AERIAL_BENCH(status_frame_progress_tick) {
+    frames(state, frame_at(kNow, kNext, 12.0), kNow, kNext, 13.0);
+}
+
+AERIAL_BENCH(status_frame_track_change) {
+    frames(state, frame_at(kNow, kNext, 200.0), kNext, kNow, 0.0);
+}
+
+AERIAL_BENCH(status_frame_full_redraw) {
+    StatusFrame unknown = frame_at(kNow, kNext, 12.0);
+    unknown.markUnknown();
+    frames(state, unknown, kNow, kNext, 12.0);
+}
+
+// The previous UI: the coloured box rendered through an ostream on every
+// track change or command.
+AERIAL_BENCH(status_box_ostream_baseline) {
+    size_t bytes = 0;
+    for (size_t i = 0; i < state.iterations; ++i) {
+        std::ostringstream out;
+        const std::string line(69, '*');
+        out << line << "\n"
+            << "****    Now Playing: \033[32m" << extractTitle(kNowPath) << "\033[0m\n"
+            << "****\n"
+            << "****    Up Next:     \033[33m" << extractTitle(kNextPath) << "\033[0m\n"
+            << line << "\n";
+        bytes = out.str().size();
+        bench::keep(bytes);
+    }
+    state.report("bytes/frame", static_cast<double>(bytes));
+}
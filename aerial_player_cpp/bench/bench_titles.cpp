@@ -0,0 +1,150 @@
+// Display titles: deriving them from the path on every render (the old
+// extractTitle, via std::filesystem) versus the spans Playlist computes
+// once per track, for the plain now-playing box and for a title listing.
+
+#include "bench.hpp"
+
+#include "OutBuffer.hpp"
+#include "Playlist.hpp"
+#include "UI.hpp"
+
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <string>
+
+static const size_t kListTracks = 1000000;
+
+// extractTitle as it was before titles were precomputed.
+static std::string legacy_extract_title(const std::string& fullPath) {
+    if (fullPath.empty()) return "(none)";
+
+    std::filesystem::path p = std::filesystem::u8path(fullPath);
+    std::string name = p.filename().u8string();
+
+    size_t dot = name.rfind('.');
+    if (dot != std::string::npos)
+        name = name.substr(0, dot);
+
+    if (name.size() > 2 &&
+        std::isdigit((unsigned char)name[0]) &&
+        std::isdigit((unsigned char)name[1])) {
+        size_t pos = 2;
+        if (pos < name.size() && (name[pos] == '-' || name[pos] == '.' || name[pos] == '_'))
+            pos++;
+        if (pos < name.size() && name[pos] == ' ')
+            pos++;
+        name = name.substr(pos);
+    }
+    return name;
+}
+
+// renderNowPlayingBoxPlain before: two titles extracted, then the box.
+static std::string legacy_render_box(const std::string& nowPath, const std::string& nextPath) {
+    OutBuffer out(512);
+    std::string now  = nowPath.empty()  ? "(none)"            : legacy_extract_title(nowPath);
+    std::string next = nextPath.empty() ? "(end of playlist)" : legacy_extract_title(nextPath);
+    out.appendRepeat('*', 69);
+    out << "\r\n";
+    out << "****    Now Playing: " << now  << "\r\n";
+    out << "****\r\n";
+    out << "****    Up Next:     " << next << "\r\n";
+    out.appendRepeat('*', 69);
+    out << "\r\n";
+    return std::string(out.view());
+}
+
+static void add_tracks(Playlist& playlist, size_t tracks) {
+    char buf[128];  // fits the format with every %zu at its widest
+    for (size_t i = 0; i < tracks; ++i) {
+        std::snprintf(buf, sizeof(buf), "/music/Artist %04zu/Album %03zu/%02zu - Track Title %zu.flac",
+                      i / 200, i / 20, i % 20 + 1, i);
+        playlist.addTrack(buf);
+    }
+}
+
+static Playlist& album() {
+    static Playlist playlist = [] {
+        Playlist p;
+        add_tracks(p, 20);
+        return p;
+    }();
+    return playlist;
+}
+
+// Built by the first case that needs it (normally title_library_build_1m).
+static Playlist& library() {
+    static std::unique_ptr<Playlist> playlist;
+    if (!playlist) {
+        playlist = std::make_unique<Playlist>();
+        add_tracks(*playlist, kListTracks);
+    }
+    return *playlist;
+}
+
+// Scan-time cost: addTrack() now also derives and stores the title span.
+AERIAL_BENCH(title_library_build_1m) {
+    library();
+    state.report("tracks", static_cast<double>(kListTracks));
+}
+
+AERIAL_BENCH(title_box_legacy_extract) {
+    Playlist& playlist = album();
+    size_t total = 0;
+    for (size_t i = 0; i < state.iterations; ++i) {
+        playlist.jumpTo(i % playlist.size());
+        total += legacy_render_box(playlist.current(), playlist.peekNext()).size();
+    }
+    bench::keep(total);
+}
+
+// Same call as before, now deriving titles as views into the paths.
+AERIAL_BENCH(title_box_plain_paths) {
+    Playlist& playlist = album();
+    size_t total = 0;
+    for (size_t i = 0; i < state.iterations; ++i) {
+        playlist.jumpTo(i % playlist.size());
+        total += renderNowPlayingBoxPlain(playlist.current(), playlist.peekNext()).size();
+    }
+    bench::keep(total);
+}
+
+// What the servers and the status area do now: stored titles into a
+// reused buffer.
+AERIAL_BENCH(title_box_precomputed) {
+    Playlist& playlist = album();
+    OutBuffer out(512);
+    size_t total = 0;
+    for (size_t i = 0; i < state.iterations; ++i) {
+        playlist.jumpTo(i % playlist.size());
+        out.clear();
+        appendNowPlayingBoxTitles(out, playlist.currentTitle(), playlist.peekNextTitle());
+        total += out.size();
+    }
+    bench::keep(total);
+}
+
+// Every title of a 1M-track library, as a /tracks dump or search listing
+// walks them.
+AERIAL_BENCH(title_list_1m_legacy_extract) {
+    Playlist& playlist = library();
+    for (size_t it = 0; it < state.iterations; ++it) {
+        size_t total = 0;
+        for (size_t i = 0; i < playlist.size(); ++i)
+            total += legacy_extract_title(playlist.trackAt(i)).size();
+        bench::keep(total);
+    }
+    state.report("tracks", static_cast<double>(kListTracks));
+}
+
+AERIAL_BENCH(title_list_1m_precomputed) {
+    Playlist& playlist = library();
+    for (size_t it = 0; it < state.iterations; ++it) {
+        size_t total = 0;
+        for (size_t i = 0; i < playlist.size(); ++i)
+            total += playlist.title(i).size();
+        bench::keep(total);
+    }
+    state.report("tracks", static_cast<double>(kListTracks));
+}
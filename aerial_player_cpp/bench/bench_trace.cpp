@@ -0,0 +1,45 @@
+// Trace spans: the cost of one span on a hot path (two clock reads and a
+// ring slot), against the same loop with no span at all, and how long a
+// GET /trace of one full ring takes to render.
+
+#include "bench.hpp"
+
+#include "OutBuffer.hpp"
+#include "Trace.hpp"
+
+#include <thread>
+
+AERIAL_BENCH(trace_span_none) {
+    uint64_t total = 0;
+    for (size_t i = 0; i < state.iterations; ++i) {
+        total += i;
+        bench::keep(total);
+    }
+}
+
+AERIAL_BENCH(trace_span) {
+    uint64_t total = 0;
+    for (size_t i = 0; i < state.iterations; ++i) {
+        tracing::Span span("bench span");
+        total += i;
+        bench::keep(total);
+    }
+}
+
+// Filled from a thread of its own so the dump is one full ring, whatever
+// the other cases recorded.
+AERIAL_BENCH(trace_dump_full_ring) {
+    std::thread([] {
+        tracing::setThreadName("bench");
+        for (int i = 0; i < 4096; ++i)
+            tracing::Span span("bench dump span");
+    }).join();
+
+    OutBuffer out(1 << 20);
+    for (size_t i = 0; i < state.iterations; ++i) {
+        out.clear();
+        tracing::appendChromeJson(out);
+        bench::keep(out.size());
+    }
+    state.report("bytes", static_cast<double>(out.size()));
+}
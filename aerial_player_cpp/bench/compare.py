@@ -0,0 +1,53 @@
+#!/usr/bin/env python3
+"""Compare two aerial_bench --json runs.
+
+    aerial_bench --json base.json        # on the old commit
+    aerial_bench --json head.json        # on the new one
+    python3 bench/compare.py base.json head.json [--threshold 10]
+
+Prints ns/op and allocs/op for every case present in both runs, and
+exits 1 if any case got slower by more than the threshold (percent).
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        return {b["name"]: b for b in json.load(f)["benchmarks"]}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("base")
+    parser.add_argument("head")
+    parser.add_argument("--threshold", type=float, default=10.0,
+                        help="slowdown in percent that counts as a regression")
+    args = parser.parse_args()
+
+    base, head = load(args.base), load(args.head)
+    regressions = 0
+
+    print(f"{'case':36} {'base ns/op':>14} {'head ns/op':>14} {'change':>9} {'allocs/op':>17}")
+    for name in head:
+        if name not in base:
+            continue
+        b, h = base[name], head[name]
+        change = (h["ns_per_op"] / b["ns_per_op"] - 1.0) * 100.0 if b["ns_per_op"] else 0.0
+        allocs = f"{b['allocs_per_op']:.2f} -> {h['allocs_per_op']:.2f}"
+        flag = ""
+        if change > args.threshold:
+            flag = "  <-- slower"
+            regressions += 1
+        print(f"{name:36} {b['ns_per_op']:14.1f} {h['ns_per_op']:14.1f} {change:+8.1f}% {allocs:>17}{flag}")
+
+    only = sorted(set(base) ^ set(head))
+    if only:
+        print("\nonly in one run: " + ", ".join(only))
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,395 @@
+#include "Commands.hpp"
+#include "Player.hpp"
+#include "Playlist.hpp"
+#include "DB.hpp"
+#include "OutBuffer.hpp"
+#include "Zone.hpp"
+
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+
+std::mutex& control_mutex() {
+    static std::mutex m;
+    return m;
+}
+
+// Case-insensitive compare without building a lowered copy.
+static bool equals_nocase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(a[i])) !=
+            std::tolower(static_cast<unsigned char>(b[i])))
+            return false;
+    }
+    return true;
+}
+
+static std::string_view trim_view(std::string_view s) {
+    while (!s.empty() && std::isspace(static_cast<unsigned char>(s.front()))) s.remove_prefix(1);
+    while (!s.empty() && std::isspace(static_cast<unsigned char>(s.back())))  s.remove_suffix(1);
+    return s;
+}
+
+static bool parse_number(std::string_view s, double& out) {
+    char tmp[32];
+    if (s.empty() || s.size() >= sizeof(tmp)) return false;
+    s.copy(tmp, s.size());
+    tmp[s.size()] = '\0';
+    char* end = nullptr;
+    out = std::strtod(tmp, &end);
+    return end == tmp + s.size() && std::isfinite(out);
+}
+
+// Shared by parse_command and execute_command: IPC builds Commands
+// without parsing text.
+static bool seek_in_range(double seconds) {
+    return seconds >= 0.0 && seconds <= kMaxSeekSeconds;
+}
+
+static bool volume_in_range(double percent) {
+    return percent >= 0.0 && percent <= 100.0;
+}
+
+static bool is_index(double v) {
+    return v >= 0.0 && v < 4294967296.0 && v == static_cast<double>(static_cast<long long>(v));
+}
+
+bool parse_command(std::string_view text, Command& out) {
+    text = trim_view(text);
+
+    out.zone = 0;
+    if (!text.empty() && text.front() == '@') {
+        size_t end = text.find_first_of(" \t");
+        if (end == std::string_view::npos)
+            return false;
+        size_t zone = find_zone(text.substr(1, end - 1));
+        if (zone == kNoZone)
+            return false;
+        out.zone = static_cast<uint16_t>(zone);
+        text = trim_view(text.substr(end + 1));
+    }
+
+    std::string_view verb = text;
+    std::string_view rest;
+    size_t sp = text.find_first_of(" \t");
+    if (sp != std::string_view::npos) {
+        verb = text.substr(0, sp);
+        rest = trim_view(text.substr(sp + 1));
+    }
+
+    // indices: every argument must be a non-negative integer.
+    struct Entry { const char* name; CommandOp op; int args; bool indices; };
+    static const Entry table[] = {
+        {"play",     CommandOp::Play,        0, false},
+        {"pause",    CommandOp::Pause,       0, false},
+        {"resume",   CommandOp::Resume,      0, false},
+        {"next",     CommandOp::Next,        0, false},
+        {"prev",     CommandOp::Prev,        0, false},
+        {"previous", CommandOp::Prev,        0, false},
+        {"ff",       CommandOp::FastForward, 0, false},
+        {"rew",      CommandOp::Rewind,      0, false},
+        {"stop",     CommandOp::Stop,        0, false},
+        {"seek",     CommandOp::Seek,        1, false},
+        {"vol",      CommandOp::Volume,      1, false},
+        {"volup",    CommandOp::VolumeUp,    0, false},
+        {"voldown",  CommandOp::VolumeDown,  0, false},
+        {"mute",     CommandOp::Mute,        0, false},
+        {"jump",     CommandOp::Jump,        1, true},
+        {"queue",    CommandOp::Enqueue,     1, true},
+        {"playnext", CommandOp::PlayNext,    1, true},
+        {"qinsert",  CommandOp::QueueInsert, 2, true},
+        {"qremove",  CommandOp::QueueRemove, 1, true},
+        {"qmove",    CommandOp::QueueMove,   2, true},
+        {"qclear",   CommandOp::QueueClear,  0, false},
+    };
+
+    for (const auto& e : table) {
+        if (!equals_nocase(verb, e.name))
+            continue;
+        out.op = e.op;
+        out.arg = 0.0;
+        out.arg2 = 0.0;
+        if (e.args == 0)
+            return rest.empty();
+
+        std::string_view first = rest;
+        std::string_view second;
+        if (e.args == 2) {
+            size_t gap = rest.find_first_of(" \t");
+            if (gap == std::string_view::npos)
+                return false;
+            first = rest.substr(0, gap);
+            second = trim_view(rest.substr(gap + 1));
+            if (!parse_number(second, out.arg2))
+                return false;
+        }
+        if (!parse_number(first, out.arg))
+            return false;
+        if (e.indices && (!is_index(out.arg) || (e.args == 2 && !is_index(out.arg2))))
+            return false;
+        if (e.op == CommandOp::Seek)
+            return seek_in_range(out.arg);
+        if (e.op == CommandOp::Volume)
+            return volume_in_range(out.arg);
+        return true;
+    }
+    return false;
+}
+
+// What the zone is on, and moving it, for the two kinds of player.
+static const std::string& current_track(const Player&, const Playlist& playlist) {
+    return playlist.current();
+}
+
+static const std::string& current_track(const Zone& zone, const Playlist& playlist) {
+    return playlist.trackAt(zone.index());
+}
+
+static void jump_to(Player& player, Playlist& playlist, size_t index) {
+    playlist.jumpTo(index);
+    player.playCurrent();
+}
+
+static void jump_to(Zone& zone, Playlist&, size_t index) {
+    zone.jumpTo(index);
+}
+
+static PlayQueue& queue_of(Player&, Playlist& playlist) {
+    return playlist.queue();
+}
+
+static PlayQueue& queue_of(Zone& zone, Playlist&) {
+    return zone.queue();
+}
+
+// Queue edits; positions and track indices were checked to be integers
+// by parse_command.
+static bool run_queue_command(PlayQueue& queue, const Playlist* playlist, const Command& cmd, OutBuffer& ack) {
+    const size_t tracks = playlist ? playlist->size() : 0;
+    const size_t a = static_cast<size_t>(cmd.arg);
+    const size_t b = static_cast<size_t>(cmd.arg2);
+
+    switch (cmd.op) {
+    case CommandOp::Enqueue:
+    case CommandOp::PlayNext:
+        if (a >= tracks) {
+            ack << "ERR track index out of range";
+            return false;
+        }
+        queue.insert(cmd.op == CommandOp::PlayNext ? 0 : queue.size(), static_cast<uint32_t>(a));
+        ack << (cmd.op == CommandOp::PlayNext ? "OK playnext " : "OK queue ") << a;
+        break;
+
+    case CommandOp::QueueInsert:
+        if (a > queue.size() || b >= tracks) {
+            ack << "ERR queue position or track index out of range";
+            return false;
+        }
+        queue.insert(a, static_cast<uint32_t>(b));
+        ack << "OK qinsert " << a << ' ' << b;
+        break;
+
+    case CommandOp::QueueRemove:
+        if (a >= queue.size()) {
+            ack << "ERR queue position out of range";
+            return false;
+        }
+        ack << "OK qremove " << a << " (track " << queue.erase(a) << ')';
+        break;
+
+    case CommandOp::QueueMove:
+        if (a >= queue.size() || b >= queue.size()) {
+            ack << "ERR queue position out of range";
+            return false;
+        }
+        queue.move(a, b);
+        ack << "OK qmove " << a << ' ' << b;
+        break;
+
+    case CommandOp::QueueClear:
+        queue.clear();
+        ack << "OK qclear";
+        break;
+
+    default:
+        ack << "ERR unsupported command";
+        return false;
+    }
+    ack << " (" << queue.size() << " queued)";
+    return true;
+}
+
+template <typename P>
+static bool run_command(P& player, CommandContext& ctx, const Command& cmd, OutBuffer& ack) {
+    Playlist* playlist = ctx.playlist.get();
+    PlayDatabase* db = ctx.db;
+    const bool haveTracks = playlist && !playlist->empty();
+
+    switch (cmd.op) {
+    case CommandOp::Play:
+        player.playCurrent();
+        ack << "OK play";
+        if (db && haveTracks)
+            db->logPlay(current_track(player, *playlist));
+        return true;
+
+    case CommandOp::Pause:
+        player.pause();
+        ack << "OK pause";
+        return true;
+
+    case CommandOp::Resume:
+        player.resume();
+        ack << "OK resume";
+        return true;
+
+    case CommandOp::Next: {
+        // Capture what was playing *before* skipping
+        std::string prevTrack;
+        if (db && haveTracks)
+            prevTrack = current_track(player, *playlist);
+
+        player.playNext();
+        ack << "OK next";
+
+        if (db && haveTracks) {
+            if (!prevTrack.empty())
+                db->logSkip(prevTrack);  // moved away from this track
+            db->logPlay(current_track(player, *playlist));
+        }
+        return true;
+    }
+
+    case CommandOp::Prev:
+        player.playPrevious();
+        ack << "OK prev";
+        if (db && haveTracks)
+            db->logPlay(current_track(player, *playlist));
+        return true;
+
+    case CommandOp::FastForward:
+        player.seekBy(10.0);
+        ack << "OK ff +10s";
+        return true;
+
+    case CommandOp::Rewind:
+        player.seekBy(-10.0);
+        ack << "OK rew -10s";
+        return true;
+
+    case CommandOp::Stop:
+        player.stop();
+        ack << "OK stop";
+        return true;
+
+    case CommandOp::Seek:
+        if (!seek_in_range(cmd.arg)) {
+            ack << "ERR seek position out of range";
+            return false;
+        }
+        if (!player.seekTo(cmd.arg)) {
+            ack << "ERR seek failed";
+            return false;
+        }
+        ack << "OK seek " << static_cast<long long>(cmd.arg) << "s";
+        return true;
+
+    case CommandOp::Volume:
+        if (!volume_in_range(cmd.arg)) {
+            ack << "ERR volume out of range (0-100)";
+            return false;
+        }
+        player.setVolumePercent(static_cast<int>(cmd.arg));
+        ack << "OK vol " << player.getVolumePercent() << "%";
+        return true;
+
+    case CommandOp::VolumeUp:
+        player.changeVolumePercent(+5);
+        ack << "OK vol " << player.getVolumePercent() << "%";
+        return true;
+
+    case CommandOp::VolumeDown:
+        player.changeVolumePercent(-5);
+        ack << "OK vol " << player.getVolumePercent() << "%";
+        return true;
+
+    case CommandOp::Mute:
+        player.setVolumePercent(0);
+        ack << "OK vol 0%";
+        return true;
+
+    case CommandOp::Jump: {
+        size_t index = static_cast<size_t>(cmd.arg);
+        if (!haveTracks || index >= playlist->size()) {
+            ack << "ERR jump index out of range";
+            return false;
+        }
+        jump_to(player, *playlist, index);
+        ack << "OK jump " << index;
+        if (db)
+            db->logPlay(current_track(player, *playlist));
+        return true;
+    }
+
+    case CommandOp::Enqueue:
+    case CommandOp::PlayNext:
+    case CommandOp::QueueInsert:
+    case CommandOp::QueueRemove:
+    case CommandOp::QueueMove:
+    case CommandOp::QueueClear:
+        if (!playlist) {
+            ack << "ERR no playlist";
+            return false;
+        }
+        return run_queue_command(queue_of(player, *playlist), playlist, cmd, ack);
+    }
+
+    ack << "ERR unsupported command";
+    return false;
+}
+
+void prefetch_command(CommandContext& ctx, const Command& cmd) {
+    Zone* zone = zone_at(cmd.zone);
+    Playlist* playlist = ctx.playlist.get();
+    if (!zone || !playlist)
+        return;
+    if (cmd.op != CommandOp::Play && cmd.op != CommandOp::Next &&
+        cmd.op != CommandOp::Prev && cmd.op != CommandOp::Jump)
+        return;
+
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(control_mutex());
+        if (playlist->empty())
+            return;
+        size_t index;
+        switch (cmd.op) {
+        case CommandOp::Next: index = zone->peekNextIndex(); break;
+        case CommandOp::Prev: index = zone->peekPreviousIndex(); break;
+        case CommandOp::Jump: index = static_cast<size_t>(cmd.arg); break;
+        default:              index = zone->index(); break;
+        }
+        if (index >= playlist->size())
+            return;
+        path = playlist->trackAt(index);  // copied: a refresh may move it
+    }
+
+    const uint64_t cpuStart = thread_cpu_ns();
+    zone->prefetch(path);
+    add_zone_cpu(cmd.zone, thread_cpu_ns() - cpuStart);
+}
+
+bool execute_command(CommandContext& ctx, const Command& cmd, OutBuffer& ack) {
+    const uint64_t cpuStart = thread_cpu_ns();
+    bool ok;
+    if (Zone* zone = zone_at(cmd.zone)) {
+        ack << '@' << std::string_view(zone->name()) << ' ';
+        ok = run_command(*zone, ctx, cmd, ack);
+    } else {
+        ok = run_command(ctx.player, ctx, cmd, ack);
+    }
+    add_zone_cpu(cmd.zone, thread_cpu_ns() - cpuStart);
+    return ok;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+
+class Player;
+class Playlist;
+class PlayDatabase;
+class OutBuffer;
+
+// Playback commands shared by the TCP and HTTP front-ends.
+enum class CommandOp {
+    Play,
+    Pause,
+    Resume,
+    Next,
+    Prev,
+    FastForward,
+    Rewind,
+    Stop,
+    Seek,        // arg = absolute position in seconds, 0 to kMaxSeekSeconds
+    Volume,      // arg = 0–100
+    VolumeUp,
+    VolumeDown,
+    Mute,
+    Jump,        // arg = playlist index
+    Enqueue,     // arg = playlist index, added at the end of the queue
+    PlayNext,    // arg = playlist index, added at the front of the queue
+    QueueInsert, // arg = queue position, arg2 = playlist index
+    QueueRemove, // arg = queue position
+    QueueMove,   // arg = from, arg2 = to (queue positions)
+    QueueClear,
+};
+
+// Further than any track runs; keeps the seek ack's integer cast defined.
+constexpr double kMaxSeekSeconds = 24 * 60 * 60;
+
+struct Command {
+    CommandOp op = CommandOp::Play;
+    double    arg = 0.0;
+    double    arg2 = 0.0;
+    uint16_t  zone = 0;  // 0 = main; see Zone.hpp
+};
+
+struct CommandContext {
+    Player& player;
+    std::shared_ptr<Playlist> playlist;
+    PlayDatabase* db = nullptr;  // optional; events are logged when set
+};
+
+// Every front-end takes this before touching the player, so a batch of
+// commands runs without another client's command landing in between.
+std::mutex& control_mutex();
+
+// Parses "next", "seek 30", "vol 40", "jump 3", "qmove 5 0", ...
+// (case-insensitive), optionally addressed to a zone: "@kitchen next".
+// Returns false if the text is not a valid command, names an unknown
+// zone or has an argument out of range (nan, inf, "vol 150", "seek -5").
+bool parse_command(std::string_view text, Command& out);
+
+// Runs a parsed command and appends a one-line ack such as "OK next"
+// (no line terminator), prefixed with "@zone " for zones other than main.
+// Returns false if it could not be applied, e.g. a jump past the end of
+// the playlist. Caller holds control_mutex().
+bool execute_command(CommandContext& ctx, const Command& cmd, OutBuffer& ack);
+
+// Call before taking control_mutex() to run `cmd`. If it starts a track on
+// a zone other than main (play, next, prev, jump), that track is decoded
+// into the zone cache now, so execute_command() finds it there instead of
+// decoding under the lock. Takes the lock briefly to see which track.
+void prefetch_command(CommandContext& ctx, const Command& cmd);
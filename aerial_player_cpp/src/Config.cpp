@@ -1,11 +1,18 @@
 #include "Config.hpp"
-#include <fstream>
-#include <iostream>
+#include "Log.hpp"
+#include "Trace.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
 #include <filesystem>
+#include <climits>
 #include <cstdlib>     // for std::getenv
+#include <memory>
+#include <mutex>
+#include <thread>
 #include "json.hpp"
 
-using json = mini_json::json;
 namespace fs = std::filesystem;
 
 /*
@@ -24,35 +31,305 @@ static fs::path get_default_config_path() {
     return base / "config.json";
 }
 
+namespace {
+
+// The recognised top-level keys. Anything else is ignored, so one config
+// file can be shared with newer builds.
+struct Field {
+    const char* key;
+    std::string AerialConfig::* str;
+    int AerialConfig::* num;
+    bool AerialConfig::* flag;
+};
+
+const Field kFields[] = {
+    {"db_path",           &AerialConfig::db_path,         nullptr, nullptr},
+    {"db_profile",        &AerialConfig::db_profile,      nullptr, nullptr},
+    {"db_journal_mode",   &AerialConfig::db_journal_mode, nullptr, nullptr},
+    {"db_synchronous",    &AerialConfig::db_synchronous,  nullptr, nullptr},
+    {"db_cache_kb",       nullptr, &AerialConfig::db_cache_kb,       nullptr},
+    {"db_queue_capacity", nullptr, &AerialConfig::db_queue_capacity, nullptr},
+    {"db_batch_size",     nullptr, &AerialConfig::db_batch_size,     nullptr},
+    {"db_flush_ms",       nullptr, &AerialConfig::db_flush_ms,       nullptr},
+    {"db_overflow",       &AerialConfig::db_overflow,     nullptr, nullptr},
+    {"db_retention_days", nullptr, &AerialConfig::db_retention_days, nullptr},
+    {"shuffle",           &AerialConfig::shuffle,         nullptr, nullptr},
+    {"shuffle_cooldown",  nullptr, &AerialConfig::shuffle_cooldown,  nullptr},
+    {"log_level",         &AerialConfig::log_level,       nullptr, nullptr},
+    {"ui_fps",            nullptr, &AerialConfig::ui_fps,            nullptr},
+    {"zones",             &AerialConfig::zones,           nullptr, nullptr},
+    {"zone_cache_mb",     nullptr, &AerialConfig::zone_cache_mb,     nullptr},
+    {"port",              nullptr, &AerialConfig::port,              nullptr},
+    {"http_port",         nullptr, &AerialConfig::http_port,         nullptr},
+    {"library_cache",     &AerialConfig::library_cache,   nullptr, nullptr},
+    {"scan_recursive",    nullptr, nullptr, &AerialConfig::scan_recursive},
+    {"control_socket",    &AerialConfig::control_socket,  nullptr, nullptr},
+};
+
+// Fills an AerialConfig from the top-level object of config.json. A value
+// of the wrong type is reported and skipped; nested objects and arrays
+// are ignored.
+class ConfigHandler : public json::Handler {
+public:
+    explicit ConfigHandler(AerialConfig& cfg) : cfg_(cfg) {}
+
+    bool onBeginObject() override { field_ = nullptr; ++depth_; return true; }
+    bool onEndObject() override { --depth_; return true; }
+    bool onBeginArray() override { field_ = nullptr; return depth_++ > 0 || notRoot(); }
+    bool onEndArray() override { --depth_; return true; }
+
+    bool onKey(std::string_view key) override {
+        field_ = nullptr;
+        if (depth_ != 1) return true;
+        for (const Field& f : kFields)
+            if (key == f.key) field_ = &f;
+        return true;
+    }
+
+    bool onString(std::string_view s) override {
+        if (const Field* f = take()) {
+            if (f->str) cfg_.*(f->str) = std::string(s);
+            else mismatch(f, "a string");
+        }
+        return true;
+    }
+
+    bool onNumber(const json::Number& n) override {
+        if (const Field* f = take()) {
+            if (f->num && n.integer && n.i >= INT_MIN && n.i <= INT_MAX)
+                cfg_.*(f->num) = static_cast<int>(n.i);
+            else
+                mismatch(f, "a number");
+        }
+        return true;
+    }
+
+    bool onBool(bool b) override {
+        if (const Field* f = take()) {
+            if (f->flag) cfg_.*(f->flag) = b;
+            else mismatch(f, "true/false");
+        }
+        return true;
+    }
+
+    bool onNull() override {
+        if (const Field* f = take()) mismatch(f, "null");
+        return true;
+    }
+
+private:
+    const Field* take() {
+        const Field* f = field_;
+        field_ = nullptr;
+        return f;
+    }
+
+    bool notRoot() {
+        AERIAL_WARN("CONFIG", "config.json must be an object");
+        return false;
+    }
+
+    static void mismatch(const Field* f, const char* got) {
+        const char* want = f->str ? "a string" : f->num ? "an integer" : "true or false";
+        AERIAL_WARN("CONFIG", "Ignoring \"", f->key, "\": expected ", want, ", got ", got);
+    }
+
+    AerialConfig& cfg_;
+    const Field* field_ = nullptr;
+    int depth_ = 0;
+};
+
+} // namespace
+
+// Parses the file at `path` over `cfg`; on failure says why and leaves
+// `cfg` untouched.
+static bool read_config_file(const fs::path& path, AerialConfig& cfg) {
+    std::string text;
+    if (!json::readFile(path.string(), text)) {
+        AERIAL_WARN("CONFIG", "Could not read ", path.string());
+        return false;
+    }
+
+    // Parse into a copy so a file that breaks off halfway changes nothing.
+    AerialConfig parsed = cfg;
+    ConfigHandler handler(parsed);
+    json::Reader reader;
+    if (!reader.parse(text, handler)) {
+        AERIAL_WARN("CONFIG", "Failed to parse config.json: ", reader.error(),
+                    " at byte ", reader.offset());
+        return false;
+    }
+    cfg = std::move(parsed);
+    return true;
+}
+
 AerialConfig load_config() {
     AerialConfig cfg;  // defaults from Config.hpp
 
     fs::path path = get_default_config_path();
 
     if (!fs::exists(path)) {
-        std::cerr << "[WARN] Config file not found: "
-                  << path.string() << "\n";
-        std::cerr << "[WARN] Using built-in defaults.\n";
+        AERIAL_WARN("CONFIG", "Config file not found: ", path.string());
+        AERIAL_WARN("CONFIG", "Using built-in defaults.");
         return cfg;
     }
 
-    try {
-        json j = json::parseFile(path.string());
+    if (!read_config_file(path, cfg))
+        AERIAL_WARN("CONFIG", "Using built-in defaults.");
+    return cfg;
+}
 
-        if (j.contains("db_path")) {
-            cfg.db_path = j["db_path"].get<std::string>();
-        }
-        if (j.contains("port")) {
-            cfg.port = j["port"].get<int>();
-        }
-        if (j.contains("scan_recursive")) {
-            cfg.scan_recursive = j["scan_recursive"].get<bool>();
-        }
+// ───────────── Live snapshots ─────────────
+
+namespace {
 
-    } catch (const std::exception& e) {
-        std::cerr << "[WARN] Failed to parse config.json: " << e.what() << "\n";
-        std::cerr << "[WARN] Using built-in defaults.\n";
+struct LiveConfig {
+    LiveConfig() {
+        snapshots.push_back(std::make_unique<AerialConfig>());
+        current.store(snapshots.back().get(), std::memory_order_release);
     }
 
-    return cfg;
+    std::atomic<const AerialConfig*> current{nullptr};
+    std::atomic<uint64_t> generation{0};
+
+    std::mutex mutex;  // publishers and listeners; readers never take it
+    std::vector<std::unique_ptr<AerialConfig>> snapshots;
+    std::vector<ConfigListener> listeners;
+};
+
+} // namespace
+
+// Never destroyed: other threads may read the config during exit.
+static LiveConfig& live() {
+    static LiveConfig* l = new LiveConfig;
+    return *l;
+}
+
+const AerialConfig& config() {
+    return *live().current.load(std::memory_order_acquire);
+}
+
+uint64_t config_generation() {
+    return live().generation.load(std::memory_order_acquire);
+}
+
+void publish_config(const AerialConfig& cfg) {
+    LiveConfig& l = live();
+    std::lock_guard<std::mutex> lock(l.mutex);
+    const AerialConfig& before = *l.current.load(std::memory_order_relaxed);
+    l.snapshots.push_back(std::make_unique<AerialConfig>(cfg));
+    const AerialConfig& after = *l.snapshots.back();
+    l.current.store(&after, std::memory_order_release);
+    l.generation.fetch_add(1, std::memory_order_release);
+
+    // Under the lock, so listeners see snapshots in publication order.
+    for (const ConfigListener& listener : l.listeners)
+        listener(before, after);
+}
+
+void on_config_change(ConfigListener listener) {
+    LiveConfig& l = live();
+    std::lock_guard<std::mutex> lock(l.mutex);
+    l.listeners.push_back(std::move(listener));
+}
+
+std::vector<const char*> config_changes(const AerialConfig& before, const AerialConfig& after) {
+    std::vector<const char*> keys;
+    for (const Field& f : kFields) {
+        const bool same = f.str ? before.*(f.str) == after.*(f.str)
+                        : f.num ? before.*(f.num) == after.*(f.num)
+                                : before.*(f.flag) == after.*(f.flag);
+        if (!same) keys.push_back(f.key);
+    }
+    return keys;
+}
+
+bool reload_config() {
+    const fs::path path = get_default_config_path();
+    if (path.empty() || !fs::exists(path)) {
+        AERIAL_WARN("CONFIG", "Config file not found: ", path.string(), "; keeping current settings.");
+        return false;
+    }
+
+    // Start from the defaults, as at startup, so a key removed from the
+    // file goes back to its default.
+    AerialConfig next;
+    if (!read_config_file(path, next)) {
+        AERIAL_WARN("CONFIG", "Keeping current settings.");
+        return false;
+    }
+    if (config_changes(config(), next).empty())
+        return false;
+    publish_config(next);
+    return true;
+}
+
+static volatile std::sig_atomic_t g_reloadRequested = 0;
+
+#ifdef SIGHUP
+static void on_sighup(int) {
+    g_reloadRequested = 1;
+}
+#endif
+
+// What the watcher compares to notice an edit; editors that save by
+// renaming a new file into place change both.
+struct FileStamp {
+    fs::file_time_type mtime{};
+    uintmax_t size = 0;
+    bool exists = false;
+
+    bool operator!=(const FileStamp& o) const {
+        return exists != o.exists || mtime != o.mtime || size != o.size;
+    }
+};
+
+static FileStamp stamp_of(const fs::path& path) {
+    FileStamp s;
+    std::error_code ec;
+    s.mtime = fs::last_write_time(path, ec);
+    if (ec) return s;
+    s.size = fs::file_size(path, ec);
+    s.exists = !ec;
+    return s;
+}
+
+void watch_config(int pollMs) {
+    static std::atomic<bool> started{false};
+    if (started.exchange(true))
+        return;
+
+#ifdef SIGHUP
+    std::signal(SIGHUP, on_sighup);
+#endif
+
+    std::thread([pollMs]() {
+        tracing::setThreadName("config");
+        const fs::path path = get_default_config_path();
+        FileStamp seen = stamp_of(path);
+        const auto poll = std::chrono::milliseconds(std::max(pollMs, 100));
+        auto nextPoll = std::chrono::steady_clock::now() + poll;
+
+        // SIGHUP is checked more often than the file, so a reload asked
+        // for by hand is quick.
+        while (true) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            bool reload = false;
+            if (g_reloadRequested) {
+                g_reloadRequested = 0;
+                AERIAL_INFO("CONFIG", "SIGHUP: reloading ", path.string());
+                reload = true;
+            }
+            if (std::chrono::steady_clock::now() >= nextPoll) {
+                nextPoll += poll;
+                const FileStamp now = stamp_of(path);
+                if (now != seen) {
+                    seen = now;
+                    reload = reload || now.exists;
+                }
+            }
+            if (reload)
+                reload_config();
+        }
+    }).detach();
 }
@@ -1,10 +1,96 @@
 #pragma once
+#include <cstdint>
+#include <functional>
 #include <string>
+#include <vector>
 
 struct AerialConfig {
     std::string db_path;
-    int port = 5050;
+
+    // SQLite pragma profile: "safe", "balanced" (default) or "fast";
+    // see DbOptions::fromProfile. The db_* settings below override
+    // individual pragmas of the chosen profile when set.
+    std::string db_profile = "balanced";
+    std::string db_journal_mode;   // e.g. "WAL", "DELETE"
+    std::string db_synchronous;    // "OFF", "NORMAL", "FULL"
+    int         db_cache_kb = 0;   // 0 = profile default
+
+    // Write-behind event queue (see DbOptions); 0 / empty = defaults.
+    int         db_queue_capacity = 0;
+    int         db_batch_size = 0;
+    int         db_flush_ms = 0;
+    std::string db_overflow;       // "drop_oldest", "drop_newest", "block"
+
+    // Raw play events older than this are rolled up into per-track daily
+    // totals and deleted. 0 keeps every event forever.
+    int         db_retention_days = 0;
+
+    // "smart" draws the next track by play/skip history (SmartShuffle)
+    // instead of folder order; a track is not repeated within the last
+    // shuffle_cooldown picks.
+    std::string shuffle = "off";
+    int         shuffle_cooldown = 50;
+
+    // Console log threshold: "trace", "debug", "info", "warn", "error"
+    // or "off" (see Log.hpp).
+    std::string log_level = "info";
+
+    // Now-playing status area pinned to the bottom of the terminal,
+    // redrawn at most ui_fps times a second. 0 prints the plain box on
+    // each track change instead (as when stdout is not a terminal).
+    int ui_fps = 30;
+
+    // Paths of the last library scan, read at startup instead of scanning
+    // (the scan then runs in the background). Empty uses
+    // ~/.cache/aerial/library.txt; "off" always scans first.
+    std::string library_cache;
+
+    // Extra playback zones besides "main", comma-separated
+    // ("kitchen,patio"); each plays on its own mixer channel and is
+    // addressed as "@kitchen next" (see Zone.hpp). Decoded tracks for all
+    // of them share a cache of zone_cache_mb.
+    std::string zones;
+    int         zone_cache_mb = 256;
+
+    int port = 5050;        // TCP control server
+    int http_port = 8080;
     bool scan_recursive = true;
+
+    // Unix domain socket for the binary control protocol (aerial_ipc.h).
+    // Empty disables the listener.
+    std::string control_socket;
 };
 
 AerialConfig load_config();
+
+/*
+   Live configuration
+   -----------------------------------------
+   The settings in effect are an immutable AerialConfig snapshot behind an
+   atomic pointer. config() is a single acquire load, so any thread may
+   call it as often as it likes without a lock; a reload builds a new
+   snapshot and swaps the pointer. Retired snapshots are kept, never
+   freed: a reader may still hold a reference, and one AerialConfig per
+   reload is cheaper than tracking readers.
+
+   watch_config() re-reads the file when it changes and on SIGHUP, then
+   runs every on_config_change() listener on the watcher thread with the
+   old and the new snapshot. A file that fails to parse changes nothing.
+*/
+const AerialConfig& config();
+uint64_t config_generation();  // 1 after the first publish_config()
+
+void publish_config(const AerialConfig& cfg);
+
+// Reads the config file again and publishes it if it parsed and differs
+// from the current snapshot. Returns true if a new snapshot went out.
+bool reload_config();
+
+using ConfigListener = std::function<void(const AerialConfig& before, const AerialConfig& after)>;
+void on_config_change(ConfigListener listener);
+
+// Keys whose values differ, in config.json spelling.
+std::vector<const char*> config_changes(const AerialConfig& before, const AerialConfig& after);
+
+// Starts the watcher thread (once); polls every `pollMs`.
+void watch_config(int pollMs = 1000);
@@ -1,6 +1,12 @@
 #include "DB.hpp"
+#include "Log.hpp"
+#include "Metrics.hpp"
+#include "Trace.hpp"
 #include <sqlite3.h>
-#include <iostream>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <ctime>
 #include <filesystem>
 
 namespace fs = std::filesystem;
@@ -15,28 +21,149 @@ static std::string extractTitleFromPath(const std::string& path) {
     }
 }
 
-PlayDatabase::PlayDatabase(const std::string& path)
+static std::string toUpper(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(), ::toupper);
+    return s;
+}
+
+bool PlayDatabase::execSql(sqlite3* db, const char* sql) {
+    char* errMsg = nullptr;
+    if (sqlite3_exec(db, sql, nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        AERIAL_ERROR("DB", "SQL error: ", (errMsg ? errMsg : ""));
+        sqlite3_free(errMsg);
+        return false;
+    }
+    return true;
+}
+
+int64_t PlayDatabase::queryInt(sqlite3* db, const char* sql, int64_t fallback) {
+    sqlite3_stmt* stmt = nullptr;
+    int64_t value = fallback;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK &&
+        sqlite3_step(stmt) == SQLITE_ROW &&
+        sqlite3_column_type(stmt, 0) != SQLITE_NULL) {
+        value = sqlite3_column_int64(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    return value;
+}
+
+bool PlayDatabase::tableExists(sqlite3* db, const std::string& name) {
+    std::string sql = "SELECT 1 FROM sqlite_master WHERE type='table' AND name='" + name + "';";
+    return queryInt(db, sql.c_str(), 0) == 1;
+}
+
+// user_version history:
+//   0 — plays(track_path, track_title, event_type, created_at) only
+//   1 — + track_stats keyed by track_path
+//   2 — tracks / events / track_stats keyed by track id; plays is a view
+//   3 — + daily_stats
+static const int kSchemaVersion = 3;
+
+// Legacy rows copied per writer-thread transaction while migrating, so a
+// queued batch never waits behind more than one chunk.
+static const int kMigrateChunk = 20000;
+
+DbOptions DbOptions::fromProfile(const std::string& profile) {
+    DbOptions o;
+    if (profile == "safe") {
+        o.journal_mode = "DELETE";
+        o.synchronous  = "FULL";
+        o.cache_size_kb = 2048;
+    } else if (profile == "fast") {
+        o.journal_mode = "WAL";
+        o.synchronous  = "OFF";
+        o.cache_size_kb = 16384;
+        o.batch_size   = 1024;
+    } else if (!profile.empty() && profile != "balanced") {
+        AERIAL_WARN("DB", "Unknown db_profile '", profile, "', using 'balanced'.");
+    }
+    return o;
+}
+
+PlayDatabase::PlayDatabase(const std::string& path, const DbOptions& options)
     : db_(nullptr)
 {
-    int rc = sqlite3_open(path.c_str(), &db_);
+    // FULLMUTEX: in-memory databases share this connection between the
+    // writer thread and readers (see openReader).
+    int rc = sqlite3_open_v2(path.c_str(), &db_,
+                             SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_FULLMUTEX,
+                             nullptr);
     if (rc != SQLITE_OK) {
-        std::cerr << "[DB] Failed to open DB at " << path
-                  << " : " << sqlite3_errmsg(db_) << "\n";
+        AERIAL_ERROR("DB", "Failed to open DB at ", path, " : ", sqlite3_errmsg(db_));
         sqlite3_close(db_);
         db_ = nullptr;
         return;
     }
 
-    if (!initSchema()) {
-        std::cerr << "[DB] Failed to initialize schema.\n";
-        sqlite3_close(db_);
-        db_ = nullptr;
+    if (!applyPragmas(options) || !initSchema() || !prepareStatements() ||
+        !openReader(path)) {
+        AERIAL_ERROR("DB", "Failed to initialize schema.");
+        closeAll();
+        return;
+    }
+
+    queueCapacity_   = std::max<size_t>(options.queue_capacity, 1);
+    batchSize_       = std::clamp<size_t>(options.batch_size, 1, queueCapacity_);
+    flushIntervalMs_ = std::max(options.flush_interval_ms, 1);
+    if (options.overflow == "drop_newest") {
+        overflow_ = Overflow::DropNewest;
+    } else if (options.overflow == "block") {
+        overflow_ = Overflow::Block;
     } else {
-        std::cout << "[DB] Opened DB at " << path << "\n";
+        if (options.overflow != "drop_oldest") {
+            AERIAL_WARN("DB", "Unknown overflow policy '", options.overflow, "', using drop_oldest.");
+        }
+        overflow_ = Overflow::DropOldest;
     }
+    queue_.resize(queueCapacity_);
+
+    retentionDays_   = std::max(options.retention_days, 0);
+    compactInterval_ = std::chrono::seconds(std::max(options.compact_interval_s, 1));
+    nextCompaction_  = std::chrono::steady_clock::now();
+
+    writer_ = std::thread([this]() {
+        tracing::setThreadName("db-writer");
+        writerLoop();
+    });
+
+    AERIAL_INFO("DB", "Opened DB at ", path,
+                " (journal=", options.journal_mode,
+                ", synchronous=", options.synchronous,
+                ", batch=", batchSize_,
+                ", queue=", queueCapacity_,
+                retentionDays_ > 0 ? ", retention=" + std::to_string(retentionDays_) + "d" : std::string(),
+                ")");
 }
 
 PlayDatabase::~PlayDatabase() {
+    if (writer_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex_);
+            stopping_ = true;
+        }
+        queueCv_.notify_all();
+        drainedCv_.notify_all();
+        writer_.join();  // writer drains the queue before exiting
+    }
+
+    closeAll();
+}
+
+void PlayDatabase::closeAll() {
+    for (sqlite3_stmt** stmt : {&insertEvent_, &savepoint_, &releaseSavepoint_, &rollbackSavepoint_,
+                                &insertTrack_, &selectTrackId_,
+                                &upsertStats_, &upsertDaily_, &selectStats_, &selectTopPlays_,
+                                &selectTopSkips_, &selectTopWindow_, &selectRecent_,
+                                &selectDaily_, &selectAllStats_}) {
+        sqlite3_finalize(*stmt);
+        *stmt = nullptr;
+    }
+
+    if (readDb_) {
+        sqlite3_close(readDb_);
+        readDb_ = nullptr;
+    }
     if (db_) {
         sqlite3_close(db_);
         db_ = nullptr;
@@ -46,71 +173,523 @@ PlayDatabase::~PlayDatabase() {
 // NOTE: do NOT re-define ok() here – it's inline in DB.hpp
 // bool PlayDatabase::ok() const { ... }  // ← leave this OUT
 
-bool PlayDatabase::initSchema() {
-    if (!db_) return false;
+bool PlayDatabase::applyPragmas(const DbOptions& options) {
+    // Values are spliced into SQL, so only accept the known keywords.
+    static const char* journalModes[] = {"WAL", "DELETE", "TRUNCATE", "PERSIST", "MEMORY", "OFF"};
+    static const char* syncModes[]    = {"OFF", "NORMAL", "FULL", "EXTRA"};
 
-    const char* sql =
-        "CREATE TABLE IF NOT EXISTS plays ("
-        "  id           INTEGER PRIMARY KEY AUTOINCREMENT,"
-        "  track_path   TEXT NOT NULL,"
-        "  track_title  TEXT NOT NULL,"
-        "  event_type   TEXT NOT NULL,"  // 'play' | 'skip' | 'finished'
-        "  created_at   DATETIME DEFAULT CURRENT_TIMESTAMP"
-        ");";
+    std::string journal = toUpper(options.journal_mode);
+    std::string sync    = toUpper(options.synchronous);
+
+    if (std::find(std::begin(journalModes), std::end(journalModes), journal) == std::end(journalModes)) {
+        AERIAL_WARN("DB", "Invalid journal mode '", options.journal_mode, "', using WAL.");
+        journal = "WAL";
+    }
+    if (std::find(std::begin(syncModes), std::end(syncModes), sync) == std::end(syncModes)) {
+        AERIAL_WARN("DB", "Invalid synchronous mode '", options.synchronous, "', using NORMAL.");
+        sync = "NORMAL";
+    }
+
+    sqlite3_busy_timeout(db_, options.busy_timeout_ms);
+
+    // auto_vacuum only takes effect on a new, empty database; it lets the
+    // retention job hand freed pages back to the OS (Retention.cpp).
+    std::string sql =
+        "PRAGMA auto_vacuum=INCREMENTAL;"
+        "PRAGMA journal_mode=" + journal + ";"
+        "PRAGMA synchronous=" + sync + ";"
+        "PRAGMA cache_size=-" + std::to_string(std::max(options.cache_size_kb, 0)) + ";"
+        "PRAGMA temp_store=MEMORY;";
 
     char* errMsg = nullptr;
-    int rc = sqlite3_exec(db_, sql, nullptr, nullptr, &errMsg);
+    int rc = sqlite3_exec(db_, sql.c_str(), nullptr, nullptr, &errMsg);
     if (rc != SQLITE_OK) {
-        std::cerr << "[DB] Schema error: " << (errMsg ? errMsg : "") << "\n";
+        AERIAL_ERROR("DB", "Pragma error: ", (errMsg ? errMsg : ""));
         sqlite3_free(errMsg);
         return false;
     }
+    return true;
+}
+
+bool PlayDatabase::initSchema() {
+    if (!db_) return false;
+
+    // Events reference tracks by integer id; the path and title are
+    // stored once per track instead of on every row.
+    const char* sql =
+        "CREATE TABLE IF NOT EXISTS tracks ("
+        "  id     INTEGER PRIMARY KEY,"
+        "  path   TEXT NOT NULL UNIQUE,"
+        "  title  TEXT NOT NULL"
+        ");"
+        "CREATE TABLE IF NOT EXISTS events ("
+        "  id        INTEGER PRIMARY KEY,"
+        "  track_id  INTEGER NOT NULL REFERENCES tracks(id),"
+        "  event     INTEGER NOT NULL,"  // PlayEvent
+        "  ts        INTEGER NOT NULL"   // unix seconds, UTC
+        ");"
+        "CREATE INDEX IF NOT EXISTS events_track_ts ON events(track_id, ts);"
+        // Covers the windowed stats queries (Stats.cpp) without touching rows.
+        "CREATE INDEX IF NOT EXISTS events_event_ts ON events(event, ts, track_id);";
+
+    const int version = static_cast<int>(queryInt(db_, "PRAGMA user_version;", 0));
+    const bool legacy = version < kSchemaVersion && tableExists(db_, "plays");
+
+    if (!execSql(db_, "BEGIN;")) return false;
+
+    // An old database keeps its rows in plays_legacy; the writer thread
+    // copies them into events in the background (migrateLegacyChunk) and
+    // rebuilds track_stats as it goes. Indexes on the old table would only
+    // slow down the per-chunk deletes.
+    bool ok = !legacy ||
+              (execSql(db_, "ALTER TABLE plays RENAME TO plays_legacy;") &&
+               dropLegacyIndexes() &&
+               execSql(db_, "DROP TABLE IF EXISTS track_stats;"));
+    ok = ok && execSql(db_, sql) && initStatsSchema() &&
+         (version != 2 || backfillDailyStats());
+
+    ok = ok &&
+         sqlite3_prepare_v3(db_, "INSERT OR IGNORE INTO tracks (path, title) VALUES (?, ?);",
+                            -1, SQLITE_PREPARE_PERSISTENT, &insertTrack_, nullptr) == SQLITE_OK &&
+         sqlite3_prepare_v3(db_, "SELECT id FROM tracks WHERE path = ?;",
+                            -1, SQLITE_PREPARE_PERSISTENT, &selectTrackId_, nullptr) == SQLITE_OK &&
+         loadTrackIds();
+
+    const bool pending = ok && tableExists(db_, "plays_legacy");
+    ok = ok && createPlaysView(pending);
+
+    if (ok && version < kSchemaVersion) {
+        ok = execSql(db_, ("PRAGMA user_version = " + std::to_string(kSchemaVersion) + ";").c_str());
+    }
+
+    if (!ok || !execSql(db_, "COMMIT;")) {
+        AERIAL_ERROR("DB", "Schema error: ", sqlite3_errmsg(db_));
+        sqlite3_exec(db_, "ROLLBACK;", nullptr, nullptr, nullptr);
+        return false;
+    }
+
+    legacyPending_ = pending;
+    return true;
+}
+
+bool PlayDatabase::dropLegacyIndexes() {
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db_,
+                           "SELECT name FROM sqlite_master WHERE type = 'index' "
+                           "AND tbl_name = 'plays_legacy' AND sql IS NOT NULL;",
+                           -1, &stmt, nullptr) != SQLITE_OK)
+        return false;
+
+    std::vector<std::string> names;
+    while (sqlite3_step(stmt) == SQLITE_ROW)
+        names.emplace_back(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)));
+    sqlite3_finalize(stmt);
+
+    for (const std::string& name : names) {
+        if (!execSql(db_, ("DROP INDEX \"" + name + "\";").c_str()))
+            return false;
+    }
+    return true;
+}
+
+// Read-only compatibility view with the columns of the original plays
+// table. While a migration is in progress it also covers the rows that
+// haven't been copied yet.
+bool PlayDatabase::createPlaysView(bool withLegacy) {
+    std::string sql =
+        "DROP VIEW IF EXISTS plays;"
+        "CREATE VIEW plays AS"
+        "  SELECT e.id AS id, t.path AS track_path, t.title AS track_title,"
+        "         CASE e.event WHEN 1 THEN 'play' WHEN 2 THEN 'skip'"
+        "                      WHEN 3 THEN 'finished' END AS event_type,"
+        "         datetime(e.ts, 'unixepoch') AS created_at"
+        "  FROM events e JOIN tracks t ON t.id = e.track_id";
+    if (withLegacy) {
+        sql += " UNION ALL SELECT id, track_path, track_title, event_type, created_at"
+               " FROM plays_legacy";
+    }
+    sql += ";";
+    return execSql(db_, sql.c_str());
+}
+
+bool PlayDatabase::loadTrackIds() {
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db_, "SELECT id, path FROM tracks;", -1, &stmt, nullptr) != SQLITE_OK)
+        return false;
 
+    trackIds_.clear();
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char* path = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+        trackIds_.emplace(path ? path : "", sqlite3_column_int64(stmt, 0));
+    }
+    sqlite3_finalize(stmt);
     return true;
 }
 
-void PlayDatabase::logEvent(const std::string& trackPath,
-                            const std::string& eventType)
+// Writer thread. New tracks are inserted inside the current transaction;
+// everything else is a hash lookup. Returns -1 on error.
+int64_t PlayDatabase::trackIdFor(const std::string& trackPath, const std::string* title) {
+    auto it = trackIds_.find(trackPath);
+    if (it != trackIds_.end())
+        return it->second;
+
+    std::string derived;
+    if (!title) {
+        derived = extractTitleFromPath(trackPath);
+        title = &derived;
+    }
+    sqlite3_bind_text(insertTrack_, 1, trackPath.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(insertTrack_, 2, title->c_str(),    -1, SQLITE_STATIC);
+    int rc = sqlite3_step(insertTrack_);
+    sqlite3_reset(insertTrack_);
+
+    int64_t id = -1;
+    if (rc == SQLITE_DONE && sqlite3_changes(db_) == 1) {
+        id = sqlite3_last_insert_rowid(db_);
+    } else {
+        // Already present (added by a migration chunk) or the insert failed.
+        sqlite3_bind_text(selectTrackId_, 1, trackPath.c_str(), -1, SQLITE_STATIC);
+        if (sqlite3_step(selectTrackId_) == SQLITE_ROW)
+            id = sqlite3_column_int64(selectTrackId_, 0);
+        sqlite3_reset(selectTrackId_);
+    }
+
+    if (id < 0) {
+        AERIAL_ERROR("DB", "Failed to register track: ", sqlite3_errmsg(db_));
+        return -1;
+    }
+    trackIds_.emplace(trackPath, id);
+    return id;
+}
+
+bool PlayDatabase::prepareStatements() {
+    const char* sql =
+        "INSERT INTO events (track_id, event, ts) VALUES (?, ?, ?);";
+
+    if (sqlite3_prepare_v3(db_, sql, -1, SQLITE_PREPARE_PERSISTENT,
+                           &insertEvent_, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v3(db_, "SAVEPOINT event;", -1, SQLITE_PREPARE_PERSISTENT,
+                           &savepoint_, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v3(db_, "RELEASE event;", -1, SQLITE_PREPARE_PERSISTENT,
+                           &releaseSavepoint_, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v3(db_, "ROLLBACK TO event;", -1, SQLITE_PREPARE_PERSISTENT,
+                           &rollbackSavepoint_, nullptr) != SQLITE_OK) {
+        AERIAL_ERROR("DB", "prepare failed: ", sqlite3_errmsg(db_));
+        return false;
+    }
+    return prepareStatsStatements();
+}
+
+bool PlayDatabase::openReader(const std::string& path) {
+    // Temporary and in-memory databases aren't visible to a second
+    // connection; readers share db_ (opened FULLMUTEX) instead.
+    bool shareable = !path.empty() && path != ":memory:" &&
+                     path.compare(0, 5, "file:") != 0;
+    if (shareable) {
+        if (sqlite3_open_v2(path.c_str(), &readDb_,
+                            SQLITE_OPEN_READONLY | SQLITE_OPEN_FULLMUTEX,
+                            nullptr) != SQLITE_OK) {
+            AERIAL_ERROR("DB", "Failed to open read connection: ", sqlite3_errmsg(readDb_));
+            sqlite3_close(readDb_);
+            readDb_ = nullptr;
+        } else {
+            sqlite3_busy_timeout(readDb_, 5000);
+        }
+    }
+
+    return prepareStatsQueries(readDb_ ? readDb_ : db_);
+}
+
+// Runs on the caller's (control) thread: only touches the in-memory
+// queue, never SQLite, and holds the lock for a slot copy.
+void PlayDatabase::logEvent(const std::string& trackPath, PlayEvent event)
 {
+    AERIAL_SPAN("PlayDatabase::logEvent");
     if (!db_) return;
+    if (eventListener_)
+        eventListener_(trackPath, event);
 
-    std::string title = extractTitleFromPath(trackPath);
+    const int64_t now = static_cast<int64_t>(std::time(nullptr));
 
-    const char* sql =
-        "INSERT INTO plays (track_path, track_title, event_type) "
-        "VALUES (?, ?, ?);";
+    std::unique_lock<std::mutex> lock(queueMutex_);
+    if (stopping_) return;
 
-    sqlite3_stmt* stmt = nullptr;
-    int rc = sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK) {
-        std::cerr << "[DB] prepare failed: " << sqlite3_errmsg(db_) << "\n";
+    if (queueSize_ == queueCapacity_) {
+        switch (overflow_) {
+        case Overflow::DropNewest:
+            ++dropped_;
+            return;
+        case Overflow::DropOldest:
+            queueHead_ = (queueHead_ + 1) % queueCapacity_;
+            --queueSize_;
+            ++dropped_;
+            ++retired_;
+            break;
+        case Overflow::Block:
+            drainedCv_.wait(lock, [this] { return queueSize_ < queueCapacity_ || stopping_; });
+            if (stopping_) return;
+            break;
+        }
+    }
+
+    // Slots keep their string capacity, so steady-state enqueue doesn't allocate.
+    PendingEvent& slot = queue_[(queueHead_ + queueSize_) % queueCapacity_];
+    slot.trackPath.assign(trackPath);
+    slot.event = event;
+    slot.timestamp = now;
+    ++queueSize_;
+    ++enqueued_;
+
+    if (queueSize_ >= batchSize_) {
+        lock.unlock();
+        queueCv_.notify_one();
+    }
+}
+
+void PlayDatabase::flush() {
+    if (!writer_.joinable()) return;
+
+    std::unique_lock<std::mutex> lock(queueMutex_);
+    const uint64_t target = enqueued_;
+    flushTarget_ = std::max(flushTarget_, target);
+    queueCv_.notify_one();
+    drainedCv_.wait(lock, [&] { return retired_ >= target || stopping_; });
+}
+
+uint64_t PlayDatabase::droppedEvents() const {
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    return dropped_;
+}
+
+void PlayDatabase::runOnWriter(const std::function<void()>& job) {
+    if (!writer_.joinable()) {
+        job();
         return;
     }
 
-    sqlite3_bind_text(stmt, 1, trackPath.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 2, title.c_str(),      -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 3, eventType.c_str(),  -1, SQLITE_TRANSIENT);
+    std::unique_lock<std::mutex> lock(queueMutex_);
+    drainedCv_.wait(lock, [this] { return writerJob_ == nullptr; });  // one job at a time
+    writerJob_ = &job;
+    queueCv_.notify_one();
+    drainedCv_.wait(lock, [&] { return writerJob_ != &job; });
+}
 
-    rc = sqlite3_step(stmt);
-    if (rc != SQLITE_DONE) {
-        std::cerr << "[DB] insert failed: " << sqlite3_errmsg(db_) << "\n";
-    } else {
-        auto rowid = sqlite3_last_insert_rowid(db_);
-        std::cout << "[DB] logged event=" << eventType
-                  << " rowid=" << rowid << "\n";
+void PlayDatabase::writerLoop() {
+    std::vector<PendingEvent> batch(batchSize_);
+    uint64_t lastDropReport = 0;
+
+    std::unique_lock<std::mutex> lock(queueMutex_);
+    while (true) {
+        // Wake for a full batch, a flush request, shutdown, or the interval.
+        // While migrating or compacting, idle time goes to the next chunk
+        // instead and queued events are written without waiting for a
+        // full batch.
+        const int idleMs = (legacyPending_ || compacting_) ? 0 : flushIntervalMs_;
+        queueCv_.wait_for(lock, std::chrono::milliseconds(idleMs), [this] {
+            return stopping_ || writerJob_ || queueSize_ >= batchSize_ ||
+                   (queueSize_ > 0 && flushTarget_ > retired_);
+        });
+
+        if (writerJob_) {
+            const std::function<void()>* job = writerJob_;
+            lock.unlock();
+            (*job)();
+            lock.lock();
+            writerJob_ = nullptr;
+            drainedCv_.notify_all();
+            continue;
+        }
+
+        if (queueSize_ == 0) {
+            if (stopping_) break;
+            lock.unlock();
+            runBackgroundStep();
+            lock.lock();
+            continue;
+        }
+
+        // Swap slots out so both sides keep their string buffers.
+        size_t n = std::min(queueSize_, batchSize_);
+        for (size_t i = 0; i < n; ++i) {
+            PendingEvent& slot = queue_[(queueHead_ + i) % queueCapacity_];
+            batch[i].trackPath.swap(slot.trackPath);
+            batch[i].event = slot.event;
+            batch[i].timestamp = slot.timestamp;
+        }
+        queueHead_ = (queueHead_ + n) % queueCapacity_;
+        queueSize_ -= n;
+        uint64_t dropped = dropped_;
+
+        lock.unlock();
+        drainedCv_.notify_all();  // space freed for blocked producers
+
+        if (dropped != lastDropReport) {
+            AERIAL_WARN("DB", "Event queue overflowed; ", (dropped - lastDropReport),
+                        " event(s) dropped");
+            lastDropReport = dropped;
+        }
+
+        batch.resize(n);
+        writeBatch(batch);
+        batch.resize(batchSize_);
+
+        lock.lock();
+        retired_ += n;
+        drainedCv_.notify_all();  // batch committed for flush()
+
+        // A steady stream of events would otherwise keep the queue from
+        // ever running empty; interleave one background chunk per batch so
+        // a migration or retention pass still makes progress.
+        lock.unlock();
+        runBackgroundStep();
+        lock.lock();
     }
+}
 
-    sqlite3_finalize(stmt);
+// Runs a prepared statement that returns no rows; false if it failed.
+static bool step_done(sqlite3_stmt* stmt) {
+    const int rc = sqlite3_step(stmt);
+    sqlite3_reset(stmt);
+    return rc == SQLITE_DONE;
+}
+
+void PlayDatabase::writeBatch(std::vector<PendingEvent>& batch) {
+    AERIAL_SPAN("PlayDatabase::writeBatch");
+    ScopedTimer timer(metrics().dbBatchSeconds);
+
+    // Each event and its stats go in together or not at all, so
+    // track_stats never disagrees with events. The whole batch is tried
+    // first; if any event fails, it is rolled back and written again with
+    // a savepoint per event, which drops only the events that fail.
+    uint64_t written = 0;
+    BatchResult result = writeEvents(batch, false, written);
+    if (result == BatchResult::EventFailed) {
+        AERIAL_WARN("DB", "Retrying batch of ", batch.size(), " event(s) one by one");
+        result = writeEvents(batch, true, written);
+    }
+    if (result == BatchResult::Written)
+        metrics().dbEventsWritten.add(written);
+}
+
+// One transaction over `batch`. With isolate, each event runs in its own
+// savepoint and a failing one is rolled back alone; without, the first
+// failure rolls back the whole transaction.
+PlayDatabase::BatchResult PlayDatabase::writeEvents(const std::vector<PendingEvent>& batch,
+                                                    bool isolate, uint64_t& written) {
+    written = 0;
+    if (!execSql(db_, "BEGIN;")) {
+        AERIAL_ERROR("DB", "batch of ", batch.size(), " event(s) not written");
+        return BatchResult::Failed;
+    }
+
+    for (const PendingEvent& ev : batch) {
+        const int64_t trackId = trackIdFor(ev.trackPath);
+        if (trackId < 0) continue;
+
+        if (isolate && !step_done(savepoint_)) {
+            AERIAL_ERROR("DB", "savepoint failed: ", sqlite3_errmsg(db_));
+            continue;
+        }
+
+        sqlite3_bind_int64(insertEvent_, 1, trackId);
+        sqlite3_bind_int(insertEvent_,   2, static_cast<int>(ev.event));
+        sqlite3_bind_int64(insertEvent_, 3, ev.timestamp);
+
+        bool ok = step_done(insertEvent_);
+        if (!ok)
+            AERIAL_ERROR("DB", "insert failed: ", sqlite3_errmsg(db_));
+        ok = ok && applyStatsDelta(trackId, ev);
+
+        if (!isolate && !ok) {
+            sqlite3_exec(db_, "ROLLBACK;", nullptr, nullptr, nullptr);
+            loadTrackIds();  // tracks registered in this transaction are gone again
+            return BatchResult::EventFailed;
+        }
+        if (ok)
+            ++written;
+        else
+            step_done(rollbackSavepoint_);
+        if (isolate)
+            step_done(releaseSavepoint_);
+    }
+
+    if (sqlite3_exec(db_, "COMMIT;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        AERIAL_ERROR("DB", "commit failed: ", sqlite3_errmsg(db_));
+        sqlite3_exec(db_, "ROLLBACK;", nullptr, nullptr, nullptr);
+        // Tracks registered in this transaction are gone again.
+        loadTrackIds();
+        return BatchResult::Failed;
+    }
+    return BatchResult::Written;
+}
+
+// Writer thread: moves the next kMigrateChunk rows of plays_legacy into
+// events in one transaction. Rows are deleted as they are copied, so an
+// interrupted migration resumes where it stopped on the next start.
+bool PlayDatabase::migrateLegacyChunk() {
+    if (legacyCopied_ == 0)
+        legacyStarted_ = std::chrono::steady_clock::now();
+
+    const int64_t lastId = queryInt(db_,
+        ("SELECT MAX(id) FROM (SELECT id FROM plays_legacy ORDER BY id LIMIT " +
+         std::to_string(kMigrateChunk) + ");").c_str(), -1);
+    const std::string bound = std::to_string(lastId);
+
+    bool ok = execSql(db_, "BEGIN;");
+    if (ok && lastId < 0) {
+        // Nothing left: the view no longer needs the legacy table.
+        ok = createPlaysView(false) &&
+             execSql(db_, "DROP TABLE plays_legacy;") &&
+             execSql(db_, "COMMIT;");
+        if (ok) {
+            double secs = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - legacyStarted_).count();
+            int64_t freeKb = queryInt(db_, "PRAGMA freelist_count;", 0) *
+                             queryInt(db_, "PRAGMA page_size;", 0) / 1024;
+            AERIAL_INFO("DB", "Migrated ", legacyCopied_, " legacy events in ", secs, " s (",
+                        static_cast<int64_t>(secs > 0 ? legacyCopied_ / secs : 0), " rows/s); ",
+                        freeKb, " KiB free, reclaimable with VACUUM");
+            legacyPending_ = false;
+            return true;
+        }
+    } else if (ok) {
+        std::string sql =
+            "INSERT OR IGNORE INTO tracks (path, title)"
+            "  SELECT track_path, COALESCE(MAX(track_title), track_path) FROM plays_legacy"
+            "  WHERE id <= " + bound + " GROUP BY track_path;"
+            "INSERT INTO events (track_id, event, ts)"
+            "  SELECT t.id,"
+            "         CASE p.event_type WHEN 'play' THEN 1 WHEN 'skip' THEN 2"
+            "                           WHEN 'finished' THEN 3 ELSE 0 END,"
+            "         COALESCE(CAST(strftime('%s', p.created_at) AS INTEGER), 0)"
+            "  FROM plays_legacy p JOIN tracks t ON t.path = p.track_path"
+            "  WHERE p.id <= " + bound + " ORDER BY p.id;";
+        ok = execSql(db_, sql.c_str()) && migrateLegacyStats(lastId) &&
+             execSql(db_, ("DELETE FROM plays_legacy WHERE id <= " + bound + ";").c_str());
+        const int64_t n = ok ? sqlite3_changes(db_) : 0;
+        ok = ok && execSql(db_, "COMMIT;");
+        if (ok) {
+            legacyCopied_ += n;
+            return true;
+        }
+    }
+
+    // Leave the remainder for the next start rather than retrying in a loop.
+    sqlite3_exec(db_, "ROLLBACK;", nullptr, nullptr, nullptr);
+    loadTrackIds();
+    AERIAL_WARN("DB", "Legacy migration paused: ", sqlite3_errmsg(db_));
+    legacyPending_ = false;
+    return false;
 }
 
 void PlayDatabase::logPlay(const std::string& trackPath) {
-    logEvent(trackPath, "play");
+    logEvent(trackPath, PlayEvent::Play);
 }
 
 void PlayDatabase::logSkip(const std::string& trackPath) {
-    logEvent(trackPath, "skip");
+    logEvent(trackPath, PlayEvent::Skip);
 }
 
 void PlayDatabase::logFinished(const std::string& trackPath) {
-    logEvent(trackPath, "finished");
+    logEvent(trackPath, PlayEvent::Finished);
 }
@@ -1,25 +1,316 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
-struct sqlite3;  // forward declaration
+struct sqlite3;       // forward declaration
+struct sqlite3_stmt;
+
+// SQLite tuning applied when the database is opened.
+struct DbOptions {
+    std::string journal_mode  = "WAL";     // WAL | DELETE | TRUNCATE | PERSIST | MEMORY | OFF
+    std::string synchronous   = "NORMAL";  // OFF | NORMAL | FULL | EXTRA
+    int         cache_size_kb = 8192;
+    int         busy_timeout_ms = 5000;
+
+    // Write-behind queue: events are committed by a writer thread in
+    // batches of up to batch_size, or every flush_interval_ms, whichever
+    // comes first.
+    size_t      queue_capacity    = 4096;
+    size_t      batch_size        = 256;
+    int         flush_interval_ms = 250;
+
+    // What logPlay/logSkip do when the queue is full:
+    //   "drop_oldest" — evict the oldest queued event (default)
+    //   "drop_newest" — discard the new event
+    //   "block"       — wait for the writer (the only mode that can stall
+    //                   the caller on disk I/O)
+    std::string overflow = "drop_oldest";
+
+    // Retention: raw events older than retention_days are rolled up into
+    // track_daily and deleted by the writer thread, in small transactions
+    // while it is idle, once per compact_interval_s. 0 = keep everything.
+    int         retention_days     = 0;
+    int         compact_interval_s = 3600;
+
+    // "safe"     — rollback journal, FULL sync (SQLite defaults)
+    // "balanced" — WAL, NORMAL sync: durable across app crashes, at most
+    //              the last few events lost on power failure (default)
+    // "fast"     — WAL, sync OFF: for throwaway or bench databases
+    static DbOptions fromProfile(const std::string& profile);
+};
+
+// Stored in events.event. The `plays` view maps these back to the
+// 'play' / 'skip' / 'finished' strings of the original schema.
+enum class PlayEvent : uint8_t {
+    Play     = 1,
+    Skip     = 2,
+    Finished = 3,
+};
+
+// Running totals for one track, maintained by PlayDatabase in the same
+// transaction as the raw event rows (see Stats.cpp).
+struct TrackStats {
+    int64_t     plays = 0;
+    int64_t     skips = 0;
+    int64_t     finishes = 0;
+    std::string lastPlayed;   // "YYYY-MM-DD HH:MM:SS" UTC, empty if never
+    double      score = 0.0;
+};
+
+// Half-open time range [from, to) in unix seconds for the stats queries.
+// The default covers the whole history.
+struct StatsWindow {
+    int64_t from = 0;
+    int64_t to   = INT64_MAX;
+    bool all() const { return from <= 0 && to == INT64_MAX; }
+};
+
+struct TrackCount {
+    std::string path;
+    std::string title;
+    int64_t     count = 0;
+};
+
+struct RecentPlay {
+    std::string path;
+    std::string title;
+    int64_t     timestamp = 0;  // unix seconds
+};
+
+// Totals from the retention job since the database was opened.
+struct CompactionStats {
+    uint64_t runs = 0;            // completed passes
+    uint64_t eventsRolledUp = 0;  // raw rows folded into track_daily
+    uint64_t bytesReclaimed = 0;  // returned to the OS by incremental vacuum
+};
+
+// Event totals for one UTC day.
+struct DayCount {
+    int64_t day = 0;  // unix seconds at 00:00 UTC
+    int64_t plays = 0;
+    int64_t skips = 0;
+    int64_t finishes = 0;
+};
+
+// Files written by PlayDatabase::exportHistory: compact columnar binary
+// (see History.cpp) or CSV.
+enum class HistoryFormat {
+    Binary,
+    Csv,
+};
+
+// What an export/import moved, for the rows/s report.
+struct HistoryTransfer {
+    uint64_t rows = 0;      // events
+    uint64_t tracks = 0;    // export: written; import: new to this database
+    uint64_t skipped = 0;   // import: malformed rows
+    uint64_t bytes = 0;     // file size
+    double   seconds = 0.0;
+};
 
 class PlayDatabase {
 public:
-    explicit PlayDatabase(const std::string& path);
+    explicit PlayDatabase(const std::string& path,
+                          const DbOptions& options = DbOptions());
     ~PlayDatabase();
 
+    PlayDatabase(const PlayDatabase&) = delete;
+    PlayDatabase& operator=(const PlayDatabase&) = delete;
+
     // quick check if DB is usable
     bool ok() const { return db_ != nullptr; }
 
+    // These only enqueue; the insert happens on the writer thread.
     void logPlay(const std::string& trackPath);
     void logSkip(const std::string& trackPath);
     void logFinished(const std::string& trackPath);
 
+    // Called synchronously by logPlay/logSkip/logFinished on the logging
+    // thread, before the event is queued (e.g. to update smart-shuffle
+    // weights). Set it before events are logged; keep it cheap.
+    using EventListener = std::function<void(const std::string& trackPath, PlayEvent event)>;
+    void setEventListener(EventListener listener) { eventListener_ = std::move(listener); }
+
+    // Blocks until every event queued so far has been committed.
+    void flush();
+
+    // Events discarded because the queue was full.
+    uint64_t droppedEvents() const;
+
+    // True while rows from a pre-normalization `plays` table are still
+    // being copied into `events` (done by the writer thread in small
+    // transactions between batches). Until then getTrackStats() only
+    // counts the part of the old history copied so far.
+    bool migrating() const { return legacyPending_.load(std::memory_order_relaxed); }
+
+    // Starts a retention pass as soon as the writer is idle instead of at
+    // the next interval. No-op when retention_days is 0.
+    void compactNow();
+    CompactionStats compactionStats() const;
+
+    // Aggregates for one track: a primary-key lookup, independent of how
+    // much history exists. Reflects events up to the last committed batch
+    // (call flush() first for read-your-writes). Returns false if the
+    // track has no recorded events.
+    bool getTrackStats(const std::string& trackPath, TrackStats& out);
+
+    // History queries (Stats.cpp). Each one is served from an index: the
+    // all-time rankings read track_stats, windowed ones range-scan
+    // events(event, ts, track_id), daily counts read daily_stats (whole
+    // UTC days overlapping the window). Same visibility as getTrackStats().
+    // Return false on a database error.
+    bool topPlayed(size_t limit, const StatsWindow& window, std::vector<TrackCount>& out);
+    bool mostSkipped(size_t limit, const StatsWindow& window, std::vector<TrackCount>& out);
+    bool recentlyPlayed(size_t limit, std::vector<RecentPlay>& out);
+    bool dailyCounts(const StatsWindow& window, std::vector<DayCount>& out);
+
+    // Bulk history transfer (History.cpp). Export writes every raw event
+    // from one read transaction, in id order; days already rolled up by
+    // retention are not included. Import detects the format, appends the
+    // events (it does not deduplicate) in batched transactions on the
+    // writer thread and folds them into the aggregates; batches committed
+    // before an error are kept. Both return false on I/O or DB errors.
+    bool exportHistory(const std::string& file, HistoryFormat format, HistoryTransfer& out);
+    bool importHistory(const std::string& file, HistoryTransfer& out);
+
+    // Calls fn for every track with recorded events (one scan of
+    // track_stats; lastPlayed is left empty). Returns false on error.
+    bool forEachTrackStats(const std::function<void(const std::string& path,
+                                                    const TrackStats& stats)>& fn);
+
 private:
+    enum class Overflow { DropOldest, DropNewest, Block };
+
+    struct PendingEvent {
+        std::string trackPath;
+        PlayEvent   event;
+        int64_t     timestamp;  // unix seconds, taken when queued
+    };
+
+    // Small SQL helpers shared by DB.cpp and Retention.cpp; execSql logs
+    // errors.
+    static bool execSql(sqlite3* db, const char* sql);
+    static int64_t queryInt(sqlite3* db, const char* sql, int64_t fallback);
+    static bool tableExists(sqlite3* db, const std::string& name);
+
+    bool applyPragmas(const DbOptions& options);
     bool initSchema();
-    void logEvent(const std::string& trackPath,
-                  const std::string& eventType);
+    bool prepareStatements();
+    bool openReader(const std::string& path);
+    void closeAll();
+
+    // tracks table: path -> id, cached in trackIds_ (writer thread only)
+    bool loadTrackIds();
+    // `title` is stored for a new track; derived from the path when null.
+    int64_t trackIdFor(const std::string& trackPath, const std::string* title = nullptr);
+
+    // Schema migration from a database written before `tracks`/`events`
+    bool dropLegacyIndexes();
+    bool createPlaysView(bool withLegacy);
+    bool migrateLegacyChunk();
+
+    // Retention.cpp (writer thread)
+    void runBackgroundStep();
+    void beginCompaction();
+    bool compactChunk();
+    void finishCompaction();
+
+    // Stats.cpp
+    bool initStatsSchema();
+    bool backfillDailyStats();
+    bool migrateLegacyStats(int64_t lastId);
+    bool foldEventStats(int64_t afterId, int64_t lastId);
+    bool prepareStatsStatements();
+    bool prepareStatsQueries(sqlite3* conn);
+    bool rankTracks(sqlite3_stmt* allTime, PlayEvent event, size_t limit,
+                    const StatsWindow& window, std::vector<TrackCount>& out);
+    bool applyStatsDelta(int64_t trackId, const PendingEvent& ev);
+    void logEvent(const std::string& trackPath, PlayEvent event);
+
+    // History.cpp (importRows runs on the writer thread)
+    bool importRows(std::FILE* file, HistoryTransfer& out);
+
+    // Runs job on the writer thread between batches and waits for it, for
+    // bulk work that needs db_ to itself.
+    void runOnWriter(const std::function<void()>& job);
+
+    void writerLoop();
+    void writeBatch(std::vector<PendingEvent>& batch);
+    enum class BatchResult { Written, EventFailed, Failed };
+    BatchResult writeEvents(const std::vector<PendingEvent>& batch, bool isolate, uint64_t& written);
 
     sqlite3* db_ = nullptr;
+
+    // Prepared once in the constructor, reset and re-bound per event.
+    // Only the writer thread touches the connection after construction.
+    sqlite3_stmt* insertEvent_ = nullptr;
+    sqlite3_stmt* savepoint_ = nullptr;          // per event, when a batch is retried
+    sqlite3_stmt* releaseSavepoint_ = nullptr;
+    sqlite3_stmt* rollbackSavepoint_ = nullptr;
+    sqlite3_stmt* insertTrack_ = nullptr;
+    sqlite3_stmt* selectTrackId_ = nullptr;
+    sqlite3_stmt* upsertStats_ = nullptr;
+    sqlite3_stmt* upsertDaily_ = nullptr;
+
+    std::unordered_map<std::string, int64_t> trackIds_;
+    std::atomic<bool> legacyPending_{false};
+
+    // Retention state; everything but the atomics is writer-thread only.
+    int     retentionDays_ = 0;
+    std::chrono::seconds compactInterval_{3600};
+    std::chrono::steady_clock::time_point nextCompaction_;
+    bool    compacting_ = false;
+    int64_t compactCutoff_ = 0;       // unix seconds, start of a UTC day
+    int64_t compactPagesBefore_ = 0;
+    uint64_t compactRolled_ = 0;      // this pass
+    std::atomic<bool>     compactRequested_{false};
+    std::atomic<uint64_t> compactRuns_{0};
+    std::atomic<uint64_t> compactEventsTotal_{0};
+    std::atomic<uint64_t> compactBytesTotal_{0};
+    int64_t legacyCopied_ = 0;
+    std::chrono::steady_clock::time_point legacyStarted_;
+
+    // Read side: a second connection (WAL lets it read while the writer
+    // commits) shared by query methods under readMutex_. Falls back to
+    // db_ for in-memory/temporary databases.
+    std::mutex    readMutex_;
+    sqlite3*      readDb_ = nullptr;
+    sqlite3_stmt* selectStats_ = nullptr;
+    sqlite3_stmt* selectTopPlays_ = nullptr;
+    sqlite3_stmt* selectTopSkips_ = nullptr;
+    sqlite3_stmt* selectTopWindow_ = nullptr;
+    sqlite3_stmt* selectRecent_ = nullptr;
+    sqlite3_stmt* selectDaily_ = nullptr;
+    sqlite3_stmt* selectAllStats_ = nullptr;
+
+    // Write-behind queue (ring buffer of queueCapacity_ slots)
+    mutable std::mutex      queueMutex_;
+    std::condition_variable queueCv_;     // writer: work available / stop
+    std::condition_variable drainedCv_;   // producers: space freed / batch committed
+    std::vector<PendingEvent> queue_;
+    size_t   queueHead_ = 0;
+    size_t   queueSize_ = 0;
+    size_t   queueCapacity_ = 0;
+    size_t   batchSize_ = 0;
+    int      flushIntervalMs_ = 0;
+    Overflow overflow_ = Overflow::DropOldest;
+    uint64_t enqueued_ = 0;     // events accepted into the queue
+    uint64_t retired_ = 0;      // of those, written by the writer or evicted
+    uint64_t flushTarget_ = 0;  // flush() waits for retired_ to reach this
+    uint64_t dropped_ = 0;
+    bool     stopping_ = false;
+    EventListener eventListener_;
+    const std::function<void()>* writerJob_ = nullptr;  // see runOnWriter
+    std::thread writer_;
 };
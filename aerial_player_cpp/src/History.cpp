@@ -0,0 +1,491 @@
+#include "DB.hpp"
+#include "Log.hpp"
+#include <sqlite3.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+
+/*
+ * Bulk export/import of the play history for PlayDatabase.
+ *
+ * Binary format (integers are LEB128 varints unless noted):
+ *
+ *   "AERHIST" 0x01               magic, last byte = format version
+ *   track count, then per track: id, path length, path, title length, title
+ *   blocks of up to kTransferChunk events, one column after another:
+ *     row count n                (0 ends the file)
+ *     n track ids
+ *     n event codes              (1 byte each, PlayEvent)
+ *     n timestamps               (zigzag delta from the previous row)
+ *
+ * Rows are in events.id order, so timestamp deltas stay small and an
+ * event takes ~4 bytes. CSV is "ts,event,path,title": unix seconds,
+ * play/skip/finished, RFC 4180 quoting.
+ */
+
+static const size_t kTransferChunk = 65536;  // rows per read / binary block
+static const size_t kImportBatch   = 250000; // rows per import transaction
+static const size_t kIoBuffer      = 1 << 20;
+static const int    kImportCacheKb = 256 * 1024;  // page cache while importing
+
+static const char kHistoryMagic[8] = {'A', 'E', 'R', 'H', 'I', 'S', 'T', '\x01'};
+
+// ───────────── Encoding helpers ─────────────
+
+static void put_varint(std::string& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<char>((v & 0x7F) | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+static void put_bytes(std::string& out, const void* data, size_t n) {
+    put_varint(out, n);
+    out.append(static_cast<const char*>(data), n);
+}
+
+static uint64_t zigzag(int64_t v) {
+    return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+static int64_t unzigzag(uint64_t v) {
+    return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+static void put_csv_field(std::string& out, std::string_view s) {
+    if (s.find_first_of(",\"\r\n") == std::string_view::npos) {
+        out.append(s);
+        return;
+    }
+    out.push_back('"');
+    for (char c : s) {
+        if (c == '"') out.push_back('"');
+        out.push_back(c);
+    }
+    out.push_back('"');
+}
+
+static const char* event_name(int code) {
+    switch (static_cast<PlayEvent>(code)) {
+    case PlayEvent::Play:     return "play";
+    case PlayEvent::Skip:     return "skip";
+    case PlayEvent::Finished: return "finished";
+    }
+    return "unknown";
+}
+
+// 0 if `name` is not an event.
+static int event_code(std::string_view name) {
+    if (name == "play")     return static_cast<int>(PlayEvent::Play);
+    if (name == "skip")     return static_cast<int>(PlayEvent::Skip);
+    if (name == "finished") return static_cast<int>(PlayEvent::Finished);
+    return 0;
+}
+
+static bool valid_event(uint64_t code) {
+    return code >= static_cast<uint64_t>(PlayEvent::Play) &&
+           code <= static_cast<uint64_t>(PlayEvent::Finished);
+}
+
+// Appends `buf` to the file and empties it.
+static bool drain(std::FILE* f, std::string& buf, uint64_t& bytes) {
+    if (buf.empty()) return true;
+    if (std::fwrite(buf.data(), 1, buf.size(), f) != buf.size()) return false;
+    bytes += buf.size();
+    buf.clear();
+    return true;
+}
+
+// Buffered reader over a FILE* for the import side.
+class HistoryReader {
+public:
+    explicit HistoryReader(std::FILE* f) : f_(f), buf_(kIoBuffer) {}
+
+    bool get(char& c) {
+        if (pos_ == len_ && !fill()) return false;
+        c = buf_[pos_++];
+        return true;
+    }
+
+    bool peek(char& c) {
+        if (pos_ == len_ && !fill()) return false;
+        c = buf_[pos_];
+        return true;
+    }
+
+    bool read(void* out, size_t n) {
+        char* dst = static_cast<char*>(out);
+        while (n > 0) {
+            if (pos_ == len_ && !fill()) return false;
+            size_t take = std::min(n, len_ - pos_);
+            std::memcpy(dst, &buf_[pos_], take);
+            pos_ += take;
+            dst += take;
+            n -= take;
+        }
+        return true;
+    }
+
+    bool varint(uint64_t& v) {
+        v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            char c;
+            if (!get(c)) return false;
+            v |= static_cast<uint64_t>(static_cast<unsigned char>(c) & 0x7F) << shift;
+            if (!(static_cast<unsigned char>(c) & 0x80)) return true;
+        }
+        return false;
+    }
+
+    bool string(std::string& s) {
+        uint64_t n;
+        if (!varint(n) || n > (1u << 20)) return false;
+        s.resize(static_cast<size_t>(n));
+        return read(&s[0], s.size());
+    }
+
+    // One CSV record into `fields`; false at end of file.
+    bool csvRecord(std::vector<std::string>& fields) {
+        fields.assign(1, std::string());
+        char c;
+        if (!peek(c)) return false;
+        bool quoted = false;
+        while (get(c)) {
+            if (quoted) {
+                if (c != '"') {
+                    fields.back().push_back(c);
+                } else if (peek(c) && c == '"') {
+                    get(c);
+                    fields.back().push_back('"');
+                } else {
+                    quoted = false;
+                }
+            } else if (c == '"') {
+                quoted = true;
+            } else if (c == ',') {
+                fields.emplace_back();
+            } else if (c == '\n') {
+                break;
+            } else if (c != '\r') {
+                fields.back().push_back(c);
+            }
+        }
+        return true;
+    }
+
+    uint64_t consumed() const { return consumed_ - (len_ - pos_); }
+
+private:
+    bool fill() {
+        len_ = std::fread(buf_.data(), 1, buf_.size(), f_);
+        pos_ = 0;
+        consumed_ += len_;
+        return len_ > 0;
+    }
+
+    std::FILE* f_;
+    std::vector<char> buf_;
+    size_t pos_ = 0;
+    size_t len_ = 0;
+    uint64_t consumed_ = 0;
+};
+
+// ───────────── Export (read connection) ─────────────
+
+bool PlayDatabase::exportHistory(const std::string& file, HistoryFormat format,
+                                 HistoryTransfer& out) {
+    out = HistoryTransfer();
+    if (!db_) return false;
+
+    const auto t0 = std::chrono::steady_clock::now();
+    std::FILE* f = std::fopen(file.c_str(), "wb");
+    if (!f) {
+        AERIAL_ERROR("DB", "Cannot write ", file, ": ", std::strerror(errno));
+        return false;
+    }
+
+    // One read transaction over both tables, so the file is a consistent
+    // snapshot even if the writer commits meanwhile.
+    std::lock_guard<std::mutex> lock(readMutex_);
+    sqlite3* conn = readDb_ ? readDb_ : db_;
+    if (!execSql(conn, "BEGIN;")) {
+        std::fclose(f);
+        return false;
+    }
+
+    sqlite3_stmt* tracks = nullptr;
+    sqlite3_stmt* events = nullptr;
+    bool ok = sqlite3_prepare_v2(conn, "SELECT id, path, title FROM tracks ORDER BY id;",
+                                 -1, &tracks, nullptr) == SQLITE_OK &&
+              sqlite3_prepare_v2(conn,
+                                 "SELECT id, track_id, event, ts FROM events "
+                                 "WHERE id > ?1 ORDER BY id LIMIT ?2;",
+                                 -1, &events, nullptr) == SQLITE_OK;
+
+    std::string buf;
+    buf.reserve(kIoBuffer + 4096);
+
+    // CSV: each track's ",path,title\n" tail, formatted once.
+    std::unordered_map<int64_t, std::string> csvTail;
+
+    if (ok && format == HistoryFormat::Binary) {
+        buf.append(kHistoryMagic, sizeof(kHistoryMagic));
+        put_varint(buf, static_cast<uint64_t>(queryInt(conn, "SELECT COUNT(*) FROM tracks;", 0)));
+    } else if (ok) {
+        buf.append("ts,event,path,title\n");
+    }
+
+    int rc = SQLITE_DONE;
+    while (ok && (rc = sqlite3_step(tracks)) == SQLITE_ROW) {
+        const int64_t id = sqlite3_column_int64(tracks, 0);
+        const char* path = reinterpret_cast<const char*>(sqlite3_column_text(tracks, 1));
+        const char* title = reinterpret_cast<const char*>(sqlite3_column_text(tracks, 2));
+        std::string_view p = path ? path : "";
+        std::string_view t = title ? title : "";
+        if (format == HistoryFormat::Binary) {
+            put_varint(buf, static_cast<uint64_t>(id));
+            put_bytes(buf, p.data(), p.size());
+            put_bytes(buf, t.data(), t.size());
+            if (buf.size() >= kIoBuffer) ok = drain(f, buf, out.bytes);
+        } else {
+            std::string& tail = csvTail[id];
+            tail.push_back(',');
+            put_csv_field(tail, p);
+            tail.push_back(',');
+            put_csv_field(tail, t);
+            tail.push_back('\n');
+        }
+        ++out.tracks;
+    }
+    ok = ok && rc == SQLITE_DONE;
+
+    // Events, kTransferChunk rows per query (and per binary block).
+    std::vector<int64_t> trackCol, tsCol;
+    std::string eventCol;
+    int64_t lastId = 0;
+    int64_t prevTs = 0;
+    size_t got = kTransferChunk;
+    while (ok && got == kTransferChunk) {
+        trackCol.clear();
+        tsCol.clear();
+        eventCol.clear();
+        got = 0;
+
+        sqlite3_bind_int64(events, 1, lastId);
+        sqlite3_bind_int64(events, 2, static_cast<int64_t>(kTransferChunk));
+        while (ok && (rc = sqlite3_step(events)) == SQLITE_ROW) {
+            lastId = sqlite3_column_int64(events, 0);
+            const int64_t track = sqlite3_column_int64(events, 1);
+            const int code = sqlite3_column_int(events, 2);
+            const int64_t ts = sqlite3_column_int64(events, 3);
+            if (format == HistoryFormat::Binary) {
+                trackCol.push_back(track);
+                eventCol.push_back(static_cast<char>(code));
+                tsCol.push_back(ts);
+            } else {
+                char num[24];
+                std::snprintf(num, sizeof(num), "%lld,", static_cast<long long>(ts));
+                buf.append(num);
+                buf.append(event_name(code));
+                auto tail = csvTail.find(track);
+                buf.append(tail != csvTail.end() ? std::string_view(tail->second)
+                                                 : std::string_view(",,\n"));
+                if (buf.size() >= kIoBuffer) ok = drain(f, buf, out.bytes);
+            }
+            ++got;
+        }
+        sqlite3_reset(events);
+        ok = ok && (rc == SQLITE_ROW || rc == SQLITE_DONE);
+        out.rows += got;
+
+        if (ok && format == HistoryFormat::Binary && got > 0) {
+            put_varint(buf, got);
+            for (int64_t track : trackCol) put_varint(buf, static_cast<uint64_t>(track));
+            buf.append(eventCol);
+            for (int64_t ts : tsCol) {
+                put_varint(buf, zigzag(ts - prevTs));
+                prevTs = ts;
+            }
+            ok = drain(f, buf, out.bytes);
+        }
+    }
+
+    if (ok && format == HistoryFormat::Binary)
+        put_varint(buf, 0);
+    ok = ok && drain(f, buf, out.bytes);
+    if (!ok)
+        AERIAL_ERROR("DB", "Export to ", file, " failed: ", sqlite3_errmsg(conn), " / ",
+                     std::strerror(errno));
+
+    sqlite3_finalize(tracks);
+    sqlite3_finalize(events);
+    execSql(conn, "COMMIT;");
+    ok = (std::fclose(f) == 0) && ok;
+
+    out.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    return ok;
+}
+
+// ───────────── Import (writer thread) ─────────────
+
+bool PlayDatabase::importHistory(const std::string& file, HistoryTransfer& out) {
+    out = HistoryTransfer();
+    if (!db_) return false;
+
+    const auto t0 = std::chrono::steady_clock::now();
+    std::FILE* f = std::fopen(file.c_str(), "rb");
+    if (!f) {
+        AERIAL_ERROR("DB", "Cannot read ", file, ": ", std::strerror(errno));
+        return false;
+    }
+
+    bool ok = false;
+    runOnWriter([&] {
+        // The event indexes take inserts in track order, all over the
+        // file; with the normal page cache most of them would miss.
+        const int64_t cache = queryInt(db_, "PRAGMA cache_size;", -8192);
+        execSql(db_, ("PRAGMA cache_size=" + std::to_string(-kImportCacheKb) + ";").c_str());
+        ok = importRows(f, out);
+        execSql(db_, ("PRAGMA cache_size=" + std::to_string(cache) + ";").c_str());
+    });
+    std::fclose(f);
+
+    out.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    return ok;
+}
+
+bool PlayDatabase::importRows(std::FILE* file, HistoryTransfer& out) {
+    HistoryReader in(file);
+
+    // Rows go in through insertEvent_ without the per-event upserts; each
+    // batch is folded into the aggregates just before it commits.
+    int64_t batchStart = queryInt(db_, "SELECT MAX(id) FROM events;", 0);
+    size_t inBatch = 0;
+    if (!execSql(db_, "BEGIN;")) return false;
+
+    auto commitBatch = [&]() -> bool {
+        const int64_t lastId = queryInt(db_, "SELECT MAX(id) FROM events;", 0);
+        if (lastId > batchStart && !foldEventStats(batchStart, lastId))
+            return false;
+        if (!execSql(db_, "COMMIT;")) return false;
+        batchStart = lastId;
+        inBatch = 0;
+        return true;
+    };
+
+    auto insert = [&](int64_t trackId, int code, int64_t ts) -> bool {
+        sqlite3_bind_int64(insertEvent_, 1, trackId);
+        sqlite3_bind_int(insertEvent_,   2, code);
+        sqlite3_bind_int64(insertEvent_, 3, ts);
+        const int rc = sqlite3_step(insertEvent_);
+        sqlite3_reset(insertEvent_);
+        if (rc != SQLITE_DONE) {
+            AERIAL_ERROR("DB", "Import insert failed: ", sqlite3_errmsg(db_));
+            return false;
+        }
+        ++out.rows;
+        if (++inBatch == kImportBatch)
+            return commitBatch() && execSql(db_, "BEGIN;");
+        return true;
+    };
+
+    char magic[sizeof(kHistoryMagic)] = {};
+    bool ok = true;
+    char first;
+    const bool binary = in.peek(first) && first == kHistoryMagic[0] &&
+                        in.read(magic, sizeof(magic)) &&
+                        std::memcmp(magic, kHistoryMagic, sizeof(magic)) == 0;
+
+    if (binary) {
+        // File track ids -> ids in this database.
+        std::unordered_map<uint64_t, int64_t> ids;
+        uint64_t count = 0;
+        ok = in.varint(count);
+        std::string path, title;
+        for (uint64_t i = 0; ok && i < count; ++i) {
+            uint64_t fileId;
+            ok = in.varint(fileId) && in.string(path) && in.string(title);
+            if (!ok) break;
+            const size_t known = trackIds_.size();
+            const int64_t id = trackIdFor(path, &title);
+            ok = id >= 0;
+            ids[fileId] = id;
+            if (trackIds_.size() != known) ++out.tracks;
+        }
+
+        std::vector<uint64_t> trackCol;
+        std::string eventCol;
+        int64_t ts = 0;
+        uint64_t n = 0;
+        while (ok && (ok = in.varint(n)) && n > 0) {
+            ok = n <= kTransferChunk;
+            trackCol.resize(ok ? n : 0);
+            eventCol.resize(ok ? n : 0);
+            for (uint64_t i = 0; ok && i < n; ++i) ok = in.varint(trackCol[i]);
+            ok = ok && in.read(&eventCol[0], n);
+            for (uint64_t i = 0; ok && i < n; ++i) {
+                uint64_t delta;
+                ok = in.varint(delta);
+                ts += unzigzag(delta);
+                auto id = ids.find(trackCol[i]);
+                const uint64_t code = static_cast<unsigned char>(eventCol[i]);
+                if (!ok) break;
+                if (id == ids.end() || !valid_event(code)) {
+                    ++out.skipped;
+                    continue;
+                }
+                ok = insert(id->second, static_cast<int>(code), ts);
+            }
+        }
+        if (!ok)
+            AERIAL_ERROR("DB", "Import: truncated or corrupt history file");
+    } else {
+        std::vector<std::string> fields;
+        ok = in.csvRecord(fields) && fields.size() >= 3 && fields[0] == "ts";
+        if (!ok)
+            AERIAL_ERROR("DB", "Import: expected a history file or a CSV with a ts,event,path,title header");
+
+        std::string lastPath;
+        int64_t lastTrack = -1;
+        while (ok && in.csvRecord(fields)) {
+            char* end = nullptr;
+            const long long ts = fields.size() >= 3 ? std::strtoll(fields[0].c_str(), &end, 10) : 0;
+            const int code = fields.size() >= 3 ? event_code(fields[1]) : 0;
+            if (fields.size() < 3 || end == fields[0].c_str() || *end != '\0' ||
+                code == 0 || fields[2].empty()) {
+                if (!(fields.size() == 1 && fields[0].empty()))  // blank line
+                    ++out.skipped;
+                continue;
+            }
+            // Exports list a track's events in runs often enough that
+            // remembering the last one skips most map lookups.
+            if (lastTrack < 0 || fields[2] != lastPath) {
+                const std::string* title = fields.size() >= 4 && !fields[3].empty() ? &fields[3] : nullptr;
+                const size_t known = trackIds_.size();
+                lastTrack = trackIdFor(fields[2], title);
+                if (trackIds_.size() != known) ++out.tracks;
+                lastPath = fields[2];
+                if (lastTrack < 0) {
+                    ok = false;
+                    break;
+                }
+            }
+            ok = insert(lastTrack, code, ts);
+        }
+    }
+
+    if (ok && commitBatch()) {
+        out.bytes = in.consumed();
+        return true;
+    }
+    out.rows -= inBatch;  // rolled back below
+    execSql(db_, "ROLLBACK;");
+    loadTrackIds();  // drop ids of tracks from the rolled-back batch
+    out.bytes = in.consumed();
+    return false;
+}
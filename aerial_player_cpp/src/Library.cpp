@@ -0,0 +1,190 @@
+#include "Library.hpp"
+#include "Playlist.hpp"
+#include "Log.hpp"
+#include "Metrics.hpp"
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cwctype>
+#include <stdexcept>
+#include <system_error> // for std::error_code
+
+namespace fs = std::filesystem;
+
+bool isAudioFile(const fs::path &path)
+{
+    // Use wide string to avoid ANSI codepage issues
+    auto ext = path.extension().wstring();
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::towlower);
+
+    return ext == L".mp3" ||
+           ext == L".wav" ||
+           ext == L".ogg" ||
+           ext == L".flac" ||
+           ext == L".m4a";
+}
+
+std::shared_ptr<Playlist> buildPlaylistFromFolder(const std::string &folderPath)
+{
+    AERIAL_SPAN("buildPlaylistFromFolder");
+    auto playlist = std::make_shared<Playlist>();
+
+    AERIAL_DEBUG("MAIN", "Scanning folder: ", folderPath);
+
+    // Treat input as UTF-8 and build a filesystem path from it
+    fs::path root = fs::u8path(folderPath);
+
+    std::error_code ec;
+
+    if (!fs::exists(root, ec) || ec)
+    {
+        throw std::runtime_error(
+            "Folder does not exist or cannot be accessed: " + folderPath +
+            " (" + ec.message() + ")");
+    }
+
+    if (!fs::is_directory(root, ec) || ec)
+    {
+        throw std::runtime_error(
+            "Path is not a directory: " + folderPath +
+            " (" + ec.message() + ")");
+    }
+
+    // Use recursive iterator and skip entries that error instead of throwing
+    fs::directory_options opts = fs::directory_options::skip_permission_denied;
+
+    const uint64_t scanStart = monotonic_ns();
+    fs::recursive_directory_iterator it(root, opts, ec), end;
+    if (ec)
+    {
+        throw std::runtime_error(
+            std::string("Error creating directory iterator: ") + ec.message());
+    }
+
+    for (; it != end; it.increment(ec))
+    {
+        if (ec)
+        {
+            AERIAL_WARN("MAIN", "Skipping entry: ", ec.message());
+            ec.clear();
+            continue;
+        }
+
+        const fs::directory_entry &entry = *it;
+        if (!entry.is_regular_file())
+            continue;
+
+        const fs::path &path = entry.path();
+        if (!isAudioFile(path))
+            continue;
+
+        // Log and store UTF-8 paths; avoids codepage issues on Windows
+        std::string utf8Path = path.u8string();
+        AERIAL_DEBUG("MAIN", "Found audio file: ", utf8Path);
+        playlist->addTrack(utf8Path);
+    }
+
+    metrics().scanNanos.set(static_cast<int64_t>(monotonic_ns() - scanStart));
+    metrics().scanFiles.set(static_cast<int64_t>(playlist->size()));
+    AERIAL_DEBUG("MAIN", "Playlist size: ", playlist->size());
+    return playlist;
+}
+
+static const char kCacheMagic[] = "aerial-library 1\t";
+
+std::string defaultLibraryCachePath()
+{
+#ifdef _WIN32
+    const char *home = std::getenv("USERPROFILE");
+#else
+    const char *home = std::getenv("HOME");
+#endif
+    if (!home)
+        return {};
+    return (fs::u8path(home) / ".cache" / "aerial" / "library.txt").u8string();
+}
+
+bool loadLibraryCache(const std::string &cachePath, const std::string &folderPath,
+                      std::vector<std::string> &paths)
+{
+    AERIAL_SPAN("loadLibraryCache");
+    paths.clear();
+
+    std::FILE *f = std::fopen(fs::u8path(cachePath).string().c_str(), "rb");
+    if (!f)
+        return false;
+    std::string text;
+    char buf[1 << 16];
+    size_t n;
+    while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0)
+        text.append(buf, n);
+    std::fclose(f);
+
+    const std::string header = kCacheMagic + folderPath + '\n';
+    if (text.compare(0, header.size(), header) != 0)
+    {
+        AERIAL_DEBUG("MAIN", "Library cache ", cachePath, " is not for ", folderPath);
+        return false;
+    }
+
+    const std::string_view body = std::string_view(text).substr(header.size());
+    paths.reserve(static_cast<size_t>(std::count(body.begin(), body.end(), '\n')));
+    size_t pos = 0;
+    while (pos < body.size())
+    {
+        size_t end = body.find('\n', pos);
+        if (end == std::string_view::npos)
+            end = body.size();
+        if (end > pos)
+            paths.emplace_back(body.substr(pos, end - pos));
+        pos = end + 1;
+    }
+    return !paths.empty();
+}
+
+bool saveLibraryCache(const std::string &cachePath, const std::string &folderPath,
+                      const Playlist &playlist)
+{
+    AERIAL_SPAN("saveLibraryCache");
+    const fs::path path = fs::u8path(cachePath);
+    std::error_code ec;
+    fs::create_directories(path.parent_path(), ec);
+
+    fs::path tmp = path;
+    tmp += ".tmp";
+    std::FILE *f = std::fopen(tmp.string().c_str(), "wb");
+    if (!f)
+    {
+        AERIAL_WARN("MAIN", "Could not write library cache ", cachePath);
+        return false;
+    }
+
+    std::string out = kCacheMagic + folderPath + '\n';
+    out.reserve(out.size() + playlist.size() * 64);
+    for (size_t i = 0; i < playlist.size(); ++i)
+    {
+        const std::string &track = playlist.trackAt(i);
+        if (track.find('\n') != std::string::npos)
+            continue;
+        out += track;
+        out += '\n';
+    }
+    const bool written = std::fwrite(out.data(), 1, out.size(), f) == out.size();
+    if (std::fclose(f) != 0 || !written)
+    {
+        AERIAL_WARN("MAIN", "Could not write library cache ", cachePath);
+        fs::remove(tmp, ec);
+        return false;
+    }
+
+    fs::rename(tmp, path, ec);
+    if (ec)
+    {
+        AERIAL_WARN("MAIN", "Could not replace library cache ", cachePath, ": ", ec.message());
+        fs::remove(tmp, ec);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Playlist;
+
+// .mp3 / .wav / .ogg / .flac / .m4a, case-insensitively.
+bool isAudioFile(const std::filesystem::path& path);
+
+// Recursively scans `folderPath` (UTF-8) for audio files, in directory
+// order. Throws std::runtime_error if the folder can't be opened;
+// unreadable entries below it are skipped with a warning.
+std::shared_ptr<Playlist> buildPlaylistFromFolder(const std::string& folderPath);
+
+/*
+   Library cache
+   -----------------------------------------
+   The paths found by the last full scan of a folder, so that startup can
+   build the playlist without walking the tree. Plain text: a header line
+   naming the format and the folder, then one UTF-8 path per line (paths
+   containing a newline are left out). A cache written for another folder
+   counts as missing.
+*/
+
+// ~/.cache/aerial/library.txt (%USERPROFILE% on Windows); empty without a
+// home directory.
+std::string defaultLibraryCachePath();
+
+// The cached paths for `folderPath`; false if there are none.
+bool loadLibraryCache(const std::string& cachePath, const std::string& folderPath,
+                      std::vector<std::string>& paths);
+
+// Writes the playlist's paths as the cache for `folderPath`, to a
+// temporary file that is then renamed over the old cache.
+bool saveLibraryCache(const std::string& cachePath, const std::string& folderPath,
+                      const Playlist& playlist);
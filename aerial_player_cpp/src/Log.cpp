@@ -0,0 +1,277 @@
+#include "Log.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace logging {
+
+static const size_t kRingSlots = 256;  // per logging thread, ~128 KiB
+static const std::chrono::milliseconds kSinkInterval(50);
+
+struct Record {
+    int64_t     ns = 0;  // system clock, since the epoch
+    const char* tag = nullptr;
+    LogLevel    level = LogLevel::Info;
+    Line        line;
+};
+
+// Single producer (the owning thread), single consumer (whoever holds the
+// sink mutex). Slots in [head, tail) are ready to print.
+struct Ring {
+    Record slots[kRingSlots];
+    std::atomic<uint64_t> head{0};
+    std::atomic<uint64_t> tail{0};
+    std::atomic<bool> orphaned{false};  // owning thread has exited
+};
+
+static const char* level_name(LogLevel level) {
+    switch (level) {
+    case LogLevel::Trace: return "TRACE";
+    case LogLevel::Debug: return "DEBUG";
+    case LogLevel::Info:  return "INFO ";
+    case LogLevel::Warn:  return "WARN ";
+    case LogLevel::Error: return "ERROR";
+    case LogLevel::Off:   break;
+    }
+    return "     ";
+}
+
+static void local_time(std::time_t t, std::tm& out) {
+#ifdef _WIN32
+    localtime_s(&out, &t);
+#else
+    localtime_r(&t, &out);
+#endif
+}
+
+class Sink {
+public:
+    Sink() {
+        std::thread([this] { run(); }).detach();
+        std::atexit([] { flush(); });
+    }
+
+    std::shared_ptr<Ring> attach() {
+        auto ring = std::make_shared<Ring>();
+        std::lock_guard<std::mutex> lock(mutex_);
+        rings_.push_back(ring);
+        return ring;
+    }
+
+    void wake() { cv_.notify_one(); }
+
+    void drainNow() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        drainLocked();
+    }
+
+    void setOutput(std::FILE* out) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        drainLocked();
+        out_ = out ? out : stderr;
+    }
+
+    std::atomic<uint64_t> dropped{0};
+
+private:
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            cv_.wait_for(lock, kSinkInterval);
+            drainLocked();
+        }
+    }
+
+    void drainLocked() {
+        batch_.clear();
+        ends_.clear();
+        for (const auto& ring : rings_) {
+            const uint64_t head = ring->head.load(std::memory_order_relaxed);
+            const uint64_t tail = ring->tail.load(std::memory_order_acquire);
+            for (uint64_t i = head; i < tail; ++i)
+                batch_.push_back(&ring->slots[i % kRingSlots]);
+            ends_.push_back(tail);
+        }
+
+        const uint64_t dropped = this->dropped.load(std::memory_order_relaxed);
+        if (batch_.empty() && dropped == reportedDrops_)
+            return;
+
+        // Rings are each in order; interleave them by time.
+        std::stable_sort(batch_.begin(), batch_.end(),
+                         [](const Record* a, const Record* b) { return a->ns < b->ns; });
+
+        text_.clear();
+        for (const Record* r : batch_)
+            format(*r);
+        if (dropped != reportedDrops_) {
+            Record note;
+            note.ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::system_clock::now().time_since_epoch()).count();
+            note.tag = "LOG";
+            note.level = LogLevel::Warn;
+            note.line.append(dropped - reportedDrops_);
+            note.line.append(" line(s) dropped: log ring full");
+            format(note);
+            reportedDrops_ = dropped;
+        }
+
+        std::fwrite(text_.data(), 1, text_.size(), out_);
+        std::fflush(out_);
+
+        // Hand the slots back only now that they have been copied out.
+        for (size_t i = 0; i < rings_.size(); ++i)
+            rings_[i]->head.store(ends_[i], std::memory_order_release);
+        rings_.erase(std::remove_if(rings_.begin(), rings_.end(),
+                                    [](const std::shared_ptr<Ring>& r) {
+                                        return r->orphaned.load() &&
+                                               r->head.load() == r->tail.load();
+                                    }),
+                     rings_.end());
+    }
+
+    // "2026-01-31 18:04:05.123 INFO  [DB] message\n"
+    void format(const Record& r) {
+        const int64_t sec = r.ns / 1000000000;
+        if (sec != cachedSec_) {
+            std::tm tm{};
+            local_time(static_cast<std::time_t>(sec), tm);
+            std::strftime(cachedTime_, sizeof(cachedTime_), "%Y-%m-%d %H:%M:%S", &tm);
+            cachedSec_ = sec;
+        }
+        char ms[8];
+        std::snprintf(ms, sizeof(ms), ".%03d ", static_cast<int>(r.ns / 1000000 % 1000));
+
+        text_.append(cachedTime_);
+        text_.append(ms);
+        text_.append(level_name(r.level));
+        text_.push_back(' ');
+        if (r.tag && *r.tag) {
+            text_.push_back('[');
+            text_.append(r.tag);
+            text_.append("] ");
+        }
+        text_.append(r.line.text, r.line.len);
+        if (r.line.truncated)
+            text_.append("...");
+        text_.push_back('\n');
+    }
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<std::shared_ptr<Ring>> rings_;
+    std::FILE* out_ = stderr;
+
+    // Reused by drainLocked()
+    std::vector<const Record*> batch_;
+    std::vector<uint64_t> ends_;
+    std::string text_;
+    uint64_t reportedDrops_ = 0;
+    int64_t  cachedSec_ = -1;
+    char     cachedTime_[32] = {};
+};
+
+// Never destroyed: threads may still log while statics are torn down.
+static Sink& sink() {
+    static Sink* s = new Sink;
+    return *s;
+}
+
+// The calling thread's ring, created on its first log line and left for
+// the sink to retire once the thread is gone and the ring is drained.
+struct ThreadRing {
+    std::shared_ptr<Ring> ring;
+    ~ThreadRing() {
+        if (ring) ring->orphaned.store(true);
+    }
+};
+
+static thread_local ThreadRing t_ring;
+
+Line* reserve(LogLevel level, const char* tag) {
+    if (!t_ring.ring)
+        t_ring.ring = sink().attach();
+    Ring& ring = *t_ring.ring;
+
+    const uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+    if (tail - ring.head.load(std::memory_order_acquire) == kRingSlots) {
+        sink().dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Record& r = ring.slots[tail % kRingSlots];
+    r.ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::system_clock::now().time_since_epoch()).count();
+    r.tag = tag;
+    r.level = level;
+    r.line.len = 0;
+    r.line.truncated = false;
+    return &r.line;
+}
+
+void commit() {
+    Ring& ring = *t_ring.ring;
+    const uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+    const LogLevel level = ring.slots[tail % kRingSlots].level;
+    ring.tail.store(tail + 1, std::memory_order_release);
+
+    // Warnings and errors go out promptly; the rest ride the next tick.
+    if (level >= LogLevel::Warn)
+        sink().wake();
+}
+
+void flush() {
+    sink().drainNow();
+}
+
+void setOutput(std::FILE* out) {
+    sink().setOutput(out);
+}
+
+uint64_t dropped() {
+    return sink().dropped.load(std::memory_order_relaxed);
+}
+
+bool parseLevel(std::string_view name, LogLevel& out) {
+    static const struct { const char* name; LogLevel level; } levels[] = {
+        {"trace", LogLevel::Trace}, {"debug", LogLevel::Debug}, {"info", LogLevel::Info},
+        {"warn",  LogLevel::Warn},  {"error", LogLevel::Error}, {"off",  LogLevel::Off},
+    };
+    for (const auto& l : levels) {
+        const std::string_view candidate(l.name);
+        if (candidate.size() != name.size()) continue;
+        bool same = true;
+        for (size_t i = 0; i < name.size() && same; ++i)
+            same = std::tolower(static_cast<unsigned char>(name[i])) == candidate[i];
+        if (same) {
+            out = l.level;
+            return true;
+        }
+    }
+    return false;
+}
+
+void Line::append(double v) {
+    if (len >= kCapacity) {
+        truncated = true;
+        return;
+    }
+    int n = std::snprintf(text + len, kCapacity - len, "%g", v);
+    if (n < 0) return;
+    if (static_cast<size_t>(n) >= kCapacity - len) {
+        len = kCapacity - 1;  // snprintf wrote a terminator in the last byte
+        truncated = true;
+    } else {
+        len += static_cast<size_t>(n);
+    }
+}
+
+} // namespace logging
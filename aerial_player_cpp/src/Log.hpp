@@ -0,0 +1,133 @@
+#pragma once
+
+#include <atomic>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+/*
+   Leveled asynchronous logger
+   -----------------------------------------
+       AERIAL_INFO("DB", "Opened DB at ", path, " (batch=", batch, ")");
+
+   The caller formats the line into a slot of its own thread's ring buffer
+   (single producer / single consumer, no lock, no allocation) and goes
+   on; a sink thread drains every ring a few times per second, orders the
+   lines by time and writes them to stderr in a single fwrite. If a
+   thread's ring is full the line is dropped and counted rather than
+   blocking — the player and control threads never wait on the console.
+
+   Levels below AERIAL_LOG_MIN_LEVEL are compiled out entirely, arguments
+   included; the rest are filtered at runtime against logging::setLevel()
+   (config "log_level"), which costs one relaxed atomic load.
+*/
+
+enum class LogLevel : uint8_t {
+    Trace = 0,
+    Debug = 1,
+    Info  = 2,
+    Warn  = 3,
+    Error = 4,
+    Off   = 5,
+};
+
+#ifndef AERIAL_LOG_MIN_LEVEL
+#define AERIAL_LOG_MIN_LEVEL 1  // Debug and up are compiled in
+#endif
+
+namespace logging {
+
+// One formatted line; longer messages are truncated with "...".
+struct Line {
+    static constexpr size_t kCapacity = 472;
+
+    char   text[kCapacity];
+    size_t len = 0;
+    bool   truncated = false;
+
+    void append(std::string_view s) {
+        size_t n = s.size();
+        if (n > kCapacity - len) {
+            n = kCapacity - len;
+            truncated = true;
+        }
+        for (size_t i = 0; i < n; ++i) text[len + i] = s[i];
+        len += n;
+    }
+    void append(const char* s) { append(std::string_view(s ? s : "")); }
+    void append(const std::string& s) { append(std::string_view(s)); }
+    void append(char c) {
+        if (len < kCapacity) text[len++] = c;
+        else truncated = true;
+    }
+    void append(bool b) { append(std::string_view(b ? "true" : "false")); }
+    void append(double v);  // like ostream's default (%g)
+    void append(float v) { append(static_cast<double>(v)); }
+
+    template <typename T,
+              typename std::enable_if<std::is_integral<T>::value, int>::type = 0>
+    void append(T v) {
+        auto r = std::to_chars(text + len, text + kCapacity, v);
+        if (r.ec == std::errc()) len = static_cast<size_t>(r.ptr - text);
+        else truncated = true;
+    }
+};
+
+// Runtime threshold; Info until setLevel() is called.
+inline std::atomic<uint8_t> currentLevel{static_cast<uint8_t>(LogLevel::Info)};
+
+inline LogLevel level() {
+    return static_cast<LogLevel>(currentLevel.load(std::memory_order_relaxed));
+}
+inline void setLevel(LogLevel l) {
+    currentLevel.store(static_cast<uint8_t>(l), std::memory_order_relaxed);
+}
+
+// "trace" | "debug" | "info" | "warn" | "error" | "off" (case-insensitive)
+bool parseLevel(std::string_view name, LogLevel& out);
+
+inline bool enabled(LogLevel l) {
+    return static_cast<int>(l) >= static_cast<int>(level());
+}
+
+// The calling thread's next free ring slot, stamped with the time, level
+// and tag (a string literal), or null if the ring is full. Fill it in and
+// commit() it; write() does both.
+Line* reserve(LogLevel level, const char* tag);
+void commit();
+
+// Writes everything queued so far before returning (also runs at exit).
+void flush();
+
+// Where the sink writes (default stderr); the caller keeps `out` open.
+void setOutput(std::FILE* out);
+
+// Lines dropped because a thread's ring was full.
+uint64_t dropped();
+
+template <typename... Args>
+void write(LogLevel level, const char* tag, const Args&... args) {
+    Line* line = reserve(level, tag);
+    if (!line) return;
+    (line->append(args), ...);
+    commit();
+}
+
+} // namespace logging
+
+#define AERIAL_LOG(lvl, tag, ...)                                               \
+    do {                                                                        \
+        if constexpr (static_cast<int>(lvl) >= AERIAL_LOG_MIN_LEVEL) {          \
+            if (::logging::enabled(lvl)) ::logging::write(lvl, tag, __VA_ARGS__); \
+        }                                                                       \
+    } while (0)
+
+#define AERIAL_TRACE(tag, ...) AERIAL_LOG(LogLevel::Trace, tag, __VA_ARGS__)
+#define AERIAL_DEBUG(tag, ...) AERIAL_LOG(LogLevel::Debug, tag, __VA_ARGS__)
+#define AERIAL_INFO(tag, ...)  AERIAL_LOG(LogLevel::Info,  tag, __VA_ARGS__)
+#define AERIAL_WARN(tag, ...)  AERIAL_LOG(LogLevel::Warn,  tag, __VA_ARGS__)
+#define AERIAL_ERROR(tag, ...) AERIAL_LOG(LogLevel::Error, tag, __VA_ARGS__)
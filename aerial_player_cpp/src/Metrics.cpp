@@ -0,0 +1,198 @@
+#include "Metrics.hpp"
+
+#include "Log.hpp"
+#include "OutBuffer.hpp"
+
+#include <cstdio>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+Histogram::Histogram() {
+    for (auto& b : buckets_)
+        b.store(0, std::memory_order_relaxed);
+}
+
+// Values below 2^kSubBits get a bucket each; above that, each power of two
+// [2^e, 2^(e+1)) is split into 2^kSubBits equal buckets.
+size_t Histogram::bucketOf(uint64_t v) {
+    const uint64_t kLinear = uint64_t(1) << kSubBits;
+    if (v < kLinear) return static_cast<size_t>(v);
+#ifdef _MSC_VER
+    unsigned long e;
+    _BitScanReverse64(&e, v);
+#else
+    const int e = 63 - __builtin_clzll(v);
+#endif
+    const uint64_t sub = (v >> (e - kSubBits)) & (kLinear - 1);
+    return (static_cast<size_t>(e - kSubBits + 1) << kSubBits) + static_cast<size_t>(sub);
+}
+
+uint64_t Histogram::bucketUpper(size_t i) {
+    const size_t kLinear = size_t(1) << kSubBits;
+    if (i < kLinear) return i;
+    const int e = static_cast<int>(i >> kSubBits) + kSubBits - 1;
+    const uint64_t sub = i & (kLinear - 1);
+    const uint64_t lower = (kLinear + sub) << (e - kSubBits);
+    return lower + ((uint64_t(1) << (e - kSubBits)) - 1);
+}
+
+uint64_t Histogram::count() const {
+    uint64_t n = 0;
+    for (const auto& b : buckets_)
+        n += b.load(std::memory_order_relaxed);
+    return n;
+}
+
+uint64_t Histogram::quantile(double q) const {
+    const uint64_t n = count();
+    if (n == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(n));
+    if (rank == 0) rank = 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+        seen += bucketCount(i);
+        if (seen >= rank) return bucketUpper(i);
+    }
+    return bucketUpper(kBuckets - 1);
+}
+
+void Histogram::reset() {
+    for (auto& b : buckets_)
+        b.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+}
+
+Metrics& metrics() {
+    // Leaked so server threads can still record while statics are torn down.
+    static Metrics* m = new Metrics();
+    return *m;
+}
+
+// ---- Prometheus text format ----
+
+// Exported bucket bounds, in seconds. Internal buckets are folded into the
+// first bound at or above their upper edge, so each exported count is a
+// lower bound, off by at most one internal bucket (12.5%).
+static const double kLeSeconds[] = {
+    1e-6, 5e-6, 1e-5, 5e-5, 1e-4, 5e-4, 1e-3, 2.5e-3, 5e-3,
+    1e-2, 2.5e-2, 5e-2, 0.1, 0.25, 0.5, 1, 2.5, 5, 10,
+};
+
+static void append_double(OutBuffer& out, double v) {
+    char tmp[32];
+    int n = std::snprintf(tmp, sizeof(tmp), "%.9g", v);
+    if (n > 0) out.append(std::string_view(tmp, static_cast<size_t>(n)));
+}
+
+static void append_header(OutBuffer& out, const char* name, const char* type, const char* help) {
+    out << "# HELP " << name << ' ' << help << '\n'
+        << "# TYPE " << name << ' ' << type << '\n';
+}
+
+// `labels` is either empty or `key="value"` without braces.
+static void append_histogram(OutBuffer& out, const char* name, std::string_view labels,
+                             const Histogram& h) {
+    // Read the buckets once, so _bucket, _count and _sum agree with each other.
+    uint64_t counts[Histogram::kBuckets];
+    uint64_t total = 0;
+    for (size_t i = 0; i < Histogram::kBuckets; ++i) {
+        counts[i] = h.bucketCount(i);
+        total += counts[i];
+    }
+
+    size_t i = 0;
+    uint64_t cumulative = 0;
+    for (double le : kLeSeconds) {
+        const uint64_t leNs = static_cast<uint64_t>(le * 1e9);
+        while (i < Histogram::kBuckets && Histogram::bucketUpper(i) <= leNs)
+            cumulative += counts[i++];
+        out << name << "_bucket{";
+        if (!labels.empty()) out << labels << ',';
+        out << "le=\"";
+        append_double(out, le);
+        out << "\"} " << cumulative << '\n';
+    }
+    out << name << "_bucket{";
+    if (!labels.empty()) out << labels << ',';
+    out << "le=\"+Inf\"} " << total << '\n';
+
+    out << name << "_sum";
+    if (!labels.empty()) out << '{' << labels << '}';
+    out << ' ';
+    append_double(out, static_cast<double>(h.sum()) / 1e9);
+    out << '\n';
+
+    out << name << "_count";
+    if (!labels.empty()) out << '{' << labels << '}';
+    out << ' ' << total << '\n';
+}
+
+const char* startupPhaseName(StartupPhase p) {
+    static const char* const kNames[] = {"config", "db", "library", "audio", "servers", "ready"};
+    return kNames[static_cast<size_t>(p)];
+}
+
+void appendPrometheus(OutBuffer& out) {
+    Metrics& m = metrics();
+
+    static const char* const kSources[] = {"stdin", "tcp", "http", "ipc"};
+    static const char* const kServers[] = {"tcp", "http", "ipc"};
+
+    append_header(out, "aerial_command_duration_seconds", "histogram",
+                  "Time to parse and execute one control command, including the wait for the player lock.");
+    for (size_t s = 0; s < static_cast<size_t>(CommandSource::Count); ++s) {
+        char labels[32];
+        int n = std::snprintf(labels, sizeof(labels), "source=\"%s\"", kSources[s]);
+        append_histogram(out, "aerial_command_duration_seconds",
+                         std::string_view(labels, static_cast<size_t>(n)), m.commandSeconds[s]);
+    }
+
+    append_header(out, "aerial_track_load_seconds", "histogram", "Time spent in Mix_LoadMUS.");
+    append_histogram(out, "aerial_track_load_seconds", {}, m.trackLoadSeconds);
+
+    append_header(out, "aerial_track_transition_gap_seconds", "histogram",
+                  "Silence between halting one track and the next one starting.");
+    append_histogram(out, "aerial_track_transition_gap_seconds", {}, m.transitionGapSeconds);
+
+    append_header(out, "aerial_db_batch_seconds", "histogram",
+                  "Time to write one batch of play events to the database.");
+    append_histogram(out, "aerial_db_batch_seconds", {}, m.dbBatchSeconds);
+
+    append_header(out, "aerial_db_events_written_total", "counter", "Play events written to the database.");
+    out << "aerial_db_events_written_total " << m.dbEventsWritten.value() << '\n';
+
+    const int64_t files = m.scanFiles.value();
+    const int64_t scanNs = m.scanNanos.value();
+    append_header(out, "aerial_scan_files", "gauge", "Audio files found by the last folder scan.");
+    out << "aerial_scan_files " << files << '\n';
+    append_header(out, "aerial_scan_duration_seconds", "gauge", "Duration of the last folder scan.");
+    out << "aerial_scan_duration_seconds ";
+    append_double(out, static_cast<double>(scanNs) / 1e9);
+    out << '\n';
+    append_header(out, "aerial_scan_files_per_second", "gauge", "Throughput of the last folder scan.");
+    out << "aerial_scan_files_per_second ";
+    append_double(out, scanNs > 0 ? static_cast<double>(files) * 1e9 / static_cast<double>(scanNs) : 0.0);
+    out << '\n';
+
+    append_header(out, "aerial_connections_active", "gauge", "Open control connections.");
+    for (size_t s = 0; s < static_cast<size_t>(Server::Count); ++s)
+        out << "aerial_connections_active{server=\"" << kServers[s] << "\"} "
+            << static_cast<long long>(m.connectionsActive[s].value()) << '\n';
+    append_header(out, "aerial_connections_total", "counter", "Control connections accepted.");
+    for (size_t s = 0; s < static_cast<size_t>(Server::Count); ++s)
+        out << "aerial_connections_total{server=\"" << kServers[s] << "\"} "
+            << m.connectionsTotal[s].value() << '\n';
+
+    append_header(out, "aerial_startup_phase_seconds", "gauge",
+                  "Duration of each startup phase; db, library and audio overlap.");
+    for (size_t p = 0; p < static_cast<size_t>(StartupPhase::Count); ++p) {
+        out << "aerial_startup_phase_seconds{phase=\"" << startupPhaseName(static_cast<StartupPhase>(p)) << "\"} ";
+        append_double(out, static_cast<double>(m.startupNanos[p].value()) / 1e9);
+        out << '\n';
+    }
+
+    append_header(out, "aerial_log_dropped_total", "counter", "Log lines dropped because a log ring was full.");
+    out << "aerial_log_dropped_total " << logging::dropped() << '\n';
+}
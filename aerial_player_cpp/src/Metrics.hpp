@@ -0,0 +1,148 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+class OutBuffer;
+
+/*
+   Process metrics, exported as GET /metrics
+   -----------------------------------------
+       ScopedTimer t(metrics().command(CommandSource::Tcp));
+       metrics().dbEventsWritten.add(n);
+
+   Every update is a relaxed atomic add on a fixed slot: no lock, no
+   allocation, no registration at the call site. Histograms keep
+   log-linear buckets (HDR-style: 8 per power of two, so any recorded
+   value is known to within 12.5%) over the whole uint64 range of
+   nanoseconds, and are folded into Prometheus cumulative buckets only
+   when /metrics is scraped.
+*/
+
+class Counter {
+public:
+    void add(uint64_t n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> value_{0};
+};
+
+class Gauge {
+public:
+    void add(int64_t n) { value_.fetch_add(n, std::memory_order_relaxed); }
+    void set(int64_t v) { value_.store(v, std::memory_order_relaxed); }
+    int64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> value_{0};
+};
+
+class Histogram {
+public:
+    static constexpr int kSubBits = 3;  // 2^3 buckets per power of two
+    static constexpr size_t kBuckets = (64 - kSubBits + 1) << kSubBits;
+
+    Histogram();
+
+    void record(uint64_t ns) {
+        buckets_[bucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(ns, std::memory_order_relaxed);
+    }
+
+    // Totals at the time of the call; concurrent updates may or may not
+    // be included.
+    uint64_t count() const;
+    uint64_t sum() const { return sum_.load(std::memory_order_relaxed); }
+    uint64_t bucketCount(size_t i) const { return buckets_[i].load(std::memory_order_relaxed); }
+
+    // Upper bound of the bucket holding the q-th value (0 < q <= 1);
+    // 0 when empty.
+    uint64_t quantile(double q) const;
+
+    void reset();
+
+    static size_t bucketOf(uint64_t v);
+    static uint64_t bucketUpper(size_t i);  // largest value in bucket i
+
+private:
+    std::atomic<uint64_t> buckets_[kBuckets];
+    std::atomic<uint64_t> sum_{0};
+};
+
+inline uint64_t monotonic_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Records the time from construction to destruction (or stop()).
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Histogram& h) : h_(&h), start_(monotonic_ns()) {}
+    ~ScopedTimer() { stop(); }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    void stop() {
+        if (h_) h_->record(monotonic_ns() - start_);
+        h_ = nullptr;
+    }
+    void cancel() { h_ = nullptr; }
+
+private:
+    Histogram* h_;
+    uint64_t start_;
+};
+
+enum class CommandSource : uint8_t { Stdin, Tcp, Http, Ipc, Count };
+enum class Server : uint8_t { Tcp, Http, Ipc, Count };
+
+// Database, Library and Audio run in parallel; Ready is main() to the
+// servers listening.
+enum class StartupPhase : uint8_t { Config, Database, Library, Audio, Servers, Ready, Count };
+
+struct Metrics {
+    Histogram& command(CommandSource s) { return commandSeconds[static_cast<size_t>(s)]; }
+    Gauge& startup(StartupPhase p) { return startupNanos[static_cast<size_t>(p)]; }
+
+    Histogram commandSeconds[static_cast<size_t>(CommandSource::Count)];
+    Histogram trackLoadSeconds;       // Mix_LoadMUS
+    Histogram transitionGapSeconds;   // old track halted -> new one playing
+    Histogram dbBatchSeconds;         // one write-behind transaction
+    Counter   dbEventsWritten;
+
+    Gauge     scanFiles;              // last folder scan
+    Gauge     scanNanos;
+
+    Gauge     connectionsActive[static_cast<size_t>(Server::Count)];
+    Counter   connectionsTotal[static_cast<size_t>(Server::Count)];
+
+    Gauge     startupNanos[static_cast<size_t>(StartupPhase::Count)];
+};
+
+// "config", "db", "library", "audio", "servers", "ready"
+const char* startupPhaseName(StartupPhase p);
+
+Metrics& metrics();
+
+// Counts a client connection for as long as it is in scope.
+class ConnectionScope {
+public:
+    explicit ConnectionScope(Server s) : index_(static_cast<size_t>(s)) {
+        metrics().connectionsTotal[index_].add();
+        metrics().connectionsActive[index_].add(1);
+    }
+    ~ConnectionScope() { metrics().connectionsActive[index_].add(-1); }
+
+    ConnectionScope(const ConnectionScope&) = delete;
+    ConnectionScope& operator=(const ConnectionScope&) = delete;
+
+private:
+    size_t index_;
+};
+
+// Prometheus text exposition format (version 0.0.4).
+void appendPrometheus(OutBuffer& out);
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/*
+ * Growable byte buffer meant to be kept alive for the lifetime of a
+ * connection and cleared between replies. clear() keeps the capacity,
+ * so once a connection has warmed up, building a reply allocates nothing.
+ */
+class OutBuffer {
+public:
+    explicit OutBuffer(size_t reserveBytes = 1024) {
+        buf_.reserve(reserveBytes);
+    }
+
+    void clear() { buf_.clear(); }
+
+    void append(std::string_view s) { buf_.append(s.data(), s.size()); }
+    void append(char c) { buf_.push_back(c); }
+    void appendRepeat(char c, size_t count) { buf_.append(count, c); }
+
+    void appendInt(long long value) {
+        char tmp[24];
+        auto res = std::to_chars(tmp, tmp + sizeof(tmp), value);
+        buf_.append(tmp, static_cast<size_t>(res.ptr - tmp));
+    }
+
+    OutBuffer& operator<<(std::string_view s) { append(s); return *this; }
+    OutBuffer& operator<<(char c) { append(c); return *this; }
+    OutBuffer& operator<<(int v) { appendInt(v); return *this; }
+    OutBuffer& operator<<(long v) { appendInt(v); return *this; }
+    OutBuffer& operator<<(long long v) { appendInt(v); return *this; }
+    OutBuffer& operator<<(unsigned v) { appendInt(static_cast<long long>(v)); return *this; }
+    OutBuffer& operator<<(unsigned long v) { appendInt(static_cast<long long>(v)); return *this; }
+    OutBuffer& operator<<(unsigned long long v) { appendInt(static_cast<long long>(v)); return *this; }
+
+    const char* data() const { return buf_.data(); }
+    size_t size() const { return buf_.size(); }
+    bool empty() const { return buf_.empty(); }
+    std::string_view view() const { return buf_; }
+
+private:
+    std::string buf_;
+};
@@ -0,0 +1,139 @@
+#include "PlayQueue.hpp"
+
+#include <stdexcept>
+
+PlayQueue::PlayQueue() {
+    nodes_.push_back(Node{0, 0, 0, 0, 0});
+}
+
+uint32_t PlayQueue::newNode(uint32_t track) {
+    // xorshift32: priorities only need to be independent of the order
+    rng_ ^= rng_ << 13;
+    rng_ ^= rng_ >> 17;
+    rng_ ^= rng_ << 5;
+
+    const Node node{track, rng_, 1, 0, 0};
+    if (!free_.empty()) {
+        const uint32_t n = free_.back();
+        free_.pop_back();
+        nodes_[n] = node;
+        return n;
+    }
+    nodes_.push_back(node);
+    return static_cast<uint32_t>(nodes_.size() - 1);
+}
+
+void PlayQueue::split(uint32_t t, size_t k, uint32_t& a, uint32_t& b) {
+    if (t == 0) {
+        a = b = 0;
+        return;
+    }
+    const size_t leftSize = nodes_[nodes_[t].left].size;
+    if (k <= leftSize) {
+        split(nodes_[t].left, k, a, nodes_[t].left);
+        b = t;
+    } else {
+        split(nodes_[t].right, k - leftSize - 1, nodes_[t].right, b);
+        a = t;
+    }
+    update(t);
+}
+
+uint32_t PlayQueue::merge(uint32_t a, uint32_t b) {
+    if (a == 0) return b;
+    if (b == 0) return a;
+    if (nodes_[a].priority > nodes_[b].priority) {
+        nodes_[a].right = merge(nodes_[a].right, b);
+        update(a);
+        return a;
+    }
+    nodes_[b].left = merge(a, nodes_[b].left);
+    update(b);
+    return b;
+}
+
+uint32_t PlayQueue::at(size_t pos) const {
+    if (pos >= size()) {
+        throw std::out_of_range("PlayQueue::at position out of range");
+    }
+    uint32_t n = root_;
+    for (;;) {
+        const size_t leftSize = nodes_[nodes_[n].left].size;
+        if (pos < leftSize) {
+            n = nodes_[n].left;
+        } else if (pos == leftSize) {
+            return nodes_[n].track;
+        } else {
+            pos -= leftSize + 1;
+            n = nodes_[n].right;
+        }
+    }
+}
+
+void PlayQueue::insert(size_t pos, uint32_t track) {
+    if (pos > size()) {
+        throw std::out_of_range("PlayQueue::insert position out of range");
+    }
+    const uint32_t n = newNode(track);
+    uint32_t a, b;
+    split(root_, pos, a, b);
+    root_ = merge(merge(a, n), b);
+}
+
+uint32_t PlayQueue::erase(size_t pos) {
+    if (pos >= size()) {
+        throw std::out_of_range("PlayQueue::erase position out of range");
+    }
+    uint32_t a, mid, b;
+    split(root_, pos, a, b);
+    split(b, 1, mid, b);
+    root_ = merge(a, b);
+
+    const uint32_t track = nodes_[mid].track;
+    free_.push_back(mid);
+    return track;
+}
+
+void PlayQueue::move(size_t from, size_t to) {
+    if (from >= size() || to >= size()) {
+        throw std::out_of_range("PlayQueue::move position out of range");
+    }
+    if (from == to) return;
+
+    // Detach the node and splice it back in; it keeps its slot.
+    uint32_t a, mid, b;
+    split(root_, from, a, b);
+    split(b, 1, mid, b);
+    root_ = merge(a, b);
+
+    split(root_, to, a, b);
+    root_ = merge(merge(a, mid), b);
+}
+
+void PlayQueue::clear() {
+    nodes_.resize(1);
+    free_.clear();
+    root_ = 0;
+}
+
+void PlayQueue::collect(uint32_t n, size_t& skip, size_t& count, std::vector<uint32_t>& out) const {
+    if (n == 0 || count == 0) return;
+    const Node& node = nodes_[n];
+    if (skip >= node.size) {
+        skip -= node.size;  // whole subtree before the range
+        return;
+    }
+    collect(node.left, skip, count, out);
+    if (count == 0) return;
+    if (skip > 0) {
+        --skip;
+    } else {
+        out.push_back(node.track);
+        --count;
+    }
+    collect(node.right, skip, count, out);
+}
+
+void PlayQueue::copyRange(size_t pos, size_t count, std::vector<uint32_t>& out) const {
+    collect(root_, pos, count, out);
+}
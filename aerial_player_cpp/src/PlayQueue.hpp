@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// The "up next" queue: library indices to play before the normal order
+// resumes, editable anywhere.
+//
+// An implicit treap: a binary tree in queue order, heap-ordered by random
+// priorities, where each node stores its subtree size. Splitting off the
+// first k entries and joining two treaps are O(log n) expected, and
+// insert / erase / move / at are built from those, so editing a 1M-entry
+// queue costs the same few dozen node visits as editing a short one.
+// Nodes live in one vector and are linked by index (0 = none), with
+// freed slots reused, so edits don't allocate once the queue has grown.
+//
+// Positions are 0-based, front first. Not thread-safe: used through
+// Playlist and Zone, whose callers hold control_mutex().
+class PlayQueue {
+public:
+    PlayQueue();
+
+    size_t size() const { return nodes_[root_].size; }
+    bool empty() const { return root_ == 0; }
+
+    uint32_t at(size_t pos) const;                // pos < size()
+    void insert(size_t pos, uint32_t track);      // pos <= size()
+    uint32_t erase(size_t pos);                   // pos < size(); returns the track
+    void move(size_t from, size_t to);            // the entry ends up at `to`
+    void pushBack(uint32_t track) { insert(size(), track); }
+    uint32_t popFront() { return erase(0); }
+    void clear();
+
+    // Appends up to `count` tracks from `pos` on to `out`, in order;
+    // O(log n + count).
+    void copyRange(size_t pos, size_t count, std::vector<uint32_t>& out) const;
+
+private:
+    struct Node {
+        uint32_t track;
+        uint32_t priority;
+        uint32_t size;    // nodes in this subtree
+        uint32_t left;
+        uint32_t right;
+    };
+
+    uint32_t newNode(uint32_t track);
+    void update(uint32_t n) { nodes_[n].size = 1 + nodes_[nodes_[n].left].size + nodes_[nodes_[n].right].size; }
+    void split(uint32_t t, size_t k, uint32_t& a, uint32_t& b);  // a = first k
+    uint32_t merge(uint32_t a, uint32_t b);
+    void collect(uint32_t n, size_t& skip, size_t& count, std::vector<uint32_t>& out) const;
+
+    std::vector<Node> nodes_;      // [0] is the empty sentinel, size 0
+    std::vector<uint32_t> free_;   // erased slots, reused first
+    uint32_t root_ = 0;
+    uint32_t rng_ = 2463534242u;
+};
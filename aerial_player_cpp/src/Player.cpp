@@ -1,12 +1,14 @@
 #include "Player.hpp"
 #include "Playlist.hpp"
 #include "UI.hpp"
+#include "Log.hpp"
+#include "Metrics.hpp"
+#include "Trace.hpp"
 
 #include <SDL.h>
 #include <SDL_mixer.h>
 
 #include <algorithm>   // std::clamp
-#include <iostream>
 #include <string>
 
 // Map our 0–100% to SDL_mixer 0–128
@@ -21,12 +23,15 @@ Player::~Player() {
     shutdown();
 }
 
-bool Player::init() {
+bool Player::init(const char* audioDriver) {
     if (initialized_)
         return true;
 
+    if (audioDriver)
+        SDL_setenv("SDL_AUDIODRIVER", audioDriver, 1);
+
     if (SDL_Init(SDL_INIT_AUDIO) < 0) {
-        std::cerr << "[SDL] SDL_Init failed: " << SDL_GetError() << "\n";
+        AERIAL_ERROR("SDL", "SDL_Init failed: ", SDL_GetError());
         return false;
     }
 
@@ -34,14 +39,14 @@ bool Player::init() {
     int flags = MIX_INIT_MP3 | MIX_INIT_OGG | MIX_INIT_FLAC;
     int initted = Mix_Init(flags);
     if ((initted & flags) != flags) {
-        std::cerr << "[SDL_mixer] Mix_Init failed: " << Mix_GetError()
-                  << " (some formats may not be supported)\n";
+        AERIAL_WARN("SDL_mixer", "Mix_Init failed: ", Mix_GetError(),
+                    " (some formats may not be supported)");
         // Not necessarily fatal
     }
 
     // 44.1kHz, default format, stereo, 1024 buffer size
     if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 1024) < 0) {
-        std::cerr << "[SDL_mixer] Mix_OpenAudio failed: " << Mix_GetError() << "\n";
+        AERIAL_ERROR("SDL_mixer", "Mix_OpenAudio failed: ", Mix_GetError());
         Mix_Quit();
         SDL_Quit();
         return false;
@@ -53,7 +58,7 @@ bool Player::init() {
     Mix_VolumeMusic(percentToSdlVolume(volumePercent_));
 
     initialized_ = true;
-    std::cout << "[DEBUG] Audio initialized.\n";
+    AERIAL_DEBUG("PLAYER", "Audio initialized.");
     return true;
 }
 
@@ -61,7 +66,7 @@ void Player::shutdown() {
     if (!initialized_)
         return;
 
-    std::cout << "[DEBUG] Shutting down audio...\n";
+    AERIAL_DEBUG("PLAYER", "Shutting down audio...");
     Mix_HaltChannel(-1);
     Mix_HaltMusic();
     Mix_CloseAudio();
@@ -79,30 +84,47 @@ void Player::setPlaylist(std::shared_ptr<Playlist> playlist) {
 // ───────────── Playback controls ─────────────
 
 bool Player::playCurrent() {
+    AERIAL_SPAN("Player::playCurrent");
     if (!initialized_ || !playlist_ || playlist_->empty()) {
-        std::cerr << "[ERROR] Cannot play: player not initialized or playlist empty.\n";
+        AERIAL_ERROR("PLAYER", "Cannot play: player not initialized or playlist empty.");
         return false;
     }
 
     const std::string path = playlist_->current();
-    std::cout << "[DEBUG] Attempting to play: " << path << "\n";
-
-    Mix_HaltChannel(-1);
-    Mix_HaltMusic();
+    AERIAL_DEBUG("PLAYER", "Attempting to play: ", path);
+
+    // A gap is only recorded when a track was actually cut off; the first
+    // play after start or stop is not a transition.
+    const bool wasPlaying = Mix_PlayingMusic() != 0;
+    const uint64_t haltedAt = monotonic_ns();
+    {
+        AERIAL_SPAN("Mix_HaltMusic");
+        Mix_HaltMusic();  // music only; other zones play on channels
+    }
 
-    Mix_Music* music = Mix_LoadMUS(path.c_str());
+    Mix_Music* music;
+    {
+        AERIAL_SPAN("Mix_LoadMUS");
+        ScopedTimer loadTimer(metrics().trackLoadSeconds);
+        music = Mix_LoadMUS(path.c_str());
+    }
     if (!music) {
-        std::cerr << "[SDL_mixer] Failed to load: " << path
-                  << " | " << Mix_GetError() << "\n";
+        AERIAL_ERROR("SDL_mixer", "Failed to load: ", path, " | ", Mix_GetError());
         return false;
     }
 
-    if (Mix_PlayMusic(music, 1) < 0) {
-        std::cerr << "[SDL_mixer] Failed to play: " << path
-                  << " | " << Mix_GetError() << "\n";
+    int played;
+    {
+        AERIAL_SPAN("Mix_PlayMusic");
+        played = Mix_PlayMusic(music, 1);
+    }
+    if (played < 0) {
+        AERIAL_ERROR("SDL_mixer", "Failed to play: ", path, " | ", Mix_GetError());
         Mix_FreeMusic(music);
         return false;
     }
+    if (wasPlaying)
+        metrics().transitionGapSeconds.record(monotonic_ns() - haltedAt);
 
     paused_ = false;
 
@@ -110,7 +132,10 @@ bool Player::playCurrent() {
         (playlist_->size() > 1) ? playlist_->peekNext() : "(end of playlist)";
 
     // UI layer handles formatting + colors
-    printNowPlayingBox(path, nextTrack);
+    {
+        AERIAL_SPAN("printNowPlayingBox");
+        printNowPlayingBox(path, nextTrack);
+    }
 
     return true;
 }
@@ -194,7 +219,7 @@ bool Player::seekTo(double seconds) {
         seconds = 0.0;
 
     if (Mix_SetMusicPosition(seconds) < 0) {
-        std::cerr << "[SDL_mixer] seekTo failed: " << Mix_GetError() << "\n";
+        AERIAL_ERROR("SDL_mixer", "seekTo failed: ", Mix_GetError());
         return false;
     }
 
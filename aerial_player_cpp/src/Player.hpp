@@ -10,7 +10,9 @@ public:
     Player();
     ~Player();
 
-    bool init();
+    // audioDriver: SDL audio driver to use instead of SDL's default choice,
+    // e.g. "dummy" to run without a sound device.
+    bool init(const char* audioDriver = nullptr);
     void shutdown();
 
     // Attach a playlist to this player
@@ -1,9 +1,48 @@
 #include "Playlist.hpp"
+#include "Trace.hpp"
 #include <stdexcept>
 #include <algorithm>
+#include <cctype>
+
+// Recently current tracks remembered for previous() in smart-shuffle mode.
+static const size_t kShuffleHistory = 256;
+
+std::string_view Playlist::displayTitle(std::string_view path) {
+#ifdef _WIN32
+    const size_t slash = path.find_last_of("/\\");
+#else
+    const size_t slash = path.rfind('/');
+#endif
+    std::string_view name = slash == std::string_view::npos ? path : path.substr(slash + 1);
+
+    // Remove extension
+    const size_t dot = name.rfind('.');
+    if (dot != std::string_view::npos)
+        name = name.substr(0, dot);
+
+    // Strip numeric prefixes like "01 - ", "07. ", "03 "
+    if (name.size() > 2 &&
+        std::isdigit(static_cast<unsigned char>(name[0])) &&
+        std::isdigit(static_cast<unsigned char>(name[1]))) {
+        size_t pos = 2;
+        if (pos < name.size() && (name[pos] == '-' || name[pos] == '.' || name[pos] == '_'))
+            pos++;
+        if (pos < name.size() && name[pos] == ' ')
+            pos++;
+        name = name.substr(pos);
+    }
+    return name;
+}
 
 void Playlist::addTrack(const std::string& path) {
     tracks_.push_back(path);
+    const std::string_view title = displayTitle(tracks_.back());
+    titles_.push_back({static_cast<uint32_t>(title.data() - tracks_.back().data()),
+                       static_cast<uint32_t>(title.size())});
+    if (shuffle_) {
+        pathIndex_.emplace(path, tracks_.size() - 1);
+        shuffle_->resize(tracks_.size());
+    }
 }
 
 const std::string& Playlist::current() const {
@@ -17,6 +56,33 @@ const std::string& Playlist::next() {
     if (tracks_.empty()) {
         throw std::runtime_error("Playlist is empty");
     }
+    if (!queue_.empty()) {
+        if (shuffle_) {
+            shuffleHistory_.push_back(currentIndex_);
+            if (shuffleHistory_.size() > kShuffleHistory)
+                shuffleHistory_.pop_front();
+        } else if (!playingQueued_) {
+            resumeIndex_ = currentIndex_;
+        }
+        playingQueued_ = true;
+        currentIndex_ = queue_.popFront();
+        return tracks_[currentIndex_];
+    }
+    if (playingQueued_) {
+        playingQueued_ = false;
+        if (!shuffle_) {
+            currentIndex_ = (resumeIndex_ + 1) % tracks_.size();
+            return tracks_[currentIndex_];
+        }
+    }
+    if (shuffle_) {
+        shuffleHistory_.push_back(currentIndex_);
+        if (shuffleHistory_.size() > kShuffleHistory)
+            shuffleHistory_.pop_front();
+        currentIndex_ = upcoming_;
+        upcoming_ = shuffle_->pick(currentIndex_);
+        return tracks_[currentIndex_];
+    }
     currentIndex_ = (currentIndex_ + 1) % tracks_.size();
     return tracks_[currentIndex_];
 }
@@ -25,6 +91,20 @@ const std::string& Playlist::previous() {
     if (tracks_.empty()) {
         throw std::runtime_error("Playlist is empty");
     }
+    if (playingQueued_ && !shuffle_) {
+        // Back out of the queue to the track it interrupted.
+        playingQueued_ = false;
+        currentIndex_ = resumeIndex_;
+        return tracks_[currentIndex_];
+    }
+    playingQueued_ = false;
+    if (shuffle_ && !shuffleHistory_.empty()) {
+        // Going forward again returns to the track we just left.
+        upcoming_ = currentIndex_;
+        currentIndex_ = shuffleHistory_.back();
+        shuffleHistory_.pop_back();
+        return tracks_[currentIndex_];
+    }
     if (currentIndex_ == 0) {
         currentIndex_ = tracks_.size() - 1;
     } else {
@@ -47,8 +127,14 @@ size_t Playlist::index() const {
 
 std::string Playlist::peekNext() const {
     if (tracks_.empty()) return "";
-    size_t nextIndex = (currentIndex_ + 1) % tracks_.size();
-    return tracks_[nextIndex];
+    return tracks_[peekNextIndex()];
+}
+
+size_t Playlist::peekNextIndex() const {
+    if (tracks_.empty()) return 0;
+    if (!queue_.empty()) return queue_.at(0);
+    if (shuffle_) return upcoming_;
+    return ((playingQueued_ ? resumeIndex_ : currentIndex_) + 1) % tracks_.size();
 }
 
 // ───────── NEW STUFF ─────────
@@ -61,6 +147,7 @@ const std::string& Playlist::trackAt(size_t i) const {
 }
 
 std::vector<size_t> Playlist::search(const std::string& query) const {
+    AERIAL_SPAN("Playlist::search");
     std::vector<size_t> result;
     if (query.empty()) return result;
 
@@ -68,19 +155,67 @@ std::vector<size_t> Playlist::search(const std::string& query) const {
     std::transform(qLower.begin(), qLower.end(), qLower.begin(), ::tolower);
 
     for (size_t i = 0; i < tracks_.size(); ++i) {
-        std::string name = tracks_[i];
-        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
-        if (name.find(qLower) != std::string::npos) {
+        if (trackMatches(i, qLower)) {
             result.push_back(i);
         }
     }
     return result;
 }
 
+bool Playlist::trackMatches(size_t i, std::string_view lowerQuery) const {
+    const std::string& name = tracks_[i];
+    if (lowerQuery.empty()) return true;
+    if (name.size() < lowerQuery.size()) return false;
+
+    const size_t last = name.size() - lowerQuery.size();
+    for (size_t start = 0; start <= last; ++start) {
+        size_t k = 0;
+        while (k < lowerQuery.size() &&
+               std::tolower(static_cast<unsigned char>(name[start + k])) == lowerQuery[k]) {
+            ++k;
+        }
+        if (k == lowerQuery.size()) return true;
+    }
+    return false;
+}
+
 void Playlist::jumpTo(size_t i) {
     if (tracks_.empty()) return;
     if (i >= tracks_.size()) {
         throw std::out_of_range("jumpTo index out of range");
     }
     currentIndex_ = i;
+    playingQueued_ = false;
+    if (shuffle_ && upcoming_ == i)
+        upcoming_ = shuffle_->pick(i);
+}
+
+// ───────── Smart shuffle ─────────
+
+void Playlist::enableSmartShuffle(size_t cooldown) {
+    if (shuffle_) {
+        shuffle_->setCooldown(cooldown);
+        return;
+    }
+    pathIndex_.reserve(tracks_.size());
+    for (size_t i = 0; i < tracks_.size(); ++i)
+        pathIndex_.emplace(tracks_[i], i);
+
+    shuffle_ = std::make_unique<SmartShuffle>(cooldown);
+    shuffle_->resize(tracks_.size());
+    shuffleHistory_.clear();
+    upcoming_ = tracks_.empty() ? 0 : shuffle_->pick(currentIndex_);
+}
+
+void Playlist::disableSmartShuffle() {
+    shuffle_.reset();
+    pathIndex_.clear();
+    shuffleHistory_.clear();
+}
+
+bool Playlist::indexOf(const std::string& path, size_t& out) const {
+    auto it = pathIndex_.find(path);
+    if (it == pathIndex_.end()) return false;
+    out = it->second;
+    return true;
 }
@@ -1,7 +1,15 @@
 #pragma once
+#include <cstdint>
+#include <deque>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
+#include "PlayQueue.hpp"
+#include "SmartShuffle.hpp"
+
 class Playlist {
 public:
     void addTrack(const std::string& path);
@@ -13,13 +21,66 @@ public:
     size_t index() const;
 
     std::string peekNext() const;
+    size_t peekNextIndex() const;  // 0 when empty
+
+    // Display title of track i (i < size()): the file name without its
+    // extension or a leading track number. Computed once when the track
+    // is added and viewed in place inside the stored path.
+    std::string_view title(size_t i) const {
+        const TitleSpan& t = titles_[i];
+        return std::string_view(tracks_[i]).substr(t.offset, t.length);
+    }
+    std::string_view currentTitle() const { return empty() ? std::string_view() : title(currentIndex_); }
+    std::string_view peekNextTitle() const { return empty() ? std::string_view() : title(peekNextIndex()); }
+
+    // The title rule itself, for paths that are not in a playlist;
+    // returns a view into `path`.
+    static std::string_view displayTitle(std::string_view path);
 
     // NEW: access + search + jump
     const std::string& trackAt(size_t i) const;
     std::vector<size_t> search(const std::string& query) const;
     void jumpTo(size_t i);
 
+    // Case-insensitive substring match of track i against an already
+    // lower-cased query; no allocation, so callers can stream results.
+    bool trackMatches(size_t i, std::string_view lowerQuery) const;
+
+    // Smart shuffle: next() draws from a history-weighted SmartShuffle
+    // instead of advancing, and previous() steps back through the tracks
+    // it drew. Enable after the folder scan; tracks added later are
+    // appended to the shuffle one at a time.
+    void enableSmartShuffle(size_t cooldown);
+    void disableSmartShuffle();
+    SmartShuffle* smartShuffle() { return shuffle_.get(); }  // null when off
+
+    // Up next: tracks queued here play before the normal order (or
+    // shuffle) resumes. next() takes them from the front; once the queue
+    // runs dry, the normal order carries on from where it was left.
+    PlayQueue& queue() { return queue_; }
+    const PlayQueue& queue() const { return queue_; }
+
+    // Path -> index, available while smart shuffle is on (the map is
+    // only built for it).
+    bool indexOf(const std::string& path, size_t& out) const;
+
 private:
+    // Where the title sits inside the track's path.
+    struct TitleSpan {
+        uint32_t offset = 0;
+        uint32_t length = 0;
+    };
+
     std::vector<std::string> tracks_;
+    std::vector<TitleSpan> titles_;  // parallel to tracks_
     size_t currentIndex_ = 0;
+
+    std::unique_ptr<SmartShuffle> shuffle_;
+    std::unordered_map<std::string, size_t> pathIndex_;
+    std::deque<size_t> shuffleHistory_;  // previously current, newest last
+    size_t upcoming_ = 0;                // drawn ahead so peekNext() can show it
+
+    PlayQueue queue_;
+    bool playingQueued_ = false;  // current came from queue_; the order
+    size_t resumeIndex_ = 0;      // resumes after this index
 };
@@ -0,0 +1,125 @@
+#include "DB.hpp"
+#include "Log.hpp"
+#include <sqlite3.h>
+#include <algorithm>
+#include <ctime>
+
+/*
+ * Retention for PlayDatabase.
+ *
+ * With retention_days set, the writer thread periodically folds raw
+ * events older than that into track_daily (one row per track per UTC day)
+ * and deletes them. Each transaction handles at most kCompactChunk rows
+ * and only runs while the event queue is empty, so a queued batch waits
+ * behind one chunk at most. track_stats and daily_stats already hold the
+ * totals and are left alone.
+ *
+ * Freed pages go back to the OS through incremental vacuum when the
+ * database was created with auto_vacuum=INCREMENTAL (every database
+ * created since this job was added). Older files keep the pages on the
+ * freelist, where new rows reuse them, so the file still stops growing.
+ */
+
+static const int kCompactChunk = 5000;
+
+void PlayDatabase::compactNow() {
+    compactRequested_ = true;
+    queueCv_.notify_one();
+}
+
+CompactionStats PlayDatabase::compactionStats() const {
+    CompactionStats s;
+    s.runs           = compactRuns_.load();
+    s.eventsRolledUp = compactEventsTotal_.load();
+    s.bytesReclaimed = compactBytesTotal_.load();
+    return s;
+}
+
+// Writer thread, called whenever the event queue is empty.
+void PlayDatabase::runBackgroundStep() {
+    if (legacyPending_) {
+        migrateLegacyChunk();
+        return;
+    }
+    if (retentionDays_ <= 0)
+        return;
+
+    if (!compacting_ &&
+        (compactRequested_.exchange(false) || std::chrono::steady_clock::now() >= nextCompaction_)) {
+        beginCompaction();
+    }
+    if (compacting_ && !compactChunk())
+        finishCompaction();
+}
+
+void PlayDatabase::beginCompaction() {
+    const int64_t today = static_cast<int64_t>(std::time(nullptr)) / 86400;
+    compactCutoff_      = (today - retentionDays_) * 86400;
+    compactPagesBefore_ = queryInt(db_, "PRAGMA page_count;", 0);
+    compactRolled_      = 0;
+    compacting_         = true;
+}
+
+// Rolls up and deletes the next chunk. Returns false once nothing older
+// than the cutoff is left (or on error).
+bool PlayDatabase::compactChunk() {
+    const std::string cutoff = std::to_string(compactCutoff_);
+    const int64_t lastId = queryInt(db_,
+        ("SELECT MAX(id) FROM (SELECT id FROM events WHERE ts < " + cutoff +
+         " ORDER BY id LIMIT " + std::to_string(kCompactChunk) + ");").c_str(), -1);
+    if (lastId < 0)
+        return false;
+
+    const std::string where = " WHERE id <= " + std::to_string(lastId) + " AND ts < " + cutoff;
+    std::string sql =
+        "BEGIN;"
+        "INSERT INTO track_daily (day, track_id, plays, skips, finishes)"
+        "  SELECT ts / 86400 AS day, track_id,"
+        "         SUM(event = 1), SUM(event = 2), SUM(event = 3)"
+        "  FROM events" + where + " GROUP BY day, track_id "
+        "ON CONFLICT(day, track_id) DO UPDATE SET"
+        "  plays    = plays    + excluded.plays,"
+        "  skips    = skips    + excluded.skips,"
+        "  finishes = finishes + excluded.finishes;"
+        "DELETE FROM events" + where + ";";
+
+    if (!execSql(db_, sql.c_str())) {
+        sqlite3_exec(db_, "ROLLBACK;", nullptr, nullptr, nullptr);
+        return false;
+    }
+    const int64_t deleted = sqlite3_changes(db_);
+    if (!execSql(db_, "COMMIT;")) {
+        sqlite3_exec(db_, "ROLLBACK;", nullptr, nullptr, nullptr);
+        return false;
+    }
+    compactRolled_ += static_cast<uint64_t>(deleted);
+
+    // Give this chunk's pages back right away; a no-op unless
+    // auto_vacuum=INCREMENTAL.
+    execSql(db_, "PRAGMA incremental_vacuum;");
+    return true;
+}
+
+void PlayDatabase::finishCompaction() {
+    compacting_     = false;
+    nextCompaction_ = std::chrono::steady_clock::now() + compactInterval_;
+
+    const int64_t pageSize   = queryInt(db_, "PRAGMA page_size;", 0);
+    const int64_t pagesAfter = queryInt(db_, "PRAGMA page_count;", 0);
+    const int64_t freePages  = queryInt(db_, "PRAGMA freelist_count;", 0);
+    const int64_t reclaimed  = std::max<int64_t>(compactPagesBefore_ - pagesAfter, 0) * pageSize;
+
+    compactRuns_ += 1;
+    compactEventsTotal_ += compactRolled_;
+    compactBytesTotal_ += static_cast<uint64_t>(reclaimed);
+
+    if (compactRolled_ == 0)
+        return;
+
+    AERIAL_INFO("DB", "Retention: rolled up ", compactRolled_, " events older than ",
+                retentionDays_, " days; reclaimed ", reclaimed / 1024, " KiB (",
+                compactPagesBefore_ * pageSize / (1024 * 1024), " -> ",
+                pagesAfter * pageSize / (1024 * 1024), " MiB)",
+                freePages > 0 ? ", " + std::to_string(freePages * pageSize / 1024) + " KiB free for reuse"
+                              : std::string());
+}
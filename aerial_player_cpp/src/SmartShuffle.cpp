@@ -0,0 +1,184 @@
+#include "SmartShuffle.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+SmartShuffle::SmartShuffle(size_t cooldown)
+    : cooldown_(cooldown)
+{
+    std::random_device rd;
+    rng_ = (static_cast<uint64_t>(rd()) << 32) ^ rd() ^
+           static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    if (rng_ == 0) rng_ = 0x9E3779B97F4A7C15ull;
+}
+
+double SmartShuffle::weightFor(uint32_t plays, uint32_t skips, uint32_t finishes) {
+    const double kept = static_cast<double>(plays - std::min(skips, plays)) + finishes;
+    const double seen = static_cast<double>(plays) + finishes;
+    return std::max(kMinWeight, (kept + 1.0) / (seen + 2.0));
+}
+
+// xorshift64*: plenty for picking songs, and a few cycles per draw.
+uint64_t SmartShuffle::nextRandom() {
+    rng_ ^= rng_ >> 12;
+    rng_ ^= rng_ << 25;
+    rng_ ^= rng_ >> 27;
+    return rng_ * 0x2545F4914F6CDD1Dull;
+}
+
+// Vose's alias method over w[0..n). Entry i keeps itself with probability
+// prob[i] and otherwise yields alias[i].
+template <typename W, typename A>
+static void build_alias(const W* w, size_t n, float* prob, A* alias,
+                        std::vector<double>& scaled,
+                        std::vector<uint32_t>& small, std::vector<uint32_t>& large)
+{
+    double total = 0.0;
+    for (size_t i = 0; i < n; ++i)
+        total += w[i];
+
+    small.clear();
+    large.clear();
+    scaled.resize(n);
+    const double scale = total > 0.0 ? static_cast<double>(n) / total : 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        scaled[i] = total > 0.0 ? w[i] * scale : 1.0;
+        (scaled[i] < 1.0 ? small : large).push_back(static_cast<uint32_t>(i));
+    }
+
+    while (!small.empty() && !large.empty()) {
+        const uint32_t s = small.back();
+        small.pop_back();
+        const uint32_t l = large.back();
+        prob[s] = static_cast<float>(scaled[s]);
+        alias[s] = static_cast<A>(l);
+        scaled[l] -= 1.0 - scaled[s];
+        if (scaled[l] < 1.0) {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+    // Whatever is left is 1.0 up to rounding.
+    for (uint32_t i : large) { prob[i] = 1.0f; alias[i] = static_cast<A>(i); }
+    for (uint32_t i : small) { prob[i] = 1.0f; alias[i] = static_cast<A>(i); }
+}
+
+// Maps 64 random bits to an entry of an n-entry alias table: the high
+// half picks the column, the low half flips its biased coin.
+template <typename A>
+static size_t sample_alias(uint64_t r, size_t n, const float* prob, const A* alias) {
+    const size_t i = static_cast<size_t>(((r >> 32) * static_cast<uint64_t>(n)) >> 32);
+    const float coin = static_cast<float>(static_cast<uint32_t>(r)) * (1.0f / 4294967296.0f);
+    return coin < prob[i] ? i : static_cast<size_t>(alias[i]);
+}
+
+void SmartShuffle::resize(size_t tracks) {
+    const size_t old = weights_.size();
+    counts_.resize(tracks);
+    weights_.resize(tracks, static_cast<float>(weightFor(0, 0, 0)));
+    prob_.resize(tracks);
+    alias_.resize(tracks);
+    lastPick_.resize(tracks, 0);
+
+    const size_t blocks = (tracks + kBlock - 1) / kBlock;
+    blockTotals_.resize(blocks);
+    for (size_t b = std::min(old, tracks) / kBlock; b < blocks; ++b)
+        buildBlock(b);
+    buildTop();
+}
+
+void SmartShuffle::setHistory(size_t track, uint32_t plays, uint32_t skips, uint32_t finishes) {
+    counts_[track] = {plays, skips, finishes};
+    weights_[track] = static_cast<float>(weightFor(plays, skips, finishes));
+}
+
+void SmartShuffle::rebuild() {
+    for (size_t b = 0; b < blockTotals_.size(); ++b)
+        buildBlock(b);
+    buildTop();
+}
+
+void SmartShuffle::recordPlay(size_t track) {
+    ++counts_[track].plays;
+    updateTrack(track);
+}
+
+void SmartShuffle::recordSkip(size_t track) {
+    ++counts_[track].skips;
+    updateTrack(track);
+}
+
+void SmartShuffle::recordFinish(size_t track) {
+    ++counts_[track].finishes;
+    updateTrack(track);
+}
+
+void SmartShuffle::updateTrack(size_t track) {
+    const Counts& c = counts_[track];
+    const float w = static_cast<float>(weightFor(c.plays, c.skips, c.finishes));
+    if (w == weights_[track])
+        return;
+    weights_[track] = w;
+    buildBlock(track / kBlock);
+    buildTop();
+}
+
+void SmartShuffle::buildBlock(size_t block) {
+    const size_t begin = block * kBlock;
+    const size_t n = std::min(kBlock, weights_.size() - begin);
+    build_alias(&weights_[begin], n, &prob_[begin], &alias_[begin], scaled_, small_, large_);
+
+    double total = 0.0;
+    for (size_t i = begin; i < begin + n; ++i)
+        total += weights_[i];
+    blockTotals_[block] = total;
+}
+
+void SmartShuffle::buildTop() {
+    topProb_.resize(blockTotals_.size());
+    topAlias_.resize(blockTotals_.size());
+    if (!blockTotals_.empty())
+        build_alias(blockTotals_.data(), blockTotals_.size(), topProb_.data(), topAlias_.data(),
+                    scaled_, small_, large_);
+}
+
+bool SmartShuffle::cooling(size_t track, uint64_t window) const {
+    return lastPick_[track] != 0 && picks_ - lastPick_[track] < window;
+}
+
+size_t SmartShuffle::pick(size_t current) {
+    const size_t n = weights_.size();
+    if (n <= 1)
+        return 0;
+
+    const uint64_t window = std::min<uint64_t>(cooldown_, n / 4);
+    size_t track = n;
+    for (int attempt = 0; attempt < 64 && track == n; ++attempt) {
+        const size_t block = sample_alias(nextRandom(), blockTotals_.size(),
+                                          topProb_.data(), topAlias_.data());
+        const size_t begin = block * kBlock;
+        const size_t len = std::min(kBlock, n - begin);
+        const size_t t = begin + sample_alias(nextRandom(), len, &prob_[begin], &alias_[begin]);
+        if (t != current && !cooling(t, window))
+            track = t;
+    }
+
+    // Only reachable when nearly all the weight is cooling down: take the
+    // next eligible track after a random start instead.
+    if (track == n) {
+        const size_t start = static_cast<size_t>(nextRandom() % n);
+        for (size_t k = 0; k < n; ++k) {
+            const size_t t = (start + k) % n;
+            if (t != current && !cooling(t, window)) {
+                track = t;
+                break;
+            }
+        }
+        if (track == n)
+            track = (current + 1) % n;
+    }
+
+    lastPick_[track] = ++picks_;
+    return track;
+}
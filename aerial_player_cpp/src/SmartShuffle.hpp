@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// History-weighted random order for Playlist's smart-shuffle mode.
+//
+// Each track's weight comes from its play/skip counts (weightFor). Picks
+// are drawn from a two-level alias table: tracks are grouped in blocks of
+// kBlock with one alias table each, plus an alias table over the block
+// totals, so a pick is two O(1) draws. A count update rebuilds only its
+// block and the top level, O(kBlock + n / kBlock) — about 2k entries for
+// a 1M-track library — instead of the whole table.
+//
+// Tracks drawn within the last cooldown() picks are rejected and redrawn.
+// Not thread-safe: used through Playlist, whose callers hold
+// control_mutex().
+class SmartShuffle {
+public:
+    static constexpr size_t kBlock = 1024;
+
+    explicit SmartShuffle(size_t cooldown = 50);
+
+    // New tracks start with no history (neutral weight).
+    void resize(size_t tracks);
+    size_t size() const { return weights_.size(); }
+
+    // Bulk load: sets the counts of one track without rebuilding; call
+    // rebuild() once all of them are in.
+    void setHistory(size_t track, uint32_t plays, uint32_t skips, uint32_t finishes);
+    void rebuild();
+
+    // Incremental updates as events are logged.
+    void recordPlay(size_t track);
+    void recordSkip(size_t track);
+    void recordFinish(size_t track);
+
+    // Draws a track other than `current` (unless it is the only one) that
+    // was not drawn within the last cooldown() picks. O(1) expected; the
+    // cooldown is capped at a quarter of the library so redraws stay rare.
+    size_t pick(size_t current);
+
+    void setCooldown(size_t picks) { cooldown_ = picks; }
+    size_t cooldown() const { return cooldown_; }
+    double weight(size_t track) const { return weights_[track]; }
+
+    // Smoothed share of plays that were not skipped: 0.5 for a track with
+    // no history, towards 1 for tracks always played through, floored at
+    // kMinWeight so skipped tracks still come up once in a while.
+    static double weightFor(uint32_t plays, uint32_t skips, uint32_t finishes);
+    static constexpr double kMinWeight = 0.05;
+
+private:
+    struct Counts {
+        uint32_t plays = 0;
+        uint32_t skips = 0;
+        uint32_t finishes = 0;
+    };
+
+    void updateTrack(size_t track);
+    void buildBlock(size_t block);
+    void buildTop();
+    bool cooling(size_t track, uint64_t window) const;
+    uint64_t nextRandom();
+
+    std::vector<Counts>   counts_;
+    std::vector<float>    weights_;
+    std::vector<float>    prob_;      // per block, indexed like weights_
+    std::vector<uint16_t> alias_;     // offset within the block
+    std::vector<double>   blockTotals_;
+    std::vector<float>    topProb_;
+    std::vector<uint32_t> topAlias_;
+    std::vector<uint64_t> lastPick_;  // pick serial, 0 = never picked
+
+    uint64_t picks_ = 0;
+    size_t   cooldown_ = 0;
+    uint64_t rng_ = 0;
+
+    // Scratch for alias construction, kept to avoid per-update allocation.
+    std::vector<double>   scaled_;
+    std::vector<uint32_t> small_;
+    std::vector<uint32_t> large_;
+};
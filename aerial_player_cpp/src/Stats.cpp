@@ -1,53 +1,383 @@
+#include "DB.hpp"
+#include "Log.hpp"
 #include <sqlite3.h>
-#include <string>
-#include <iostream>
 
-bool init_db(sqlite3** db) {
-    int rc = sqlite3_open("aerial.db", db);
-    if (rc != SQLITE_OK) {
-        std::cerr << "Cannot open DB: " << sqlite3_errmsg(*db) << "\n";
+/*
+ * Per-track aggregates for PlayDatabase.
+ *
+ * track_stats holds one row per track with running totals. The writer
+ * thread updates it with an UPSERT in the same transaction as the raw
+ * `events` insert, so reading a track's numbers is a primary-key lookup
+ * no matter how long the event history gets.
+ *
+ * daily_stats does the same per UTC day across all tracks, so per-day
+ * counts over a window cost one row per day rather than one per event.
+ */
+
+// Score weights: a play counts for the track, listening to the end counts
+// a bit more, skipping counts against it.
+static const double kPlayScore   =  3.0;
+static const double kFinishScore =  1.0;
+static const double kSkipScore   = -2.0;
+
+bool PlayDatabase::initStatsSchema() {
+    const char* sql =
+        "CREATE TABLE IF NOT EXISTS track_stats ("
+        "  track_id     INTEGER PRIMARY KEY REFERENCES tracks(id),"
+        "  plays        INTEGER NOT NULL DEFAULT 0,"
+        "  skips        INTEGER NOT NULL DEFAULT 0,"
+        "  finishes     INTEGER NOT NULL DEFAULT 0,"
+        "  last_played  INTEGER,"  // unix seconds
+        "  score        REAL NOT NULL DEFAULT 0"
+        ");"
+        // All-time rankings walk these backwards: no sort, no row scan.
+        "CREATE INDEX IF NOT EXISTS track_stats_plays ON track_stats(plays);"
+        "CREATE INDEX IF NOT EXISTS track_stats_skips ON track_stats(skips);"
+        "CREATE TABLE IF NOT EXISTS daily_stats ("
+        "  day       INTEGER PRIMARY KEY,"  // unix seconds / 86400
+        "  plays     INTEGER NOT NULL DEFAULT 0,"
+        "  skips     INTEGER NOT NULL DEFAULT 0,"
+        "  finishes  INTEGER NOT NULL DEFAULT 0"
+        ");"
+        // Per-track daily totals for events past the retention age
+        // (Retention.cpp); the raw rows are deleted once rolled up here.
+        "CREATE TABLE IF NOT EXISTS track_daily ("
+        "  day       INTEGER NOT NULL,"
+        "  track_id  INTEGER NOT NULL REFERENCES tracks(id),"
+        "  plays     INTEGER NOT NULL DEFAULT 0,"
+        "  skips     INTEGER NOT NULL DEFAULT 0,"
+        "  finishes  INTEGER NOT NULL DEFAULT 0,"
+        "  PRIMARY KEY (day, track_id)"
+        ") WITHOUT ROWID;";
+
+    char* errMsg = nullptr;
+    if (sqlite3_exec(db_, sql, nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        AERIAL_ERROR("DB", "Schema error: ", (errMsg ? errMsg : ""));
+        sqlite3_free(errMsg);
         return false;
     }
+    return true;
+}
 
+// Schema version 2 -> 3: daily_stats is new, events already exist.
+bool PlayDatabase::backfillDailyStats() {
     const char* sql =
-        "CREATE TABLE IF NOT EXISTS song_stats ("
-        "  id INTEGER PRIMARY KEY AUTOINCREMENT,"
-        "  path TEXT UNIQUE,"
-        "  plays INTEGER NOT NULL DEFAULT 0,"
-        "  skips INTEGER NOT NULL DEFAULT 0,"
-        "  searches INTEGER NOT NULL DEFAULT 0,"
-        "  score REAL NOT NULL DEFAULT 0"
-        ");";
+        "INSERT INTO daily_stats (day, plays, skips, finishes)"
+        "  SELECT ts / 86400, SUM(event = 1), SUM(event = 2), SUM(event = 3)"
+        "  FROM events GROUP BY ts / 86400;";
+
+    char* errMsg = nullptr;
+    if (sqlite3_exec(db_, sql, nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        AERIAL_ERROR("DB", "daily_stats backfill failed: ", (errMsg ? errMsg : ""));
+        sqlite3_free(errMsg);
+        return false;
+    }
+    return true;
+}
+
+// Part of a migrateLegacyChunk() transaction: folds the legacy rows with
+// id <= lastId into track_stats and daily_stats before they are deleted, so the totals are
+// complete once the migration finishes without a full scan at startup.
+bool PlayDatabase::migrateLegacyStats(int64_t lastId) {
+    std::string sql =
+        "INSERT INTO track_stats (track_id, plays, skips, finishes, last_played, score)"
+        "  SELECT t.id,"
+        "         SUM(p.event_type = 'play'),"
+        "         SUM(p.event_type = 'skip'),"
+        "         SUM(p.event_type = 'finished'),"
+        "         MAX(CASE WHEN p.event_type = 'play'"
+        "                  THEN CAST(strftime('%s', p.created_at) AS INTEGER) END),"
+        "         SUM(CASE p.event_type"
+        "               WHEN 'play'     THEN " + std::to_string(kPlayScore) +
+        "               WHEN 'finished' THEN " + std::to_string(kFinishScore) +
+        "               WHEN 'skip'     THEN " + std::to_string(kSkipScore) +
+        "               ELSE 0 END)"
+        "  FROM plays_legacy p JOIN tracks t ON t.path = p.track_path"
+        "  WHERE p.id <= " + std::to_string(lastId) + " GROUP BY t.id "
+        "ON CONFLICT(track_id) DO UPDATE SET "
+        "  plays       = plays    + excluded.plays,"
+        "  skips       = skips    + excluded.skips,"
+        "  finishes    = finishes + excluded.finishes,"
+        "  last_played = COALESCE(MAX(last_played, excluded.last_played),"
+        "                         last_played, excluded.last_played),"
+        "  score       = score    + excluded.score;"
+        "INSERT INTO daily_stats (day, plays, skips, finishes)"
+        "  SELECT CAST(strftime('%s', created_at) AS INTEGER) / 86400 AS day,"
+        "         SUM(event_type = 'play'), SUM(event_type = 'skip'), SUM(event_type = 'finished')"
+        "  FROM plays_legacy WHERE id <= " + std::to_string(lastId) + " GROUP BY day "
+        "ON CONFLICT(day) DO UPDATE SET "
+        "  plays    = plays    + excluded.plays,"
+        "  skips    = skips    + excluded.skips,"
+        "  finishes = finishes + excluded.finishes;";
 
     char* errMsg = nullptr;
-    rc = sqlite3_exec(*db, sql, nullptr, nullptr, &errMsg);
-    if (rc != SQLITE_OK) {
-        std::cerr << "DB init error: " << errMsg << "\n";
+    if (sqlite3_exec(db_, sql.c_str(), nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        AERIAL_ERROR("DB", "track_stats migration failed: ", (errMsg ? errMsg : ""));
         sqlite3_free(errMsg);
         return false;
     }
     return true;
 }
 
-void increment_play(sqlite3* db, const std::string& path) {
+// Folds the events with afterId < id <= lastId into track_stats and
+// daily_stats in one pass each; used for rows that were bulk-inserted
+// without the per-event upserts (importHistory).
+bool PlayDatabase::foldEventStats(int64_t afterId, int64_t lastId) {
+    const std::string range =
+        " FROM events WHERE id > " + std::to_string(afterId) + " AND id <= " + std::to_string(lastId);
+    std::string sql =
+        "INSERT INTO track_stats (track_id, plays, skips, finishes, last_played, score)"
+        "  SELECT track_id, SUM(event = 1), SUM(event = 2), SUM(event = 3),"
+        "         MAX(CASE WHEN event = 1 THEN ts END),"
+        "         SUM(CASE event"
+        "               WHEN 1 THEN " + std::to_string(kPlayScore) +
+        "               WHEN 3 THEN " + std::to_string(kFinishScore) +
+        "               WHEN 2 THEN " + std::to_string(kSkipScore) +
+        "               ELSE 0 END)" + range + " GROUP BY track_id "
+        "ON CONFLICT(track_id) DO UPDATE SET "
+        "  plays       = plays    + excluded.plays,"
+        "  skips       = skips    + excluded.skips,"
+        "  finishes    = finishes + excluded.finishes,"
+        "  last_played = COALESCE(MAX(last_played, excluded.last_played),"
+        "                         last_played, excluded.last_played),"
+        "  score       = score    + excluded.score;"
+        "INSERT INTO daily_stats (day, plays, skips, finishes)"
+        "  SELECT ts / 86400 AS day, SUM(event = 1), SUM(event = 2), SUM(event = 3)" +
+        range + " GROUP BY day "
+        "ON CONFLICT(day) DO UPDATE SET "
+        "  plays    = plays    + excluded.plays,"
+        "  skips    = skips    + excluded.skips,"
+        "  finishes = finishes + excluded.finishes;";
+
+    char* errMsg = nullptr;
+    if (sqlite3_exec(db_, sql.c_str(), nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        AERIAL_ERROR("DB", "Stats update failed: ", (errMsg ? errMsg : ""));
+        sqlite3_free(errMsg);
+        return false;
+    }
+    return true;
+}
+
+bool PlayDatabase::prepareStatsStatements() {
+    // ?2..?4 are 0/1 deltas; last_played only moves on a play.
     const char* sql =
-        "INSERT INTO song_stats(path, plays, score) "
-        "VALUES(?1, 1, 3.0) "
-        "ON CONFLICT(path) DO UPDATE SET "
-        "  plays  = plays + 1,"
-        "  score  = score + 3.0;";
+        "INSERT INTO track_stats (track_id, plays, skips, finishes, last_played, score) "
+        "VALUES (?1, ?2, ?3, ?4, CASE WHEN ?2 > 0 THEN ?5 END, ?6) "
+        "ON CONFLICT(track_id) DO UPDATE SET "
+        "  plays       = plays    + excluded.plays,"
+        "  skips       = skips    + excluded.skips,"
+        "  finishes    = finishes + excluded.finishes,"
+        "  last_played = COALESCE(excluded.last_played, last_played),"
+        "  score       = score    + excluded.score;";
+
+    const char* daily =
+        "INSERT INTO daily_stats (day, plays, skips, finishes) VALUES (?1, ?2, ?3, ?4) "
+        "ON CONFLICT(day) DO UPDATE SET "
+        "  plays    = plays    + excluded.plays,"
+        "  skips    = skips    + excluded.skips,"
+        "  finishes = finishes + excluded.finishes;";
+
+    if (sqlite3_prepare_v3(db_, sql, -1, SQLITE_PREPARE_PERSISTENT,
+                           &upsertStats_, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v3(db_, daily, -1, SQLITE_PREPARE_PERSISTENT,
+                           &upsertDaily_, nullptr) != SQLITE_OK) {
+        AERIAL_ERROR("DB", "prepare failed: ", sqlite3_errmsg(db_));
+        return false;
+    }
+    return true;
+}
+
+// Writer thread, inside the batch transaction. False if either upsert
+// failed; writeBatch then rolls the event back with it.
+bool PlayDatabase::applyStatsDelta(int64_t trackId, const PendingEvent& ev) {
+    const bool play   = ev.event == PlayEvent::Play;
+    const bool skip   = ev.event == PlayEvent::Skip;
+    const bool finish = ev.event == PlayEvent::Finished;
+    const double score = play ? kPlayScore : skip ? kSkipScore : finish ? kFinishScore : 0.0;
+
+    sqlite3_bind_int64(upsertStats_, 1, trackId);
+    sqlite3_bind_int(upsertStats_, 2, play ? 1 : 0);
+    sqlite3_bind_int(upsertStats_, 3, skip ? 1 : 0);
+    sqlite3_bind_int(upsertStats_, 4, finish ? 1 : 0);
+    sqlite3_bind_int64(upsertStats_, 5, ev.timestamp);
+    sqlite3_bind_double(upsertStats_, 6, score);
 
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        std::cerr << "prepare failed: " << sqlite3_errmsg(db) << "\n";
-        return;
+    bool ok = sqlite3_step(upsertStats_) == SQLITE_DONE;
+    if (!ok) {
+        AERIAL_ERROR("DB", "track_stats update failed: ", sqlite3_errmsg(db_));
     }
+    sqlite3_reset(upsertStats_);
+    if (!ok) return false;
 
-    sqlite3_bind_text(stmt, 1, path.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(upsertDaily_, 1, ev.timestamp / 86400);
+    sqlite3_bind_int(upsertDaily_, 2, play ? 1 : 0);
+    sqlite3_bind_int(upsertDaily_, 3, skip ? 1 : 0);
+    sqlite3_bind_int(upsertDaily_, 4, finish ? 1 : 0);
 
-    if (sqlite3_step(stmt) != SQLITE_DONE) {
-        std::cerr << "step failed: " << sqlite3_errmsg(db) << "\n";
+    ok = sqlite3_step(upsertDaily_) == SQLITE_DONE;
+    if (!ok) {
+        AERIAL_ERROR("DB", "daily_stats update failed: ", sqlite3_errmsg(db_));
     }
+    sqlite3_reset(upsertDaily_);
+    return ok;
+}
+
+bool PlayDatabase::getTrackStats(const std::string& trackPath, TrackStats& out) {
+    if (!db_) return false;
+
+    std::lock_guard<std::mutex> lock(readMutex_);
+    sqlite3_bind_text(selectStats_, 1, trackPath.c_str(), -1, SQLITE_STATIC);
+
+    bool found = false;
+    if (sqlite3_step(selectStats_) == SQLITE_ROW) {
+        out.plays    = sqlite3_column_int64(selectStats_, 0);
+        out.skips    = sqlite3_column_int64(selectStats_, 1);
+        out.finishes = sqlite3_column_int64(selectStats_, 2);
+        const unsigned char* last = sqlite3_column_text(selectStats_, 3);
+        out.lastPlayed = last ? reinterpret_cast<const char*>(last) : "";
+        out.score    = sqlite3_column_double(selectStats_, 4);
+        found = true;
+    }
+    sqlite3_reset(selectStats_);
+    sqlite3_clear_bindings(selectStats_);
+    return found;
+}
+
+// ───────────── History queries (read connection) ─────────────
+
+bool PlayDatabase::prepareStatsQueries(sqlite3* conn) {
+    struct Query { sqlite3_stmt** stmt; const char* sql; };
+    const Query queries[] = {
+        {&selectStats_,
+         "SELECT s.plays, s.skips, s.finishes, datetime(s.last_played, 'unixepoch'), s.score "
+         "FROM tracks t JOIN track_stats s ON s.track_id = t.id WHERE t.path = ?;"},
+        {&selectTopPlays_,
+         "SELECT t.path, t.title, s.plays FROM track_stats s "
+         "JOIN tracks t ON t.id = s.track_id "
+         "WHERE s.plays > 0 ORDER BY s.plays DESC LIMIT ?1;"},
+        {&selectTopSkips_,
+         "SELECT t.path, t.title, s.skips FROM track_stats s "
+         "JOIN tracks t ON t.id = s.track_id "
+         "WHERE s.skips > 0 ORDER BY s.skips DESC LIMIT ?1;"},
+        // ?2 = event code, [?3, ?4) = window. Days already rolled up by
+        // the retention job come from track_daily, at whole-day precision.
+        {&selectTopWindow_,
+         "SELECT t.path, t.title, c.n FROM ("
+         "  SELECT track_id, SUM(n) AS n FROM ("
+         "    SELECT track_id, COUNT(*) AS n FROM events"
+         "    WHERE event = ?2 AND ts >= ?3 AND ts < ?4 GROUP BY track_id"
+         "    UNION ALL"
+         "    SELECT track_id, CASE ?2 WHEN 1 THEN plays WHEN 2 THEN skips ELSE finishes END"
+         "    FROM track_daily WHERE day >= ?3 / 86400 AND day * 86400 < ?4"
+         "  ) GROUP BY track_id ORDER BY n DESC LIMIT ?1"
+         ") c JOIN tracks t ON t.id = c.track_id ORDER BY c.n DESC;"},
+        {&selectRecent_,
+         "SELECT t.path, t.title, e.ts FROM events e "
+         "JOIN tracks t ON t.id = e.track_id "
+         "WHERE e.event = 1 ORDER BY e.ts DESC LIMIT ?1;"},
+        // Days overlapping [?1, ?2).
+        {&selectDaily_,
+         "SELECT day, plays, skips, finishes FROM daily_stats "
+         "WHERE day >= ?1 / 86400 AND day * 86400 < ?2 ORDER BY day;"},
+        {&selectAllStats_,
+         "SELECT t.path, s.plays, s.skips, s.finishes, s.score FROM track_stats s "
+         "JOIN tracks t ON t.id = s.track_id;"},
+    };
+
+    for (const Query& q : queries) {
+        if (sqlite3_prepare_v3(conn, q.sql, -1, SQLITE_PREPARE_PERSISTENT,
+                               q.stmt, nullptr) != SQLITE_OK) {
+            AERIAL_ERROR("DB", "prepare failed: ", sqlite3_errmsg(conn));
+            return false;
+        }
+    }
+    return true;
+}
+
+static std::string columnString(sqlite3_stmt* stmt, int col) {
+    const unsigned char* text = sqlite3_column_text(stmt, col);
+    return text ? reinterpret_cast<const char*>(text) : "";
+}
+
+// Steps `stmt` to completion, then resets it. Returns false on error.
+template <typename RowFn>
+static bool readRows(sqlite3_stmt* stmt, RowFn&& onRow) {
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+        onRow(stmt);
+    sqlite3_reset(stmt);
+    return rc == SQLITE_DONE;
+}
+
+bool PlayDatabase::rankTracks(sqlite3_stmt* allTime, PlayEvent event, size_t limit,
+                              const StatsWindow& window, std::vector<TrackCount>& out) {
+    out.clear();
+    if (!db_) return false;
+
+    std::lock_guard<std::mutex> lock(readMutex_);
+    sqlite3_stmt* stmt = window.all() ? allTime : selectTopWindow_;
+    sqlite3_bind_int64(stmt, 1, static_cast<int64_t>(limit));
+    if (!window.all()) {
+        sqlite3_bind_int(stmt, 2, static_cast<int>(event));
+        sqlite3_bind_int64(stmt, 3, window.from);
+        sqlite3_bind_int64(stmt, 4, window.to);
+    }
+
+    return readRows(stmt, [&](sqlite3_stmt* row) {
+        out.push_back({columnString(row, 0), columnString(row, 1),
+                       sqlite3_column_int64(row, 2)});
+    });
+}
+
+bool PlayDatabase::topPlayed(size_t limit, const StatsWindow& window,
+                             std::vector<TrackCount>& out) {
+    return rankTracks(selectTopPlays_, PlayEvent::Play, limit, window, out);
+}
+
+bool PlayDatabase::mostSkipped(size_t limit, const StatsWindow& window,
+                               std::vector<TrackCount>& out) {
+    return rankTracks(selectTopSkips_, PlayEvent::Skip, limit, window, out);
+}
+
+bool PlayDatabase::recentlyPlayed(size_t limit, std::vector<RecentPlay>& out) {
+    out.clear();
+    if (!db_) return false;
+
+    std::lock_guard<std::mutex> lock(readMutex_);
+    sqlite3_bind_int64(selectRecent_, 1, static_cast<int64_t>(limit));
+    return readRows(selectRecent_, [&](sqlite3_stmt* row) {
+        out.push_back({columnString(row, 0), columnString(row, 1),
+                       sqlite3_column_int64(row, 2)});
+    });
+}
+
+bool PlayDatabase::dailyCounts(const StatsWindow& window, std::vector<DayCount>& out) {
+    out.clear();
+    if (!db_) return false;
+
+    std::lock_guard<std::mutex> lock(readMutex_);
+    sqlite3_bind_int64(selectDaily_, 1, window.from);
+    sqlite3_bind_int64(selectDaily_, 2, window.to);
+    return readRows(selectDaily_, [&](sqlite3_stmt* row) {
+        out.push_back({sqlite3_column_int64(row, 0) * 86400, sqlite3_column_int64(row, 1),
+                       sqlite3_column_int64(row, 2), sqlite3_column_int64(row, 3)});
+    });
+}
+
+bool PlayDatabase::forEachTrackStats(const std::function<void(const std::string& path,
+                                                              const TrackStats& stats)>& fn) {
+    if (!db_) return false;
 
-    sqlite3_finalize(stmt);
+    std::lock_guard<std::mutex> lock(readMutex_);
+    std::string path;
+    TrackStats stats;
+    return readRows(selectAllStats_, [&](sqlite3_stmt* row) {
+        const unsigned char* text = sqlite3_column_text(row, 0);
+        path.assign(text ? reinterpret_cast<const char*>(text) : "");
+        stats.plays    = sqlite3_column_int64(row, 1);
+        stats.skips    = sqlite3_column_int64(row, 2);
+        stats.finishes = sqlite3_column_int64(row, 3);
+        stats.score    = sqlite3_column_double(row, 4);
+        fn(path, stats);
+    });
 }
@@ -0,0 +1,332 @@
+#include "StatusArea.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+// Without a request the source is polled this often; enough for a
+// progress bar that moves once a second.
+static const std::chrono::milliseconds kIdleTick(250);
+
+// Unchanged cells shorter than this between two changed runs are
+// rewritten rather than skipped: a cursor move costs about as much.
+static const size_t kMaxGap = 6;
+
+// Never produced by put()/fill(); forces a cell to be rewritten.
+static const uint32_t kUnknownGlyph = 0;
+
+// ───────────── StatusFrame ─────────────
+
+void StatusFrame::resize(size_t rows, size_t cols) {
+    rows_ = rows;
+    cols_ = cols;
+    cells_.assign(rows * cols, Cell());
+}
+
+void StatusFrame::clear() {
+    std::fill(cells_.begin(), cells_.end(), Cell());
+}
+
+void StatusFrame::markUnknown() {
+    for (Cell& c : cells_) c.glyph = kUnknownGlyph;
+}
+
+size_t StatusFrame::put(size_t row, size_t col, std::string_view text, Color color) {
+    if (row >= rows_) return col;
+    size_t i = 0;
+    while (i < text.size() && col < cols_) {
+        const unsigned char lead = static_cast<unsigned char>(text[i]);
+        if (lead == '\r' || lead == '\n') break;
+
+        size_t len = lead < 0x80 ? 1 : lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 0;
+        uint32_t glyph = 0;
+        if (len == 0 || i + len > text.size()) {
+            glyph = '?';  // stray continuation byte or cut-off sequence
+            len = 1;
+        } else {
+            for (size_t k = 0; k < len; ++k)
+                glyph |= static_cast<uint32_t>(static_cast<unsigned char>(text[i + k])) << (8 * k);
+        }
+        if (lead < 0x20) glyph = ' ';  // tabs and other controls
+
+        cells_[row * cols_ + col] = {glyph, color};
+        i += len;
+        ++col;
+    }
+    return col;
+}
+
+void StatusFrame::fill(size_t row, size_t col, size_t count, char c, Color color) {
+    if (row >= rows_) return;
+    const size_t end = std::min(cols_, col + count);
+    for (; col < end; ++col)
+        cells_[row * cols_ + col] = {static_cast<unsigned char>(c), color};
+}
+
+// ───────────── StatusArea ─────────────
+
+// The running instance, for requestActiveFrame(); at most one at a time.
+static std::mutex g_activeMutex;
+static StatusArea* g_active = nullptr;
+
+static void append_number(std::string& out, size_t v) {
+    char buf[24];
+    const int n = std::snprintf(buf, sizeof(buf), "%zu", v);
+    out.append(buf, static_cast<size_t>(n));
+}
+
+static void append_move(std::string& out, size_t row, size_t col) {
+    out += "\x1b[";
+    append_number(out, row);
+    out += ';';
+    append_number(out, col);
+    out += 'H';
+}
+
+static void append_color(std::string& out, uint8_t color) {
+    out += "\x1b[";
+    append_number(out, color);
+    out += 'm';
+}
+
+size_t StatusArea::diffFrames(const StatusFrame& prev, const StatusFrame& next,
+                              size_t originRow, std::string& out)
+{
+    size_t rewritten = 0;
+    int color = -1;  // unknown until the first cell sets it
+
+    for (size_t r = 0; r < next.rows(); ++r) {
+        size_t c = 0;
+        while (c < next.cols()) {
+            if (prev.at(r, c) == next.at(r, c)) {
+                ++c;
+                continue;
+            }
+
+            // Extend the run over short stretches of unchanged cells.
+            size_t last = c;
+            for (size_t j = c + 1; j < next.cols() && j - last <= kMaxGap; ++j) {
+                if (prev.at(r, j) != next.at(r, j))
+                    last = j;
+            }
+
+            append_move(out, originRow + r, c + 1);
+            for (; c <= last; ++c) {
+                const StatusFrame::Cell& cell = next.at(r, c);
+                if (cell.color != color) {
+                    append_color(out, cell.color);
+                    color = cell.color;
+                }
+                for (uint32_t g = cell.glyph; g != 0; g >>= 8)
+                    out += static_cast<char>(g & 0xFF);
+                ++rewritten;
+            }
+        }
+    }
+
+    if (color > 0)
+        append_color(out, 0);
+    return rewritten;
+}
+
+StatusArea::StatusArea(size_t rows, int fps)
+    : rows_(rows),
+      intervalUs_(1000000 / std::clamp(fps, 1, 120))
+{
+}
+
+void StatusArea::setFps(int fps) {
+    intervalUs_.store(1000000 / std::clamp(fps, 1, 120), std::memory_order_relaxed);
+}
+
+StatusArea::~StatusArea() {
+    stop();
+}
+
+bool StatusArea::start() {
+    if (running_ || rows_ == 0)
+        return running_;
+
+#ifdef _WIN32
+    if (!_isatty(_fileno(stdout)))
+        return false;
+    HANDLE console = GetStdHandle(STD_OUTPUT_HANDLE);
+    DWORD mode = 0;
+    if (!GetConsoleMode(console, &mode) ||
+        !SetConsoleMode(console, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING))
+        return false;
+#else
+    const char* term = std::getenv("TERM");
+    if (!isatty(STDOUT_FILENO) || !term || std::strcmp(term, "dumb") == 0)
+        return false;
+#endif
+
+    size_t termRows = 0, termCols = 0;
+    if (!querySize(termRows, termCols) || termRows <= rows_ + 1)
+        return false;
+
+    // Make room below the cursor, then fence the bottom rows off from
+    // scrolling.
+    std::string setup(rows_, '\n');
+    setup += "\x1b[";
+    append_number(setup, rows_);
+    setup += "A\x1b" "7\x1b[1;";
+    append_number(setup, termRows - rows_);
+    setup += "r\x1b" "8";
+    writeOut(setup);
+
+    termRows_ = termRows;
+    termCols_ = termCols;
+    shown_.resize(rows_, termCols_);
+    shown_.markUnknown();
+
+    stopping_ = false;
+    requested_ = true;
+    running_ = true;
+    thread_ = std::thread([this]() { run(); });
+
+    std::lock_guard<std::mutex> lock(g_activeMutex);
+    g_active = this;
+    return true;
+}
+
+void StatusArea::stop() {
+    if (!running_)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(g_activeMutex);
+        if (g_active == this)
+            g_active = nullptr;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    thread_.join();
+    running_ = false;
+
+    // Give the whole screen back and leave the cursor under the last
+    // frame, which stays visible.
+    std::string out = "\x1b[r";
+    append_move(out, termRows_, 1);
+    out += '\n';
+    writeOut(out);
+}
+
+void StatusArea::requestFrame() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        requested_ = true;
+    }
+    cv_.notify_one();
+}
+
+bool StatusArea::requestActiveFrame() {
+    std::lock_guard<std::mutex> lock(g_activeMutex);
+    if (!g_active)
+        return false;
+    g_active->requestFrame();
+    return true;
+}
+
+bool StatusArea::setActiveFps(int fps) {
+    std::lock_guard<std::mutex> lock(g_activeMutex);
+    if (!g_active)
+        return false;
+    g_active->setFps(fps);
+    return true;
+}
+
+void StatusArea::run() {
+    auto last = std::chrono::steady_clock::time_point{};
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait_for(lock, kIdleTick, [this]() { return stopping_ || requested_; });
+        if (stopping_)
+            break;
+
+        // Frame-rate cap: a burst of requests (say, a client sending
+        // "next" in a loop) still renders at most once per interval.
+        const auto earliest = last + std::chrono::microseconds(intervalUs_.load(std::memory_order_relaxed));
+        if (std::chrono::steady_clock::now() < earliest &&
+            cv_.wait_until(lock, earliest, [this]() { return stopping_; }))
+            break;
+        requested_ = false;
+        lock.unlock();
+
+        last = std::chrono::steady_clock::now();
+
+        size_t termRows = 0, termCols = 0;
+        if (querySize(termRows, termCols) && (termRows != termRows_ || termCols != termCols_))
+            layout(termRows, termCols);
+
+        if (termRows_ > rows_ + 1 && source_) {
+            next_.resize(rows_, termCols_);
+            source_(next_);
+
+            out_.assign("\x1b" "7");
+            if (diffFrames(shown_, next_, termRows_ - rows_ + 1, out_) > 0) {
+                out_ += "\x1b" "8";
+                writeOut(out_);
+            }
+            std::swap(shown_, next_);
+        }
+
+        lock.lock();
+    }
+}
+
+// After a resize: move the fence, clear the old status rows and redraw
+// every cell on the next frame.
+void StatusArea::layout(size_t termRows, size_t termCols) {
+    termRows_ = termRows;
+    termCols_ = termCols;
+    shown_.resize(rows_, termCols_);
+    shown_.markUnknown();
+
+    std::string out = "\x1b[r";
+    if (termRows_ > rows_ + 1) {
+        out += "\x1b[1;";
+        append_number(out, termRows_ - rows_);
+        out += 'r';
+        append_move(out, termRows_ - rows_ + 1, 1);
+        out += "\x1b[J";
+        append_move(out, termRows_ - rows_, 1);
+    }
+    writeOut(out);
+}
+
+bool StatusArea::querySize(size_t& rows, size_t& cols) const {
+#ifdef _WIN32
+    CONSOLE_SCREEN_BUFFER_INFO info;
+    if (!GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &info))
+        return false;
+    rows = static_cast<size_t>(info.srWindow.Bottom - info.srWindow.Top + 1);
+    cols = static_cast<size_t>(info.srWindow.Right - info.srWindow.Left + 1);
+#else
+    winsize ws{};
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) != 0 || ws.ws_row == 0 || ws.ws_col == 0)
+        return false;
+    rows = ws.ws_row;
+    cols = ws.ws_col;
+#endif
+    return true;
+}
+
+// One fwrite + fflush per frame: stdout's lock keeps it in one piece
+// against console output from other threads.
+void StatusArea::writeOut(const std::string& bytes) const {
+    std::fwrite(bytes.data(), 1, bytes.size(), stdout);
+    std::fflush(stdout);
+}
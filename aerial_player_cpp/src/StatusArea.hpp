@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// One screen's worth of status lines as a grid of cells. A cell holds one
+// UTF-8 code point (packed into 32 bits) and a colour; every code point is
+// assumed to be one column wide.
+class StatusFrame {
+public:
+    enum Color : uint8_t { Default = 0, Green = 32, Yellow = 33, Dim = 90 };
+
+    struct Cell {
+        uint32_t glyph = ' ';  // UTF-8 bytes, first byte lowest
+        uint8_t  color = Default;
+
+        bool operator==(const Cell& o) const { return glyph == o.glyph && color == o.color; }
+        bool operator!=(const Cell& o) const { return !(*this == o); }
+    };
+
+    void resize(size_t rows, size_t cols);
+    size_t rows() const { return rows_; }
+    size_t cols() const { return cols_; }
+
+    // Blanks every cell.
+    void clear();
+
+    // Sets every cell to a value no real cell has, so that diffing
+    // against this frame rewrites all of them.
+    void markUnknown();
+
+    // Writes `text` into `row` from column `col`, clipped to the width;
+    // returns the column after the last cell written. Stops at '\r'/'\n'.
+    size_t put(size_t row, size_t col, std::string_view text, Color color = Default);
+    void fill(size_t row, size_t col, size_t count, char c, Color color = Default);
+
+    const Cell& at(size_t row, size_t col) const { return cells_[row * cols_ + col]; }
+
+private:
+    size_t rows_ = 0;
+    size_t cols_ = 0;
+    std::vector<Cell> cells_;
+};
+
+/*
+   Fixed status area at the bottom of the terminal
+   -----------------------------------------
+   The bottom rows are kept out of the terminal's scroll region, so
+   prompts, command output and log lines scroll above them. A render
+   thread asks the source to fill a StatusFrame at most `fps` times a
+   second and writes only the cells that differ from the last frame, as
+   one write: save cursor, move, recolour, text, restore cursor. A frame
+   where nothing changed writes nothing.
+
+   start() fails when stdout is not a terminal that understands ANSI
+   escapes; callers then keep printing the plain box instead.
+*/
+class StatusArea {
+public:
+    using Source = std::function<void(StatusFrame&)>;
+
+    StatusArea(size_t rows, int fps);
+    ~StatusArea();
+
+    StatusArea(const StatusArea&) = delete;
+    StatusArea& operator=(const StatusArea&) = delete;
+
+    // Called on the render thread with a cleared frame of rows() x width.
+    void setSource(Source source) { source_ = std::move(source); }
+
+    bool start();
+    void stop();
+    bool running() const { return running_; }
+
+    // Renders as soon as the frame-rate cap allows (e.g. on track change)
+    // instead of waiting for the next tick.
+    void requestFrame();
+
+    size_t rows() const { return rows_; }
+
+    // Changes the frame-rate cap; takes effect from the next frame.
+    void setFps(int fps);
+
+    // requestFrame() on the running status area, if there is one.
+    // Returns false when none is running.
+    static bool requestActiveFrame();
+
+    // setFps() on the running status area, if there is one.
+    static bool setActiveFps(int fps);
+
+    // Appends the escape sequences that turn `prev` into `next` on screen,
+    // with the frame's first row at terminal row `originRow` (1-based).
+    // Both frames must have the same size. Returns the cells rewritten.
+    static size_t diffFrames(const StatusFrame& prev, const StatusFrame& next,
+                             size_t originRow, std::string& out);
+
+private:
+    void run();
+    bool querySize(size_t& rows, size_t& cols) const;
+    void layout(size_t termRows, size_t termCols);
+    void writeOut(const std::string& bytes) const;
+
+    const size_t rows_;
+    std::atomic<int64_t> intervalUs_;
+
+    Source source_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool running_ = false;
+    bool stopping_ = false;
+    bool requested_ = false;
+
+    // Render thread only
+    size_t termRows_ = 0;
+    size_t termCols_ = 0;
+    StatusFrame shown_;
+    StatusFrame next_;
+    std::string out_;
+};
@@ -0,0 +1,187 @@
+#include "Trace.hpp"
+
+#include "Log.hpp"
+#include "OutBuffer.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace tracing {
+
+static const size_t kRingSlots = 2048;      // per thread, 48 KiB
+static const size_t kMaxRetiredRings = 64;  // of threads that have exited
+
+// Slots are atomics so the dumping thread may read them while the owner
+// overwrites the oldest; it discards whatever may have been torn.
+struct Slot {
+    std::atomic<uintptr_t> name{0};
+    std::atomic<uint64_t>  start{0};
+    std::atomic<uint64_t>  duration{0};
+};
+
+struct Ring {
+    Slot slots[kRingSlots];
+    std::atomic<uint64_t> head{0};  // spans ever written by the owner
+    std::atomic<const char*> threadName{nullptr};
+    std::atomic<bool> orphaned{false};
+    uint32_t tid = 0;
+};
+
+class Registry {
+public:
+    std::shared_ptr<Ring> attach() {
+        auto ring = std::make_shared<Ring>();
+        std::lock_guard<std::mutex> lock(mutex_);
+        ring->tid = ++nextTid_;
+        rings_.push_back(ring);
+
+        // Short-lived threads (one per TCP client) would otherwise pile up.
+        size_t retired = 0;
+        for (const auto& r : rings_)
+            retired += r->orphaned.load() ? 1 : 0;
+        for (auto it = rings_.begin(); retired > kMaxRetiredRings && it != rings_.end();) {
+            if ((*it)->orphaned.load()) {
+                it = rings_.erase(it);
+                --retired;
+            } else {
+                ++it;
+            }
+        }
+        return ring;
+    }
+
+    std::vector<std::shared_ptr<Ring>> snapshot() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return rings_;
+    }
+
+    const uint64_t epoch = now_ns();  // ts 0 in the trace
+
+private:
+    std::mutex mutex_;
+    std::vector<std::shared_ptr<Ring>> rings_;
+    uint32_t nextTid_ = 0;
+};
+
+// Never destroyed: threads may still record while statics are torn down.
+static Registry& registry() {
+    static Registry* r = new Registry;
+    return *r;
+}
+
+struct ThreadRing {
+    std::shared_ptr<Ring> ring;
+    ~ThreadRing() {
+        if (ring) ring->orphaned.store(true);
+    }
+};
+
+static thread_local ThreadRing t_ring;
+
+static Ring& thread_ring() {
+    if (!t_ring.ring)
+        t_ring.ring = registry().attach();
+    return *t_ring.ring;
+}
+
+void record(const char* name, uint64_t startNs, uint64_t endNs) {
+    Ring& ring = thread_ring();
+    const uint64_t head = ring.head.load(std::memory_order_relaxed);
+    Slot& s = ring.slots[head % kRingSlots];
+    s.name.store(reinterpret_cast<uintptr_t>(name), std::memory_order_relaxed);
+    s.start.store(startNs, std::memory_order_relaxed);
+    s.duration.store(endNs - startNs, std::memory_order_relaxed);
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+void setThreadName(const char* name) {
+    thread_ring().threadName.store(name, std::memory_order_relaxed);
+}
+
+// Microseconds with nanosecond precision, as the trace format expects.
+static void append_micros(OutBuffer& out, uint64_t ns) {
+    out << static_cast<unsigned long long>(ns / 1000) << '.';
+    const unsigned frac = static_cast<unsigned>(ns % 1000);
+    out << static_cast<char>('0' + frac / 100) << static_cast<char>('0' + frac / 10 % 10)
+        << static_cast<char>('0' + frac % 10);
+}
+
+void appendChromeJson(OutBuffer& out) {
+    const uint64_t epoch = registry().epoch;
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+
+    for (const auto& ring : registry().snapshot()) {
+        if (const char* name = ring->threadName.load(std::memory_order_relaxed)) {
+            out << (first ? "" : ",")
+                << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->tid
+                << ",\"args\":{\"name\":\"" << name << "\"}}";
+            first = false;
+        }
+
+        const uint64_t end = ring->head.load(std::memory_order_acquire);
+        const uint64_t begin = end > kRingSlots ? end - kRingSlots : 0;
+        struct Copy { const char* name; uint64_t start, duration; };
+        std::vector<Copy> spans;
+        spans.reserve(static_cast<size_t>(end - begin));
+        for (uint64_t i = begin; i < end; ++i) {
+            const Slot& s = ring->slots[i % kRingSlots];
+            spans.push_back({reinterpret_cast<const char*>(s.name.load(std::memory_order_relaxed)),
+                             s.start.load(std::memory_order_relaxed),
+                             s.duration.load(std::memory_order_relaxed)});
+        }
+
+        // The owner may have lapped us while we copied: span i is only
+        // intact if the writer has not yet started on span i + kRingSlots.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint64_t now = ring->head.load(std::memory_order_relaxed);
+        const uint64_t valid = now >= kRingSlots ? now - kRingSlots + 1 : 0;
+
+        for (uint64_t i = begin; i < end; ++i) {
+            if (i < valid) continue;
+            const Copy& c = spans[static_cast<size_t>(i - begin)];
+            if (!c.name || c.start < epoch) continue;
+            out << (first ? "" : ",")
+                << "{\"name\":\"" << c.name << "\",\"cat\":\"aerial\",\"ph\":\"X\",\"ts\":";
+            append_micros(out, c.start - epoch);
+            out << ",\"dur\":";
+            append_micros(out, c.duration);
+            out << ",\"pid\":1,\"tid\":" << ring->tid << '}';
+            first = false;
+        }
+    }
+    out << "]}\n";
+}
+
+bool writeChromeJson(const std::string& path) {
+    OutBuffer out(1 << 16);
+    appendChromeJson(out);
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return false;
+    const bool ok = std::fwrite(out.data(), 1, out.size(), f) == out.size();
+    return std::fclose(f) == 0 && ok;
+}
+
+static std::string& exit_path() {
+    static std::string* path = new std::string;
+    return *path;
+}
+
+void writeAtExit(const std::string& path) {
+    const bool registered = !exit_path().empty();
+    exit_path() = path;
+    if (registered) return;
+    std::atexit([] {
+        if (writeChromeJson(exit_path()))
+            AERIAL_INFO("TRACE", "Trace written to ", exit_path());
+        else
+            AERIAL_ERROR("TRACE", "Could not write trace to ", exit_path());
+        logging::flush();
+    });
+}
+
+} // namespace tracing
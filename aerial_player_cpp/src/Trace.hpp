@@ -0,0 +1,73 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+class OutBuffer;
+
+/*
+   Scoped trace spans, dumped as Chrome / Perfetto trace JSON
+   -----------------------------------------
+       void Player::playCurrent() {
+           AERIAL_SPAN("Player::playCurrent");
+           ...
+
+   Each thread records finished spans into its own fixed ring (a flight
+   recorder: the newest spans win, nothing blocks, nothing allocates after
+   the thread's first span). The rings are read only when a trace is
+   requested — GET /trace, or at exit with `aerial --trace <file>` — and
+   the result loads directly into chrome://tracing or ui.perfetto.dev.
+
+   Span names must be string literals: only the pointer is stored.
+   Build with AERIAL_TRACE_SPANS=0 to compile every span out.
+*/
+
+#ifndef AERIAL_TRACE_SPANS
+#define AERIAL_TRACE_SPANS 1
+#endif
+
+namespace tracing {
+
+inline uint64_t now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void record(const char* name, uint64_t startNs, uint64_t endNs);
+
+// Label for the calling thread in the trace viewer (a string literal).
+void setThreadName(const char* name);
+
+// {"traceEvents":[...]} with one complete ("X") event per recorded span.
+void appendChromeJson(OutBuffer& out);
+
+// Writes the trace to `path`; false if the file could not be written.
+bool writeChromeJson(const std::string& path);
+
+// Writes the trace to `path` when the process exits normally.
+void writeAtExit(const std::string& path);
+
+class Span {
+public:
+    explicit Span(const char* name) : name_(name), start_(now_ns()) {}
+    ~Span() { record(name_, start_, now_ns()); }
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+private:
+    const char* name_;
+    uint64_t start_;
+};
+
+} // namespace tracing
+
+#define AERIAL_SPAN_CAT2(a, b) a##b
+#define AERIAL_SPAN_CAT(a, b) AERIAL_SPAN_CAT2(a, b)
+
+#if AERIAL_TRACE_SPANS
+#define AERIAL_SPAN(name) ::tracing::Span AERIAL_SPAN_CAT(aerial_span_, __LINE__)(name)
+#else
+#define AERIAL_SPAN(name) ((void)0)
+#endif
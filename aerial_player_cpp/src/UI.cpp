@@ -1,7 +1,7 @@
 #include "UI.hpp"
 #include "Playlist.hpp"
+#include "StatusArea.hpp"
 #include <iostream>
-#include <filesystem>
 #include <cctype>  
 #include <sstream>
 
@@ -15,35 +15,7 @@
 // ==========================================
 std::string extractTitle(const std::string& fullPath) {
     if (fullPath.empty()) return "(none)";
-
-    std::filesystem::path p = std::filesystem::u8path(fullPath);
-    std::string name = p.filename().u8string();
-    
-
-    // Remove extension
-    size_t dot = name.rfind('.');
-    if (dot != std::string::npos)
-        name = name.substr(0, dot);
-
-    // Strip numeric prefixes like "01 - ", "07. ", "03 "
-    if (name.size() > 2 &&
-        std::isdigit((unsigned char)name[0]) &&
-        std::isdigit((unsigned char)name[1]))
-    {
-        size_t pos = 2;
-
-        // Optional punctuation
-        if (pos < name.size() && (name[pos] == '-' || name[pos] == '.' || name[pos] == '_'))
-            pos++;
-
-        // Optional space
-        if (pos < name.size() && name[pos] == ' ')
-            pos++;
-
-        name = name.substr(pos);
-    }
-
-    return name;
+    return std::string(Playlist::displayTitle(fullPath));
 }
 
 
@@ -54,10 +26,13 @@ std::string extractTitle(const std::string& fullPath) {
 void printNowPlayingBox(const std::string& nowPath,
                         const std::string& nextPath)
 {
+    if (StatusArea::requestActiveFrame())
+        return;
+
     const std::string line(69, '*');
 
-    std::string now  = extractTitle(nowPath);
-    std::string next = extractTitle(nextPath);
+    std::string_view now  = nowPath.empty()  ? std::string_view("(none)") : Playlist::displayTitle(nowPath);
+    std::string_view next = nextPath.empty() ? std::string_view("(none)") : Playlist::displayTitle(nextPath);
 
     std::cout << line << "\n";
 
@@ -105,6 +80,9 @@ void printNowPlayingBox(const std::string& nowPath,
 
 
 void updateNowPlayingUI(Playlist& playlist) {
+    if (StatusArea::requestActiveFrame())
+        return;
+
     std::string nowPath;
     std::string nextPath;
 
@@ -122,10 +100,10 @@ std::string renderNowPlayingBox(const std::string& nowPath,
 {
     const std::string line(69, '*');
 
-    std::string now  = extractTitle(nowPath);
-    std::string next = nextPath.empty()
-        ? "(end of playlist)"
-        : extractTitle(nextPath);
+    std::string_view now  = nowPath.empty() ? std::string_view("(none)") : Playlist::displayTitle(nowPath);
+    std::string_view next = nextPath.empty()
+        ? std::string_view("(end of playlist)")
+        : Playlist::displayTitle(nextPath);
 
     std::ostringstream out;
     out << line << "\n";
@@ -152,25 +130,62 @@ std::string renderNowPlayingBox(const std::string& nowPath,
 std::string renderNowPlayingBoxPlain(const std::string& nowPath,
                                      const std::string& nextPath)
 {
-    const std::string line(69, '*');
-
-    std::string now  = nowPath.empty()  ? "(none)"            : extractTitle(nowPath);
-    std::string next = nextPath.empty() ? "(end of playlist)" : extractTitle(nextPath);
+    OutBuffer out(512);
+    appendNowPlayingBoxPlain(out, nowPath, nextPath);
+    return std::string(out.view());
+}
 
-    std::ostringstream out;
+void appendNowPlayingBoxPlain(OutBuffer& out,
+                              const std::string& nowPath,
+                              const std::string& nextPath)
+{
+    appendNowPlayingBoxTitles(out,
+                              nowPath.empty()  ? std::string_view() : Playlist::displayTitle(nowPath),
+                              nextPath.empty() ? std::string_view() : Playlist::displayTitle(nextPath));
+}
 
-    // out << "\r\n=== TELNET UI TEST ===\r\n";   // 👈 BIG TEST MARKER
+void appendNowPlayingBoxTitles(OutBuffer& out,
+                               std::string_view nowTitle,
+                               std::string_view nextTitle)
+{
+    std::string_view now  = nowTitle.empty()  ? std::string_view("(none)")            : nowTitle;
+    std::string_view next = nextTitle.empty() ? std::string_view("(end of playlist)") : nextTitle;
 
-    out << line << "\r\n";
+    out.appendRepeat('*', 69);
+    out << "\r\n";
     out << "****    Now Playing: " << now  << "\r\n";
     out << "****\r\n";
     out << "****    Up Next:     " << next << "\r\n";
-    out << line << "\r\n";
+    out.appendRepeat('*', 69);
+    out << "\r\n";
+}
 
-    return out.str();
+std::string_view NowPlayingCache::get(const Playlist& playlist)
+{
+    size_t index = playlist.empty() ? 0 : playlist.index();
+    size_t next  = playlist.peekNextIndex();
+    size_t size  = playlist.size();
+
+    if (!valid_ || index != index_ || next != next_ || size != size_) {
+        box_.clear();
+        appendNowPlayingBoxTitles(box_, playlist.currentTitle(), playlist.peekNextTitle());
+        index_ = index;
+        next_  = next;
+        size_  = size;
+        valid_ = true;
+    }
+    return box_.view();
 }
 
 std::string renderProgressBar(double positionSeconds)
+{
+    OutBuffer out(64);
+    appendProgressBar(out, positionSeconds);
+    return std::string(out.view());
+}
+
+
+void appendProgressBar(OutBuffer& out, double positionSeconds)
 {
     const int barWidth = 40;
 
@@ -180,20 +195,13 @@ std::string renderProgressBar(double positionSeconds)
     int filled = posInt % (barWidth + 1);
     if (filled > barWidth) filled = barWidth;
 
-    std::ostringstream out;
-
-    out << "[";
-    out << std::string(filled, '=');
+    out << '[';
+    out.appendRepeat('=', static_cast<size_t>(filled));
     if (filled < barWidth) {
-        out << ">";
-        out << std::string(barWidth - filled - 1, ' ');
-    } else {
-        out << std::string(barWidth - filled, ' ');
+        out << '>';
+        out.appendRepeat(' ', static_cast<size_t>(barWidth - filled - 1));
     }
-    out << "]";
-    out << " " << posInt << "s\r\n";
-
-    return out.str();
+    out << "] " << posInt << "s\r\n";
 }
 
 
@@ -218,4 +226,33 @@ std::string renderProgressBarLine(double seconds)
     std::ostringstream oss;
     oss << bar << " " << posInt << "s\r\n";
     return oss.str();
-}
\ No newline at end of file
+}
+
+
+// ==========================================
+//  Status area: box + progress line
+// ==========================================
+void drawNowPlaying(StatusFrame& frame,
+                    std::string_view nowTitle,
+                    std::string_view nextTitle,
+                    double positionSeconds,
+                    bool paused,
+                    int volumePercent)
+{
+    std::string_view now  = nowTitle.empty()  ? std::string_view("(none)")            : nowTitle;
+    std::string_view next = nextTitle.empty() ? std::string_view("(end of playlist)") : nextTitle;
+
+    frame.fill(0, 0, 69, '*');
+    frame.put(1, frame.put(1, 0, "****    Now Playing: "), now, StatusFrame::Green);
+    frame.put(2, 0, "****");
+    frame.put(3, frame.put(3, 0, "****    Up Next:     "), next, StatusFrame::Yellow);
+    frame.fill(4, 0, 69, '*');
+
+    OutBuffer bar(64);
+    appendProgressBar(bar, positionSeconds);
+    size_t col = frame.put(5, 0, bar.view());
+    col = frame.put(5, col + 2, paused ? "paused" : "playing", StatusFrame::Dim);
+    OutBuffer vol(16);
+    vol << "vol " << volumePercent << '%';
+    frame.put(5, col + 2, vol.view(), StatusFrame::Dim);
+}
@@ -1,8 +1,14 @@
 #pragma once
+#include <cstddef>
 #include <string>
+#include <string_view>
+
+#include "OutBuffer.hpp"
 
 class Playlist;
+class StatusFrame;
 
+// While a StatusArea is running these just ask it for a frame.
 void printNowPlayingBox(const std::string& nowPath,
                         const std::string& nextPath);
 
@@ -17,4 +23,45 @@ std::string renderProgressBar(double positionSeconds);
 
 void updateNowPlayingUI(Playlist& playlist);
 
+// Rows drawNowPlaying uses: the box plus a progress line.
+constexpr size_t kNowPlayingRows = 6;
+
+// The now-playing box and a progress line, for a StatusArea source.
+void drawNowPlaying(StatusFrame& frame,
+                    std::string_view nowTitle,
+                    std::string_view nextTitle,
+                    double positionSeconds,
+                    bool paused,
+                    int volumePercent);
+
 std::string renderProgressBarLine(double seconds);
+
+// Allocation-free variants used by the control servers: they append
+// into a caller-owned buffer that is reused across replies.
+void appendNowPlayingBoxPlain(OutBuffer& out,
+                              const std::string& nowPath,
+                              const std::string& nextPath);
+
+// Same box from display titles (Playlist::title); empty views print
+// "(none)" / "(end of playlist)".
+void appendNowPlayingBoxTitles(OutBuffer& out,
+                               std::string_view nowTitle,
+                               std::string_view nextTitle);
+
+void appendProgressBar(OutBuffer& out, double positionSeconds);
+
+// Pre-rendered plain now-playing box. The box only changes when the
+// current or the next track changes (a skip, or a queue edit), so it is
+// re-rendered lazily on that and handed out as a view the rest of the time.
+class NowPlayingCache {
+public:
+    std::string_view get(const Playlist& playlist);
+    void invalidate() { valid_ = false; }
+
+private:
+    bool   valid_ = false;
+    size_t index_ = 0;
+    size_t next_  = 0;
+    size_t size_  = 0;
+    OutBuffer box_{512};
+};
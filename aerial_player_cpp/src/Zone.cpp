@@ -0,0 +1,498 @@
+#include "Zone.hpp"
+#include "Player.hpp"
+#include "Playlist.hpp"
+#include "Log.hpp"
+#include "Metrics.hpp"
+#include "OutBuffer.hpp"
+#include "Trace.hpp"
+#include "json.hpp"
+
+#include <SDL.h>
+#include <SDL_mixer.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <ctime>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// ───────────── Decode cache ─────────────
+
+std::shared_ptr<Mix_Chunk> DecodeCache::get(const std::string& path) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(path);
+        if (it != index_.end()) {
+            ++hits_;
+            lru_.splice(lru_.begin(), lru_, it->second);
+            return it->second->chunk;
+        }
+        ++misses_;
+    }
+
+    Mix_Chunk* raw;
+    {
+        AERIAL_SPAN("Mix_LoadWAV");
+        raw = Mix_LoadWAV(path.c_str());
+    }
+    if (!raw) {
+        AERIAL_ERROR("SDL_mixer", "Failed to decode: ", path, " | ", Mix_GetError());
+        return nullptr;
+    }
+    return insert(path, std::shared_ptr<Mix_Chunk>(raw, Mix_FreeChunk));
+}
+
+std::shared_ptr<Mix_Chunk> DecodeCache::insert(const std::string& path, std::shared_ptr<Mix_Chunk> chunk) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(path);
+    if (it != index_.end()) {
+        // Another zone decoded it meanwhile; share theirs, drop ours.
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return it->second->chunk;
+    }
+
+    const size_t size = chunk->alen;
+    lru_.push_front(Entry{path, chunk, size});
+    index_.emplace(std::string_view(lru_.front().path), lru_.begin());
+    bytes_ += size;
+
+    // Keep at least the track just decoded, however large.
+    while (bytes_ > budget_ && lru_.size() > 1) {
+        const Entry& old = lru_.back();
+        bytes_ -= old.bytes;
+        index_.erase(std::string_view(old.path));
+        lru_.pop_back();
+    }
+    return chunk;
+}
+
+// ───────────── Registry ─────────────
+
+namespace {
+
+struct Zones {
+    std::vector<std::unique_ptr<Zone>> list;  // id - 1
+    std::unique_ptr<DecodeCache> cache;
+    std::unique_ptr<Counter[]> cpuNs;         // by id, main included
+    int bytesPerSecond = 44100 * 2 * 2;       // of decoded audio, from Mix_QuerySpec
+    int frameBytes = 4;
+};
+
+Zones& zones() {
+    static Zones* z = new Zones();
+    return *z;
+}
+
+bool valid_zone_name(std::string_view name) {
+    if (name.empty() || name.size() > 32 || name == "main")
+        return false;
+    for (char c : name) {
+        if (!std::islower(static_cast<unsigned char>(c)) && !std::isdigit(static_cast<unsigned char>(c)) &&
+            c != '-' && c != '_')
+            return false;
+    }
+    return true;
+}
+
+bool equals_nocase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(a[i])) != static_cast<unsigned char>(b[i]))
+            return false;
+    }
+    return true;
+}
+
+} // namespace
+
+void init_zones(std::string_view names, std::shared_ptr<Playlist> library, size_t cacheBytes) {
+    Zones& z = zones();
+
+    std::vector<std::string> wanted;
+    while (!names.empty()) {
+        size_t comma = names.find(',');
+        std::string_view item = names.substr(0, comma);
+        names = comma == std::string_view::npos ? std::string_view() : names.substr(comma + 1);
+
+        while (!item.empty() && std::isspace(static_cast<unsigned char>(item.front()))) item.remove_prefix(1);
+        while (!item.empty() && std::isspace(static_cast<unsigned char>(item.back()))) item.remove_suffix(1);
+        if (item.empty())
+            continue;
+
+        std::string name(item);
+        std::transform(name.begin(), name.end(), name.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (!valid_zone_name(name)) {
+            AERIAL_WARN("ZONE", "Ignoring zone \"", name, "\": use a-z, 0-9, - and _ (and not \"main\")");
+            continue;
+        }
+        if (std::find(wanted.begin(), wanted.end(), name) != wanted.end()) {
+            AERIAL_WARN("ZONE", "Ignoring duplicate zone \"", name, "\"");
+            continue;
+        }
+        wanted.push_back(std::move(name));
+    }
+
+    z.cpuNs.reset(new Counter[wanted.size() + 1]);
+    if (wanted.empty())
+        return;
+
+    int freq = 0;
+    Uint16 format = 0;
+    int channels = 0;
+    if (Mix_QuerySpec(&freq, &format, &channels) && freq > 0 && channels > 0) {
+        z.frameBytes = channels * ((format & 0xFF) / 8);  // SDL_AUDIO_BITSIZE
+        z.bytesPerSecond = freq * z.frameBytes;
+    }
+
+    // Channels 0..n-1 become the zones' buses; reserving them keeps any
+    // Mix_PlayChannel(-1, ...) elsewhere off them.
+    const int count = static_cast<int>(wanted.size());
+    Mix_AllocateChannels(std::max(16, count + 8));
+    Mix_ReserveChannels(count);
+
+    z.cache = std::make_unique<DecodeCache>(cacheBytes);
+    for (int i = 0; i < count; ++i) {
+        z.list.push_back(std::make_unique<Zone>(wanted[i], i, library, *z.cache));
+        AERIAL_INFO("ZONE", "Zone \"", wanted[i], "\" on mixer channel ", i);
+    }
+}
+
+size_t zone_count() {
+    return zones().list.size();
+}
+
+Zone* zone_at(size_t id) {
+    Zones& z = zones();
+    return (id >= 1 && id <= z.list.size()) ? z.list[id - 1].get() : nullptr;
+}
+
+size_t find_zone(std::string_view name) {
+    if (equals_nocase(name, "main"))
+        return kMainZone;
+    const Zones& z = zones();
+    for (size_t i = 0; i < z.list.size(); ++i) {
+        if (equals_nocase(name, z.list[i]->name()))
+            return i + 1;
+    }
+    return kNoZone;
+}
+
+std::string_view zone_name(size_t id) {
+    const Zone* zone = zone_at(id);
+    return zone ? std::string_view(zone->name()) : std::string_view("main");
+}
+
+void add_zone_cpu(size_t id, uint64_t ns) {
+    Zones& z = zones();
+    if (z.cpuNs && id <= z.list.size())
+        z.cpuNs[id].add(ns);
+}
+
+uint64_t thread_cpu_ns() {
+#ifdef _WIN32
+    FILETIME created, exited, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &created, &exited, &kernel, &user))
+        return 0;
+    auto ticks = [](const FILETIME& t) {
+        return (static_cast<uint64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime;
+    };
+    return (ticks(kernel) + ticks(user)) * 100;  // 100 ns units
+#else
+    timespec ts{};
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0)
+        return 0;
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+#endif
+}
+
+// ───────────── Zone ─────────────
+
+Zone::Zone(std::string name, int channel, std::shared_ptr<Playlist> library, DecodeCache& cache)
+    : name_(std::move(name)), channel_(channel), library_(std::move(library)), cache_(cache) {
+    Mix_Volume(channel_, volumePercent_ * MIX_MAX_VOLUME / 100);
+}
+
+Zone::~Zone() {
+    release();
+}
+
+void Zone::release() {
+    Mix_HaltChannel(channel_);
+    if (slice_) {
+        Mix_FreeChunk(slice_);  // QuickLoad chunk: frees the struct, not track_'s samples
+        slice_ = nullptr;
+    }
+    track_.reset();
+}
+
+bool Zone::playCurrent() {
+    AERIAL_SPAN("Zone::playCurrent");
+    if (!library_ || library_->empty()) {
+        AERIAL_ERROR("ZONE", name_, ": cannot play, the library is empty.");
+        return false;
+    }
+
+    // Normally a cache hit, prefetched before the caller took the lock. A
+    // miss (the zone moved on in between, or a batch plays several tracks
+    // on one zone) decodes here; before halting, so the old track keeps
+    // playing meanwhile.
+    const std::string& path = library_->trackAt(cursor_);
+    std::shared_ptr<Mix_Chunk> chunk = cache_.get(path);
+    if (!chunk)
+        return false;
+
+    release();
+    track_ = std::move(chunk);
+    if (!startAt(0.0))
+        return false;
+
+    AERIAL_INFO("ZONE", name_, ": now playing ", library_->title(cursor_));
+    return true;
+}
+
+// Plays track_ from `seconds` in, on this zone's channel.
+bool Zone::startAt(double seconds) {
+    const Zones& z = zones();
+    Mix_HaltChannel(channel_);
+    if (slice_) {
+        Mix_FreeChunk(slice_);
+        slice_ = nullptr;
+    }
+
+    // Compared as a double first: a long seek overflows Uint32.
+    const double bytes = seconds * z.bytesPerSecond;
+    if (bytes >= track_->alen) {
+        startOffset_ = static_cast<double>(track_->alen) / z.bytesPerSecond;
+        paused_ = false;
+        return false;
+    }
+    const Uint32 offset = static_cast<Uint32>(bytes) / z.frameBytes * z.frameBytes;
+
+    Mix_Chunk* chunk = track_.get();
+    if (offset > 0) {
+        slice_ = Mix_QuickLoad_RAW(track_->abuf + offset, track_->alen - offset);
+        if (!slice_) {
+            AERIAL_ERROR("SDL_mixer", name_, ": seek failed: ", Mix_GetError());
+            return false;
+        }
+        chunk = slice_;
+    }
+
+    if (Mix_PlayChannel(channel_, chunk, 0) < 0) {
+        AERIAL_ERROR("SDL_mixer", name_, ": failed to play: ", Mix_GetError());
+        return false;
+    }
+    startedTicks_ = SDL_GetTicks();
+    startOffset_ = static_cast<double>(offset) / z.bytesPerSecond;
+    paused_ = false;
+    return true;
+}
+
+// Same stepping as Playlist::next() / previous() without shuffle.
+bool Zone::playNext() {
+    if (!library_ || library_->empty())
+        return false;
+    if (!queue_.empty()) {
+        if (!playingQueued_)
+            resumeIndex_ = cursor_;
+        playingQueued_ = true;
+        cursor_ = queue_.popFront();
+    } else if (playingQueued_) {
+        playingQueued_ = false;
+        cursor_ = (resumeIndex_ + 1) % library_->size();
+    } else {
+        cursor_ = (cursor_ + 1) % library_->size();
+    }
+    return playCurrent();
+}
+
+bool Zone::playPrevious() {
+    if (!library_ || library_->empty())
+        return false;
+    if (playingQueued_) {
+        playingQueued_ = false;
+        cursor_ = resumeIndex_;
+    } else {
+        cursor_ = (cursor_ == 0 ? library_->size() : cursor_) - 1;
+    }
+    return playCurrent();
+}
+
+bool Zone::jumpTo(size_t index) {
+    if (!library_ || index >= library_->size())
+        return false;
+    cursor_ = index;
+    playingQueued_ = false;
+    return playCurrent();
+}
+
+void Zone::pause() {
+    if (!track_ || paused_)
+        return;
+    startOffset_ = getPositionSeconds();
+    Mix_Pause(channel_);
+    paused_ = true;
+}
+
+void Zone::resume() {
+    if (!paused_)
+        return;
+    Mix_Resume(channel_);
+    startedTicks_ = SDL_GetTicks();
+    paused_ = false;
+}
+
+void Zone::stop() {
+    release();
+    startOffset_ = 0.0;
+    paused_ = false;
+}
+
+bool Zone::isPlaying() const {
+    return track_ && Mix_Playing(channel_) != 0;
+}
+
+std::string Zone::nowPlaying() const {
+    if (!library_ || library_->empty())
+        return {};
+    return library_->trackAt(cursor_);
+}
+
+size_t Zone::peekNextIndex() const {
+    if (!library_ || library_->empty())
+        return 0;
+    if (!queue_.empty())
+        return queue_.at(0);
+    return ((playingQueued_ ? resumeIndex_ : cursor_) + 1) % library_->size();
+}
+
+size_t Zone::peekPreviousIndex() const {
+    if (!library_ || library_->empty())
+        return 0;
+    if (playingQueued_)
+        return resumeIndex_;
+    return (cursor_ == 0 ? library_->size() : cursor_) - 1;
+}
+
+double Zone::getPositionSeconds() const {
+    if (!track_)
+        return 0.0;
+    const Zones& z = zones();
+    double pos = startOffset_;
+    if (!paused_)
+        pos += (SDL_GetTicks() - startedTicks_) / 1000.0;
+    return std::min(pos, static_cast<double>(track_->alen) / z.bytesPerSecond);
+}
+
+bool Zone::seekTo(double seconds) {
+    if (!track_)
+        return false;
+    return startAt(std::max(0.0, seconds));
+}
+
+bool Zone::seekBy(double deltaSeconds) {
+    return seekTo(getPositionSeconds() + deltaSeconds);
+}
+
+void Zone::setVolumePercent(int percent) {
+    volumePercent_ = std::clamp(percent, 0, 100);
+    Mix_Volume(channel_, volumePercent_ * MIX_MAX_VOLUME / 100);
+}
+
+size_t Zone::memoryBytes() const {
+    return track_ ? track_->alen : 0;
+}
+
+// ───────────── Reporting ─────────────
+
+static void append_zone(json::Writer& w, size_t id, const Player& main, const Playlist* library) {
+    const Zones& z = zones();
+    const Zone* zone = zone_at(id);
+    const bool haveTracks = library && !library->empty();
+    const size_t index = zone ? zone->index() : (haveTracks ? library->index() : 0);
+
+    w.beginObject()
+        .field("id", id)
+        .field("name", zone_name(id));
+    w.key("nowPlaying");
+    if (haveTracks)
+        w.value(library->trackAt(index));
+    else
+        w.value("");
+    w.field("index", index)
+        .field("queued", zone ? zone->queue().size() : (library ? library->queue().size() : 0))
+        .field("playing", zone ? zone->isPlaying() : main.isPlaying())
+        .field("paused", zone ? zone->isPaused() : main.isPaused());
+    w.key("position").valueFixed(zone ? zone->getPositionSeconds() : main.getPositionSeconds(), 1);
+    w.field("volume", zone ? zone->getVolumePercent() : main.getVolumePercent());
+    w.key("cpu_seconds").valueFixed(z.cpuNs ? static_cast<double>(z.cpuNs[id].value()) / 1e9 : 0.0, 6);
+    // Main streams through Mix_Music, which holds only a decoder's buffers.
+    w.key("memory_bytes");
+    if (zone)
+        w.value(zone->memoryBytes());
+    else
+        w.null();
+    w.endObject();
+}
+
+void appendZoneJson(OutBuffer& out, size_t id, const Player& main, const Playlist* library) {
+    json::Writer w(out);
+    append_zone(w, id, main, library);
+}
+
+void appendZonesJson(OutBuffer& out, const Player& main, const Playlist* library) {
+    const Zones& z = zones();
+    json::Writer w(out);
+    w.beginObject().key("zones").beginArray();
+    for (size_t id = 0; id <= z.list.size(); ++id)
+        append_zone(w, id, main, library);
+    w.endArray();
+
+    w.key("decode_cache");
+    if (z.cache) {
+        w.beginObject()
+            .field("entries", z.cache->entries())
+            .field("bytes", z.cache->bytes())
+            .field("budget_bytes", z.cache->budget())
+            .field("hits", z.cache->hits())
+            .field("misses", z.cache->misses())
+            .endObject();
+    } else {
+        w.null();
+    }
+    w.endObject();
+}
+
+void appendZoneMetrics(OutBuffer& out) {
+    const Zones& z = zones();
+    char num[32];
+
+    out << "# HELP aerial_zone_cpu_seconds_total CPU time spent running each zone's commands, decoding included.\n"
+        << "# TYPE aerial_zone_cpu_seconds_total counter\n";
+    for (size_t id = 0; id <= z.list.size(); ++id) {
+        std::snprintf(num, sizeof(num), "%.9g", z.cpuNs ? static_cast<double>(z.cpuNs[id].value()) / 1e9 : 0.0);
+        out << "aerial_zone_cpu_seconds_total{zone=\"" << zone_name(id) << "\"} " << std::string_view(num) << '\n';
+    }
+
+    if (!z.cache)
+        return;
+
+    out << "# HELP aerial_zone_memory_bytes Decoded audio held by each zone.\n"
+        << "# TYPE aerial_zone_memory_bytes gauge\n";
+    for (size_t id = 1; id <= z.list.size(); ++id)
+        out << "aerial_zone_memory_bytes{zone=\"" << zone_name(id) << "\"} "
+            << static_cast<unsigned long long>(z.list[id - 1]->memoryBytes()) << '\n';
+
+    out << "# HELP aerial_decode_cache_bytes Decoded audio in the shared zone decode cache.\n"
+        << "# TYPE aerial_decode_cache_bytes gauge\n"
+        << "aerial_decode_cache_bytes " << static_cast<unsigned long long>(z.cache->bytes()) << '\n'
+        << "# HELP aerial_decode_cache_lookups_total Decode cache lookups by result.\n"
+        << "# TYPE aerial_decode_cache_lookups_total counter\n"
+        << "aerial_decode_cache_lookups_total{result=\"hit\"} " << static_cast<unsigned long long>(z.cache->hits()) << '\n'
+        << "aerial_decode_cache_lookups_total{result=\"miss\"} " << static_cast<unsigned long long>(z.cache->misses()) << '\n';
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+#include "PlayQueue.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+class OutBuffer;
+class Player;
+class Playlist;
+struct Mix_Chunk;
+
+/*
+   Zones: several independent players in one process
+   -----------------------------------------
+   Zone 0, "main", is the Player everything has always talked to: the
+   music stream of SDL_mixer. Every zone named in config "zones" plays on
+   a mixer channel of its own, so each has its own track, position,
+   pause state and volume. They all share the single output device that
+   SDL_mixer opens, with one mixer bus per zone.
+
+   All zones read the same Playlist as their library index, so paths and
+   titles exist once, and each keeps its own place in it (next and prev
+   step through it in order; shuffle is main's only) and its own queue.
+   Zone channels play fully decoded chunks from one DecodeCache, so rooms
+   playing the same track decode it once.
+
+   Commands pick a zone with an "@name " prefix ("@kitchen next", see
+   parse_command) or through /zones/<name>/... over HTTP. Zones are
+   created at startup and never removed, so looking one up takes no lock;
+   everything else happens under control_mutex(). Decoding is the slow
+   part, so the front-ends call prefetch_command() before taking the lock:
+   the track a command is about to start is decoded into the cache first
+   and playCurrent() only swaps it in.
+*/
+
+// Decoded tracks, least recently used dropped first once over budget.
+// A chunk still playing in some zone stays alive until that zone lets go.
+// Thread-safe: prefetch_command() fills it without control_mutex().
+class DecodeCache {
+public:
+    explicit DecodeCache(size_t budgetBytes) : budget_(budgetBytes) {}
+
+    // Decodes on a miss, outside the cache's lock; null if SDL_mixer can't
+    // load the file. Two zones missing on the same path at once both
+    // decode, and the second keeps the first one's chunk.
+    std::shared_ptr<Mix_Chunk> get(const std::string& path);
+
+    size_t bytes() const { std::lock_guard<std::mutex> lock(mutex_); return bytes_; }
+    size_t entries() const { std::lock_guard<std::mutex> lock(mutex_); return lru_.size(); }
+    size_t budget() const { return budget_; }
+    uint64_t hits() const { std::lock_guard<std::mutex> lock(mutex_); return hits_; }
+    uint64_t misses() const { std::lock_guard<std::mutex> lock(mutex_); return misses_; }
+
+private:
+    std::shared_ptr<Mix_Chunk> insert(const std::string& path, std::shared_ptr<Mix_Chunk> chunk);
+
+    mutable std::mutex mutex_;
+    struct Entry {
+        std::string path;
+        std::shared_ptr<Mix_Chunk> chunk;
+        size_t bytes;
+    };
+
+    std::list<Entry> lru_;  // most recently used first
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> index_;
+    const size_t budget_;
+    size_t bytes_ = 0;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+};
+
+// A zone other than main: the same controls as Player, on a mixer channel.
+class Zone {
+public:
+    Zone(std::string name, int channel, std::shared_ptr<Playlist> library, DecodeCache& cache);
+    ~Zone();
+
+    Zone(const Zone&) = delete;
+    Zone& operator=(const Zone&) = delete;
+
+    const std::string& name() const { return name_; }
+    int channel() const { return channel_; }
+
+    // These four take the track from the cache, decoding it there and
+    // then, under the caller's lock, only if nothing prefetched it.
+    bool playCurrent();
+    bool playNext();
+    bool playPrevious();
+    bool jumpTo(size_t index);  // and play it
+    void pause();
+    void resume();
+    void stop();
+    bool isPlaying() const;
+    bool isPaused() const { return paused_; }
+
+    std::string nowPlaying() const;
+    size_t index() const { return cursor_; }
+    size_t peekNextIndex() const;      // what playNext() would pick; 0 when empty
+    size_t peekPreviousIndex() const;  // what playPrevious() would pick; 0 when empty
+
+    // Decodes `path` into the shared cache ahead of playing it. Call
+    // without control_mutex(); see prefetch_command().
+    void prefetch(const std::string& path) { cache_.get(path); }
+
+    // Up next for this zone, as Playlist::queue() is for main.
+    PlayQueue& queue() { return queue_; }
+    const PlayQueue& queue() const { return queue_; }
+
+    double getPositionSeconds() const;
+    bool   seekTo(double seconds);
+    bool   seekBy(double deltaSeconds);
+
+    void setVolumePercent(int percent);
+    void changeVolumePercent(int delta) { setVolumePercent(volumePercent_ + delta); }
+    int  getVolumePercent() const { return volumePercent_; }
+
+    // Decoded audio this zone keeps alive; a chunk shared with another
+    // zone counts in both.
+    size_t memoryBytes() const;
+
+private:
+    bool startAt(double seconds);
+    void release();
+
+    const std::string name_;
+    const int channel_;
+    std::shared_ptr<Playlist> library_;
+    DecodeCache& cache_;
+
+    size_t cursor_ = 0;  // index into library_, stepped like Playlist without shuffle
+    PlayQueue queue_;
+    bool playingQueued_ = false;  // cursor_ came from queue_; the order
+    size_t resumeIndex_ = 0;      // resumes after this index
+
+    std::shared_ptr<Mix_Chunk> track_;  // the whole decoded track
+    Mix_Chunk* slice_ = nullptr;        // track_ from the last seek on
+    uint32_t startedTicks_ = 0;         // SDL_GetTicks() when startOffset_ began
+    double startOffset_ = 0.0;          // seconds into the track
+    bool paused_ = false;
+    int volumePercent_ = 100;
+};
+
+constexpr size_t kMainZone = 0;
+constexpr size_t kNoZone = static_cast<size_t>(-1);
+
+// Creates the zones in `names` (comma-separated) after Player::init(),
+// each on its own reserved mixer channel. Bad or duplicate names are
+// skipped with a warning. Call once, before the servers start.
+void init_zones(std::string_view names, std::shared_ptr<Playlist> library, size_t cacheBytes);
+
+// Zones besides main; ids run from 1 to zone_count().
+size_t zone_count();
+Zone* zone_at(size_t id);                  // null for main or an unknown id
+size_t find_zone(std::string_view name);   // kMainZone for "main", kNoZone if unknown
+std::string_view zone_name(size_t id);
+
+// CPU time spent running commands for each zone (decoding included);
+// mixing happens on SDL's audio thread and is not attributed.
+void add_zone_cpu(size_t id, uint64_t ns);
+uint64_t thread_cpu_ns();
+
+// JSON for GET /zones, for GET /zones/<name>/status (one zone) and
+// Prometheus lines for /metrics. The caller holds control_mutex().
+void appendZonesJson(OutBuffer& out, const Player& main, const Playlist* library);
+void appendZoneJson(OutBuffer& out, size_t id, const Player& main, const Playlist* library);
+void appendZoneMetrics(OutBuffer& out);
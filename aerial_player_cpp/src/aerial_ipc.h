@@ -0,0 +1,88 @@
+/*
+   Aerial local control protocol (Unix domain socket)
+   -----------------------------------------
+   Shared by the player (server.cpp) and the C client (tools/aerialctl.c),
+   so it must stay plain C.
+
+   Every message is a frame:
+
+       u32  length      little-endian, bytes that follow (1..AERIAL_IPC_MAX_FRAME)
+       u8   opcode      aerial_ipc_op
+       ...  arguments   opcode-specific
+
+   Replies use the same framing, echo the request opcode and add a status:
+
+       u32  length
+       u8   opcode
+       u8   status      aerial_ipc_status
+       ...  body        STATUS: aerial_ipc_status_body followed by the
+                        current track path (UTF-8, path_len bytes);
+                        everything else: a short UTF-8 ack ("OK next")
+
+   Integers are little-endian. Requests may be pipelined; replies come
+   back in order.
+*/
+#ifndef AERIAL_IPC_H
+#define AERIAL_IPC_H
+
+#include <stdint.h>
+
+#define AERIAL_IPC_MAX_FRAME 4096u
+#define AERIAL_IPC_DEFAULT_SOCKET "/tmp/aerial.sock"
+
+enum aerial_ipc_op {
+    AERIAL_OP_PING    = 0,  /* no args; replies "PONG"           */
+    AERIAL_OP_PLAY    = 1,
+    AERIAL_OP_PAUSE   = 2,
+    AERIAL_OP_RESUME  = 3,
+    AERIAL_OP_NEXT    = 4,
+    AERIAL_OP_PREV    = 5,
+    AERIAL_OP_FF      = 6,
+    AERIAL_OP_REW     = 7,
+    AERIAL_OP_STOP    = 8,
+    AERIAL_OP_SEEK    = 9,  /* i32 position in milliseconds      */
+    AERIAL_OP_VOLUME  = 10, /* i32 percent 0-100                 */
+    AERIAL_OP_JUMP    = 11, /* u32 playlist index                */
+    AERIAL_OP_STATUS  = 12, /* no args                           */
+    AERIAL_OP_TEXT    = 13  /* UTF-8 text command ("vol 40")     */
+};
+
+enum aerial_ipc_status {
+    AERIAL_IPC_OK          = 0,
+    AERIAL_IPC_FAILED      = 1, /* valid request, could not be applied */
+    AERIAL_IPC_BAD_REQUEST = 2  /* unknown opcode or malformed args    */
+};
+
+/* Fixed part of a STATUS reply body (packed, little-endian on the wire). */
+#define AERIAL_IPC_STATUS_BODY_SIZE 16u
+/*
+   u32 index       current playlist index
+   u32 size        playlist size
+   i32 position_ms playback position
+   u8  volume      0-100
+   u8  flags       bit0 = playing, bit1 = paused
+   u16 path_len    bytes of path that follow
+*/
+
+static inline void aerial_ipc_put_u32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static inline uint32_t aerial_ipc_get_u32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void aerial_ipc_put_u16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline uint16_t aerial_ipc_get_u16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+#endif /* AERIAL_IPC_H */
@@ -0,0 +1,361 @@
+#include "json.hpp"
+
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+namespace json {
+
+// ───────────── Reader ─────────────
+
+bool Reader::parse(std::string_view text, Handler& handler) {
+    text_ = text;
+    pos_ = 0;
+    error_ = nullptr;
+    stopped_ = false;
+
+    skipSpace();
+    if (!value(handler, 0)) return false;
+    skipSpace();
+    if (pos_ != text_.size()) return fail("trailing characters after the value");
+    return true;
+}
+
+bool Reader::fail(const char* message) {
+    if (!error_) error_ = message;
+    return false;
+}
+
+bool Reader::stop() {
+    stopped_ = true;
+    return fail("stopped by handler");
+}
+
+void Reader::skipSpace() {
+    while (pos_ < text_.size()) {
+        const char c = text_[pos_];
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r') break;
+        ++pos_;
+    }
+}
+
+bool Reader::literal(std::string_view word) {
+    if (text_.substr(pos_, word.size()) != word) return fail("invalid literal");
+    pos_ += word.size();
+    return true;
+}
+
+bool Reader::value(Handler& h, int depth) {
+    if (pos_ >= text_.size()) return fail("unexpected end of input");
+    switch (text_[pos_]) {
+    case '{': return object(h, depth + 1);
+    case '[': return array(h, depth + 1);
+    case '"': {
+        std::string_view s;
+        if (!string(s)) return false;
+        return h.onString(s) || stop();
+    }
+    case 't': return literal("true") && (h.onBool(true) || stop());
+    case 'f': return literal("false") && (h.onBool(false) || stop());
+    case 'n': return literal("null") && (h.onNull() || stop());
+    default:  return number(h);
+    }
+}
+
+bool Reader::object(Handler& h, int depth) {
+    if (depth > kMaxDepth) return fail("nesting too deep");
+    ++pos_;  // '{'
+    if (!h.onBeginObject()) return stop();
+    skipSpace();
+    if (pos_ < text_.size() && text_[pos_] == '}') {
+        ++pos_;
+        return h.onEndObject() || stop();
+    }
+    while (true) {
+        if (pos_ >= text_.size() || text_[pos_] != '"') return fail("expected a string key");
+        std::string_view key;
+        if (!string(key)) return false;
+        if (!h.onKey(key)) return stop();
+        skipSpace();
+        if (pos_ >= text_.size() || text_[pos_] != ':') return fail("expected ':'");
+        ++pos_;
+        skipSpace();
+        if (!value(h, depth)) return false;
+        skipSpace();
+        if (pos_ >= text_.size()) return fail("unterminated object");
+        if (text_[pos_] == '}') {
+            ++pos_;
+            return h.onEndObject() || stop();
+        }
+        if (text_[pos_] != ',') return fail("expected ',' or '}'");
+        ++pos_;
+        skipSpace();
+    }
+}
+
+bool Reader::array(Handler& h, int depth) {
+    if (depth > kMaxDepth) return fail("nesting too deep");
+    ++pos_;  // '['
+    if (!h.onBeginArray()) return stop();
+    skipSpace();
+    if (pos_ < text_.size() && text_[pos_] == ']') {
+        ++pos_;
+        return h.onEndArray() || stop();
+    }
+    while (true) {
+        if (!value(h, depth)) return false;
+        skipSpace();
+        if (pos_ >= text_.size()) return fail("unterminated array");
+        if (text_[pos_] == ']') {
+            ++pos_;
+            return h.onEndArray() || stop();
+        }
+        if (text_[pos_] != ',') return fail("expected ',' or ']'");
+        ++pos_;
+        skipSpace();
+    }
+}
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static void append_utf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+// On entry text_[pos_] is the opening quote. Strings without escapes are
+// returned as views into the input; the rest are decoded into scratch_.
+bool Reader::string(std::string_view& out) {
+    const size_t start = ++pos_;
+    while (pos_ < text_.size()) {
+        const unsigned char c = static_cast<unsigned char>(text_[pos_]);
+        if (c == '"') {
+            out = text_.substr(start, pos_ - start);
+            ++pos_;
+            return true;
+        }
+        if (c == '\\') break;
+        if (c < 0x20) return fail("control character in string");
+        ++pos_;
+    }
+    if (pos_ >= text_.size()) return fail("unterminated string");
+
+    scratch_.assign(text_.data() + start, pos_ - start);
+    while (pos_ < text_.size()) {
+        const unsigned char c = static_cast<unsigned char>(text_[pos_]);
+        if (c == '"') {
+            ++pos_;
+            out = scratch_;
+            return true;
+        }
+        if (c < 0x20) return fail("control character in string");
+        if (c != '\\') {
+            scratch_ += static_cast<char>(c);
+            ++pos_;
+            continue;
+        }
+        if (++pos_ >= text_.size()) break;
+        switch (text_[pos_++]) {
+        case '"':  scratch_ += '"'; break;
+        case '\\': scratch_ += '\\'; break;
+        case '/':  scratch_ += '/'; break;
+        case 'b':  scratch_ += '\b'; break;
+        case 'f':  scratch_ += '\f'; break;
+        case 'n':  scratch_ += '\n'; break;
+        case 'r':  scratch_ += '\r'; break;
+        case 't':  scratch_ += '\t'; break;
+        case 'u': {
+            auto read_hex4 = [this](uint32_t& cp) {
+                if (pos_ + 4 > text_.size()) return false;
+                cp = 0;
+                for (int i = 0; i < 4; ++i) {
+                    const int d = hex_digit(text_[pos_ + i]);
+                    if (d < 0) return false;
+                    cp = (cp << 4) | static_cast<uint32_t>(d);
+                }
+                pos_ += 4;
+                return true;
+            };
+            uint32_t cp;
+            if (!read_hex4(cp)) return fail("invalid \\u escape");
+            if (cp >= 0xD800 && cp <= 0xDBFF) {
+                uint32_t low;
+                if (text_.substr(pos_, 2) != "\\u") return fail("unpaired surrogate");
+                pos_ += 2;
+                if (!read_hex4(low) || low < 0xDC00 || low > 0xDFFF) return fail("unpaired surrogate");
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+            } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                return fail("unpaired surrogate");
+            }
+            append_utf8(scratch_, cp);
+            break;
+        }
+        default:
+            return fail("invalid escape");
+        }
+    }
+    return fail("unterminated string");
+}
+
+bool Reader::number(Handler& h) {
+    const size_t start = pos_;
+    auto digits = [this] {
+        const size_t from = pos_;
+        while (pos_ < text_.size() && text_[pos_] >= '0' && text_[pos_] <= '9') ++pos_;
+        return pos_ > from;
+    };
+
+    bool integer = true;
+    if (pos_ < text_.size() && text_[pos_] == '-') ++pos_;
+    if (pos_ < text_.size() && text_[pos_] == '0') {
+        ++pos_;
+    } else if (!digits()) {
+        return fail("invalid value");
+    }
+    if (pos_ < text_.size() && text_[pos_] == '.') {
+        ++pos_;
+        if (!digits()) return fail("invalid number");
+        integer = false;
+    }
+    if (pos_ < text_.size() && (text_[pos_] == 'e' || text_[pos_] == 'E')) {
+        ++pos_;
+        if (pos_ < text_.size() && (text_[pos_] == '+' || text_[pos_] == '-')) ++pos_;
+        if (!digits()) return fail("invalid number");
+        integer = false;
+    }
+
+    Number n;
+    n.text = text_.substr(start, pos_ - start);
+    n.integer = false;
+    n.i = 0;
+    if (integer) {
+        auto res = std::from_chars(n.text.data(), n.text.data() + n.text.size(), n.i);
+        n.integer = res.ec == std::errc();
+    }
+    if (n.integer) {
+        n.d = static_cast<double>(n.i);
+    } else {
+        // strtod wants a terminated string; numbers are short.
+        char buf[64];
+        if (n.text.size() < sizeof(buf)) {
+            n.text.copy(buf, n.text.size());
+            buf[n.text.size()] = '\0';
+            n.d = std::strtod(buf, nullptr);
+        } else {
+            n.d = std::strtod(std::string(n.text).c_str(), nullptr);
+        }
+    }
+    return h.onNumber(n) || stop();
+}
+
+bool readFile(const std::string& path, std::string& out) {
+    std::ifstream f(path, std::ios::binary);
+    if (!f) return false;
+    f.seekg(0, std::ios::end);
+    const std::streamoff size = f.tellg();
+    if (size < 0) return false;
+    out.resize(static_cast<size_t>(size));
+    f.seekg(0, std::ios::beg);
+    return static_cast<bool>(f.read(&out[0], size)) || size == 0;
+}
+
+// ───────────── Writer ─────────────
+
+// Length of the valid UTF-8 sequence starting at s[i], or 0 if invalid
+// (overlong, surrogate, out of range or truncated).
+static size_t utf8_sequence(std::string_view s, size_t i) {
+    const unsigned char c = static_cast<unsigned char>(s[i]);
+    size_t len;
+    uint32_t cp;
+    if (c >= 0xC2 && c <= 0xDF)      { len = 2; cp = c & 0x1F; }
+    else if (c >= 0xE0 && c <= 0xEF) { len = 3; cp = c & 0x0F; }
+    else if (c >= 0xF0 && c <= 0xF4) { len = 4; cp = c & 0x07; }
+    else return 0;
+    if (i + len > s.size()) return 0;
+    for (size_t k = 1; k < len; ++k) {
+        const unsigned char cc = static_cast<unsigned char>(s[i + k]);
+        if ((cc & 0xC0) != 0x80) return 0;
+        cp = (cp << 6) | (cc & 0x3F);
+    }
+    if ((len == 3 && (cp < 0x800 || (cp >= 0xD800 && cp <= 0xDFFF))) ||
+        (len == 4 && (cp < 0x10000 || cp > 0x10FFFF)))
+        return 0;
+    return len;
+}
+
+void appendString(OutBuffer& out, std::string_view s) {
+    static const char hex[] = "0123456789abcdef";
+    out << '"';
+    size_t run = 0;  // start of the pending run of bytes copied as-is
+    size_t i = 0;
+    while (i < s.size()) {
+        const unsigned char c = static_cast<unsigned char>(s[i]);
+        if (c >= 0x20 && c < 0x80 && c != '"' && c != '\\') {
+            ++i;
+            continue;
+        }
+        if (c >= 0x80) {
+            const size_t len = utf8_sequence(s, i);
+            if (len) {
+                i += len;
+                continue;
+            }
+        }
+        out.append(s.substr(run, i - run));
+        switch (c) {
+        case '"':  out << "\\\""; break;
+        case '\\': out << "\\\\"; break;
+        case '\n': out << "\\n"; break;
+        case '\r': out << "\\r"; break;
+        case '\t': out << "\\t"; break;
+        default:
+            if (c < 0x20) out << "\\u00" << hex[c >> 4] << hex[c & 0xF];
+            else out << "\\ufffd";  // not valid UTF-8
+        }
+        run = ++i;
+    }
+    out.append(s.substr(run));
+    out << '"';
+}
+
+Writer& Writer::value(double v) {
+    if (!std::isfinite(v)) return null();
+    char buf[32];
+    int n = std::snprintf(buf, sizeof(buf), "%.15g", v);
+    if (std::strtod(buf, nullptr) != v)
+        n = std::snprintf(buf, sizeof(buf), "%.17g", v);
+    separate();
+    out_.append(std::string_view(buf, static_cast<size_t>(n)));
+    return *this;
+}
+
+Writer& Writer::valueFixed(double v, int decimals) {
+    if (!std::isfinite(v)) return null();
+    char buf[64];
+    const int n = std::snprintf(buf, sizeof(buf), "%.*f", decimals, v);
+    separate();
+    out_.append(std::string_view(buf, static_cast<size_t>(n)));
+    return *this;
+}
+
+} // namespace json
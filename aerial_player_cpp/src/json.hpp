@@ -1,186 +1,165 @@
 #pragma once
+
+#include "OutBuffer.hpp"
+
+#include <cstddef>
+#include <cstdint>
 #include <string>
-#include <unordered_map>
-#include <variant>
-#include <vector>
-#include <sstream>
-#include <fstream>
-#include <cctype>
-#include <stdexcept>
+#include <string_view>
 
 /*
-   Minimal JSON parser for Aerial
+   JSON for Aerial: a SAX reader and a streaming writer
    -----------------------------------------
-   Supports:
-     - objects { "k": v }
-     - strings "text"
-     - numbers (int)
-     - booleans (true/false)
-     - contains()
-     - get<T>()
-
-   This is NOT a full JSON implementation — it's only
-   what we need for reading a simple config.json.
+   Reading: derive from json::Handler, override the events you care about
+   and hand it to a json::Reader. Nothing is built in memory; strings and
+   keys arrive as views into the input, or — only when they contain
+   escapes — into a scratch buffer the Reader keeps and reuses, so a
+   long-lived Reader parses without allocating. Views are valid only for
+   the duration of the callback.
+
+       struct Names : json::Handler {
+           bool onString(std::string_view s) override { ...; return true; }
+       };
+       json::Reader reader;
+       Names names;
+       if (!reader.parse(body, names)) ... reader.error(), reader.offset()
+
+   Writing: json::Writer appends straight into an OutBuffer, inserting
+   commas itself and escaping every string (quotes, control characters,
+   and invalid UTF-8, which becomes U+FFFD).
+
+       json::Writer w(out);
+       w.beginObject().field("id", id).field("path", path).endObject();
+
+   Full RFC 8259 grammar: objects, arrays, strings with all escapes
+   (\uXXXX and surrogate pairs decode to UTF-8), numbers with fraction
+   and exponent, true / false / null. Nesting is limited to kMaxDepth.
 */
 
-namespace mini_json {
-
-    struct json {
-        using object = std::unordered_map<std::string, json>;
-        using value = std::variant<std::string, int, bool, object>;
-
-        value data;
-
-        json() = default;
-        json(value v) : data(std::move(v)) {}
-        json(const char* s) : data(std::string(s)) {}
-        json(bool b) : data(b) {}
-        json(int i) : data(i) {}
-
-        // -------------------------------------
-        // Parse from file
-        // -------------------------------------
-        static json parseFile(const std::string& path) {
-            std::ifstream f(path);
-            if (!f.is_open()) {
-                throw std::runtime_error("Could not open JSON file: " + path);
-            }
-            std::stringstream ss;
-            ss << f.rdbuf();
-            return parse(ss.str());
-        }
-
-        // -------------------------------------
-        // Parse from string
-        // -------------------------------------
-        static json parse(const std::string& text) {
-            size_t i = 0;
-            return parseValue(text, i);
-        }
-
-        // -------------------------------------
-        // Object helpers
-        // -------------------------------------
-        bool contains(const std::string& key) const {
-            if (std::holds_alternative<object>(data)) {
-                const auto& obj = std::get<object>(data);
-                return obj.find(key) != obj.end();
-            }
-            return false;
-        }
-
-        const json& operator[](const std::string& key) const {
-            const auto& obj = std::get<object>(data);
-            return obj.at(key);
-        }
-
-        template<typename T>
-        T get() const {
-            if constexpr (std::is_same_v<T, std::string>) {
-                return std::get<std::string>(data);
-            }
-            if constexpr (std::is_same_v<T, int>) {
-                return std::get<int>(data);
-            }
-            if constexpr (std::is_same_v<T, bool>) {
-                return std::get<bool>(data);
-            }
-            throw std::runtime_error("Unsupported json.get<T>() type");
-        }
-
-    private:
-        // -------------------------------------
-        // Parsing internals
-        // -------------------------------------
-        static void skipWS(const std::string& s, size_t& i) {
-            while (i < s.size() && std::isspace(static_cast<unsigned char>(s[i]))) i++;
-        }
-
-        static json parseValue(const std::string& s, size_t& i) {
-            skipWS(s, i);
-            if (i >= s.size())
-                throw std::runtime_error("Unexpected end of JSON");
-
-            char c = s[i];
-            if (c == '{') return parseObject(s, i);
-            if (c == '"') return parseString(s, i);
-            if (std::isdigit(static_cast<unsigned char>(c)) || c == '-') return parseNumber(s, i);
-            if (s.compare(i, 4, "true") == 0)  { i += 4; return json(true); }
-            if (s.compare(i, 5, "false") == 0) { i += 5; return json(false); }
-
-            throw std::runtime_error("Invalid JSON at index " + std::to_string(i));
-        }
-
-        static json parseString(const std::string& s, size_t& i) {
-            if (s[i] != '"')
-                throw std::runtime_error("Expected '\"' at start of string");
-            i++; // skip opening "
-            std::string out;
-            while (i < s.size() && s[i] != '"') {
-                // minimal escape handling: treat \" as "
-                if (s[i] == '\\' && i + 1 < s.size() && s[i+1] == '"') {
-                    out.push_back('"');
-                    i += 2;
-                } else {
-                    out.push_back(s[i++]);
-                }
-            }
-            if (i >= s.size() || s[i] != '"')
-                throw std::runtime_error("Unterminated string in JSON");
-            i++; // skip closing "
-            return json(out);
-        }
-
-        static json parseNumber(const std::string& s, size_t& i) {
-            int sign = 1;
-            if (s[i] == '-') { sign = -1; i++; }
-            int value = 0;
-            bool hasDigit = false;
-            while (i < s.size() && std::isdigit(static_cast<unsigned char>(s[i]))) {
-                hasDigit = true;
-                value = value * 10 + (s[i] - '0');
-                i++;
-            }
-            if (!hasDigit)
-                throw std::runtime_error("Invalid number in JSON");
-            return json(value * sign);
+namespace json {
+
+struct Number {
+    std::string_view text;  // as written in the input
+    bool    integer;        // no fraction or exponent, and fits in int64
+    int64_t i;              // valid when integer
+    double  d;              // always valid
+};
+
+class Handler {
+public:
+    virtual ~Handler() = default;
+
+    // Return false to stop parsing; Reader::parse() then returns false
+    // with stopped() set.
+    virtual bool onNull() { return true; }
+    virtual bool onBool(bool) { return true; }
+    virtual bool onNumber(const Number&) { return true; }
+    virtual bool onString(std::string_view) { return true; }
+    virtual bool onKey(std::string_view) { return true; }
+    virtual bool onBeginObject() { return true; }
+    virtual bool onEndObject() { return true; }
+    virtual bool onBeginArray() { return true; }
+    virtual bool onEndArray() { return true; }
+};
+
+class Reader {
+public:
+    static constexpr int kMaxDepth = 64;
+
+    // Parses exactly one value, optionally surrounded by whitespace.
+    bool parse(std::string_view text, Handler& handler);
+
+    // After a failed parse: what went wrong and the byte offset.
+    const char* error() const { return error_; }
+    size_t offset() const { return pos_; }
+    bool stopped() const { return stopped_; }  // by the handler, not bad input
+
+private:
+    bool value(Handler& h, int depth);
+    bool object(Handler& h, int depth);
+    bool array(Handler& h, int depth);
+    bool string(std::string_view& out);
+    bool number(Handler& h);
+    bool literal(std::string_view word);
+    bool fail(const char* message);
+    bool stop();
+    void skipSpace();
+
+    std::string_view text_;
+    size_t pos_ = 0;
+    const char* error_ = nullptr;
+    bool stopped_ = false;
+    std::string scratch_;  // unescaped strings; reused between parses
+};
+
+// Reads a whole file into `out`; false if it can't be opened or read.
+bool readFile(const std::string& path, std::string& out);
+
+// Appends `s` as a quoted, escaped JSON string.
+void appendString(OutBuffer& out, std::string_view s);
+
+class Writer {
+public:
+    explicit Writer(OutBuffer& out) : out_(out) {}
+
+    Writer& beginObject() { separate(); out_ << '{'; push(); return *this; }
+    Writer& endObject()   { --depth_; out_ << '}'; return *this; }
+    Writer& beginArray()  { separate(); out_ << '['; push(); return *this; }
+    Writer& endArray()    { --depth_; out_ << ']'; return *this; }
+
+    Writer& key(std::string_view k) {
+        separate();
+        appendString(out_, k);
+        out_ << ':';
+        afterKey_ = true;
+        return *this;
+    }
+
+    Writer& value(std::string_view s) { separate(); appendString(out_, s); return *this; }
+    Writer& value(const char* s)      { return value(std::string_view(s)); }
+    Writer& value(const std::string& s) { return value(std::string_view(s)); }
+    Writer& value(bool b)             { separate(); out_ << (b ? "true" : "false"); return *this; }
+    Writer& value(int v)              { separate(); out_ << v; return *this; }
+    Writer& value(long v)             { separate(); out_ << v; return *this; }
+    Writer& value(long long v)        { separate(); out_ << v; return *this; }
+    Writer& value(unsigned v)         { separate(); out_ << v; return *this; }
+    Writer& value(unsigned long v)    { separate(); out_ << v; return *this; }
+    Writer& value(unsigned long long v) { separate(); out_ << v; return *this; }
+    Writer& value(double v);                      // shortest of %.15g / %.17g; NaN/inf as null
+    Writer& valueFixed(double v, int decimals);   // e.g. a score as "12.5"
+    Writer& null()                    { separate(); out_ << "null"; return *this; }
+
+    template <typename T>
+    Writer& field(std::string_view k, const T& v) { return key(k).value(v); }
+
+    // Appends already-serialized JSON as the next value.
+    Writer& raw(std::string_view json) { separate(); out_ << json; return *this; }
+
+    OutBuffer& buffer() { return out_; }
+
+private:
+    void push() {
+        ++depth_;
+        if (depth_ < 64) hasItems_ &= ~(uint64_t(1) << depth_);
+    }
+
+    // A comma before every item but the first at this level; none right
+    // after a key.
+    void separate() {
+        if (afterKey_) {
+            afterKey_ = false;
+            return;
         }
-
-        static json parseObject(const std::string& s, size_t& i) {
-            if (s[i] != '{')
-                throw std::runtime_error("Expected '{' at start of object");
-            i++; // skip '{'
-            skipWS(s, i);
-
-            object obj;
-
-            while (i < s.size() && s[i] != '}') {
-                // key
-                auto keyJson = parseString(s, i);
-                std::string key = keyJson.get<std::string>();
-
-                skipWS(s, i);
-                if (i >= s.size() || s[i] != ':')
-                    throw std::runtime_error("Expected ':' after key");
-                i++; // skip ':'
-
-                // value
-                auto val = parseValue(s, i);
-                obj[key] = val;
-
-                skipWS(s, i);
-                if (i < s.size() && s[i] == ',') {
-                    i++; // skip ','
-                    skipWS(s, i);
-                }
-            }
-
-            if (i >= s.size() || s[i] != '}')
-                throw std::runtime_error("Expected '}' at end of object");
-            i++; // skip '}'
-
-            return json(obj);
-        }
-    };
-
-} // namespace mini_json
+        if (depth_ <= 0 || depth_ >= 64) return;
+        const uint64_t bit = uint64_t(1) << depth_;
+        if (hasItems_ & bit) out_ << ',';
+        hasItems_ |= bit;
+    }
+
+    OutBuffer& out_;
+    uint64_t hasItems_ = 0;  // bit d: level d already has an item
+    int depth_ = 0;
+    bool afterKey_ = false;
+};
+
+} // namespace json
@@ -1,103 +1,316 @@
 #include <iostream>
 #include <memory>
-#include <filesystem>
 #include <vector>
 #include <stdexcept>
-#include <system_error> // for std::error_code
 #include <algorithm>
 #include <atomic>
 #include <thread>
 #include <chrono>
+#include <mutex>
 #include <cctype> // for std::isspace
 #include <sstream> // for parsing "vol 50"
-
-
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <future>
+#include <string_view>
+#include <unordered_set>
+
+#ifndef _WIN32
+#include <cstddef>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "Commands.hpp"
 #include "Config.hpp"
 #include "Player.hpp"
 #include "Playlist.hpp"
-#include "Server.hpp"
+#include "SmartShuffle.hpp"
+#include "StatusArea.hpp"
+#include "server.hpp"
 #include "UI.hpp"
 #include "DB.hpp"
-
-namespace fs = std::filesystem;
+#include "Library.hpp"
+#include "Log.hpp"
+#include "Metrics.hpp"
+#include "OutBuffer.hpp"
+#include "Trace.hpp"
+#include "Zone.hpp"
 
 // ───────────────────────────────
 // Helpers
 // ───────────────────────────────
 
-static bool isAudioFile(const fs::path &path)
+static volatile std::sig_atomic_t g_stopRequested = 0;
+
+static void onStopSignal(int)
 {
-    // Use wide string to avoid ANSI codepage issues
-    auto ext = path.extension().wstring();
-    std::transform(ext.begin(), ext.end(), ext.begin(), ::towlower);
-
-    return ext == L".mp3" ||
-           ext == L".wav" ||
-           ext == L".ogg" ||
-           ext == L".flac" ||
-           ext == L".m4a";
+    g_stopRequested = 1;
 }
 
-std::shared_ptr<Playlist> buildPlaylistFromFolder(const std::string &folderPath)
+// Headless mode has no console to quit from; the servers keep running on
+// their own threads until the process is told to stop.
+static void waitForStopSignal()
 {
-    auto playlist = std::make_shared<Playlist>();
+    std::signal(SIGINT, onStopSignal);
+    std::signal(SIGTERM, onStopSignal);
+    while (!g_stopRequested)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+}
 
-    std::cout << "[DEBUG] Scanning folder: " << folderPath << "\n";
+static void applyLogLevel(const AerialConfig &cfg)
+{
+    LogLevel logLevel;
+    if (logging::parseLevel(cfg.log_level, logLevel))
+        logging::setLevel(logLevel);
+    else
+        AERIAL_WARN("CONFIG", "Unknown log_level '", cfg.log_level, "', using info.");
+}
 
-    // Treat input as UTF-8 and build a filesystem path from it
-    fs::path root = fs::u8path(folderPath);
+// Runs on the config watcher after a reload. The log level and the status
+// area's frame rate are applied here; the TCP and HTTP listeners follow
+// their ports by themselves. Everything else is read once at startup.
+static void applyConfigChange(const AerialConfig &before, const AerialConfig &after)
+{
+    std::string live, restart;
+    for (const char *key : config_changes(before, after))
+    {
+        const std::string_view k = key;
+        const bool applied = k == "log_level" || k == "port" || k == "http_port" ||
+                             (k == "ui_fps" && before.ui_fps > 0 && after.ui_fps > 0);
+        std::string &list = applied ? live : restart;
+        list += list.empty() ? "" : ", ";
+        list += key;
+    }
 
-    std::error_code ec;
+    if (before.log_level != after.log_level)
+        applyLogLevel(after);
+    if (before.ui_fps != after.ui_fps && after.ui_fps > 0)
+        StatusArea::setActiveFps(after.ui_fps);
 
-    if (!fs::exists(root, ec) || ec)
+    AERIAL_INFO("CONFIG", "Reloaded (generation ", config_generation(), ")",
+                live.empty() ? "" : "; applied: ", live);
+    if (!restart.empty())
+        AERIAL_WARN("CONFIG", "Restart to apply: ", restart);
+}
+
+// Tells systemd (Type=notify) how far we got: "READY=1", "STOPPING=1".
+// A no-op unless NOTIFY_SOCKET is set.
+static void notifySystemd(const char *state)
+{
+#ifndef _WIN32
+    const char *socketPath = std::getenv("NOTIFY_SOCKET");
+    if (!socketPath || !*socketPath)
+        return;
+
+    sockaddr_un addr{};
+    const size_t len = std::strlen(socketPath);
+    if (len >= sizeof(addr.sun_path))
+        return;
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, socketPath, len);
+    if (addr.sun_path[0] == '@')
+        addr.sun_path[0] = '\0'; // abstract namespace
+
+    int fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+    if (fd < 0)
+        return;
+    sendto(fd, state, std::strlen(state), 0, reinterpret_cast<sockaddr *>(&addr),
+           static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + len));
+    close(fd);
+#else
+    (void)state;
+#endif
+}
+
+static void recordPhase(StartupPhase phase, uint64_t startNs)
+{
+    metrics().startup(phase).set(static_cast<int64_t>(monotonic_ns() - startNs));
+}
+
+static void logStartup(size_t tracks, bool fromCache)
+{
+    auto ms = [](StartupPhase p) { return static_cast<double>(metrics().startup(p).value()) / 1e6; };
+    AERIAL_INFO("MAIN", "Ready in ", ms(StartupPhase::Ready), " ms: config ", ms(StartupPhase::Config),
+                ", db ", ms(StartupPhase::Database), ", library ", ms(StartupPhase::Library),
+                " (", tracks, fromCache ? " tracks from cache" : " tracks scanned",
+                "), audio ", ms(StartupPhase::Audio), ", servers ", ms(StartupPhase::Servers), " ms");
+}
+
+static DbOptions dbOptionsFromConfig(const AerialConfig &cfg)
+{
+    DbOptions dbOptions = DbOptions::fromProfile(cfg.db_profile);
+    if (!cfg.db_journal_mode.empty())
+        dbOptions.journal_mode = cfg.db_journal_mode;
+    if (!cfg.db_synchronous.empty())
+        dbOptions.synchronous = cfg.db_synchronous;
+    if (cfg.db_cache_kb > 0)
+        dbOptions.cache_size_kb = cfg.db_cache_kb;
+    if (cfg.db_queue_capacity > 0)
+        dbOptions.queue_capacity = static_cast<size_t>(cfg.db_queue_capacity);
+    if (cfg.db_batch_size > 0)
+        dbOptions.batch_size = static_cast<size_t>(cfg.db_batch_size);
+    if (cfg.db_flush_ms > 0)
+        dbOptions.flush_interval_ms = cfg.db_flush_ms;
+    if (!cfg.db_overflow.empty())
+        dbOptions.overflow = cfg.db_overflow;
+    if (cfg.db_retention_days > 0)
+        dbOptions.retention_days = cfg.db_retention_days;
+    return dbOptions;
+}
+
+static std::string libraryCachePath(const AerialConfig &cfg)
+{
+    if (cfg.library_cache == "off")
+        return {};
+    return cfg.library_cache.empty() ? defaultLibraryCachePath() : cfg.library_cache;
+}
+
+// The playlist for `folder`, from the library cache when it has one whose
+// first track still exists (`cached` then keeps the cached paths for
+// refreshLibrary), otherwise by scanning.
+static std::shared_ptr<Playlist> loadLibrary(const std::string &folder, const std::string &cachePath,
+                                             std::vector<std::string> &cached, bool &fromCache)
+{
+    fromCache = false;
+    std::error_code ec;
+    if (!cachePath.empty() && loadLibraryCache(cachePath, folder, cached) &&
+        std::filesystem::exists(std::filesystem::u8path(cached.front()), ec))
     {
-        throw std::runtime_error(
-            "Folder does not exist or cannot be accessed: " + folderPath +
-            " (" + ec.message() + ")");
+        auto playlist = std::make_shared<Playlist>();
+        for (const std::string &path : cached)
+            playlist->addTrack(path);
+        fromCache = true;
+        return playlist;
     }
+    cached.clear();
+    return buildPlaylistFromFolder(folder);
+}
 
-    if (!fs::is_directory(root, ec) || ec)
+// Runs in the background once the player is up. After a start from the
+// cache it scans the folder for real and appends tracks added since the
+// cache was written; tracks that have gone stay until the next start.
+// Either way it leaves a fresh cache behind. This is the only thread
+// that adds to the playlist after startup.
+static void refreshLibrary(std::string folder, std::string cachePath,
+                           std::shared_ptr<Playlist> playlist, std::vector<std::string> cached)
+{
+    tracing::setThreadName("library");
+    if (cached.empty())
     {
-        throw std::runtime_error(
-            "Path is not a directory: " + folderPath +
-            " (" + ec.message() + ")");
+        saveLibraryCache(cachePath, folder, *playlist);
+        return;
     }
 
-    // Use recursive iterator and skip entries that error instead of throwing
-    fs::directory_options opts = fs::directory_options::skip_permission_denied;
+    try
+    {
+        const uint64_t t0 = monotonic_ns();
+        auto scanned = buildPlaylistFromFolder(folder);
+        const std::unordered_set<std::string_view> known(cached.begin(), cached.end());
+        std::vector<size_t> added;
+        for (size_t i = 0; i < scanned->size(); ++i)
+        {
+            if (known.count(scanned->trackAt(i)) == 0)
+                added.push_back(i);
+        }
+        if (!added.empty())
+        {
+            std::lock_guard<std::mutex> lock(control_mutex());
+            for (size_t i : added)
+                playlist->addTrack(scanned->trackAt(i));
+        }
 
-    fs::recursive_directory_iterator it(root, opts, ec), end;
-    if (ec)
+        const size_t gone = cached.size() - (scanned->size() - added.size());
+        AERIAL_INFO("MAIN", "Library rescan: ", scanned->size(), " tracks, ", added.size(), " new, ",
+                    gone, " gone (", static_cast<double>(monotonic_ns() - t0) / 1e6, " ms)");
+        if (!added.empty() || gone > 0)
+            saveLibraryCache(cachePath, folder, *scanned);
+    }
+    catch (const std::exception &e)
     {
-        throw std::runtime_error(
-            std::string("Error creating directory iterator: ") + ec.message());
+        AERIAL_WARN("MAIN", "Library rescan failed: ", e.what());
     }
+}
 
-    for (; it != end; it.increment(ec))
+// Turns on smart shuffle, seeds its weights from the play history and
+// keeps them current as events are logged.
+static void enableSmartShuffle(Playlist &playlist, PlayDatabase &db, size_t cooldown)
+{
+    playlist.enableSmartShuffle(cooldown);
+    SmartShuffle *shuffle = playlist.smartShuffle();
+    if (!db.ok())
+        return;
+
+    auto t0 = std::chrono::steady_clock::now();
+    size_t known = 0;
+    db.forEachTrackStats([&](const std::string &path, const TrackStats &stats)
+    {
+        size_t i = 0;
+        if (!playlist.indexOf(path, i))
+            return;
+        shuffle->setHistory(i, static_cast<uint32_t>(stats.plays),
+                            static_cast<uint32_t>(stats.skips),
+                            static_cast<uint32_t>(stats.finishes));
+        ++known;
+    });
+    shuffle->rebuild();
+    auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    AERIAL_INFO("SHUFFLE", "Smart shuffle on: history for ", known, " of ", playlist.size(),
+                " tracks (", ms, " ms), cooldown ", cooldown);
+
+    // Runs on whichever thread logs the event; all of them hold
+    // control_mutex(), like every other playlist access.
+    db.setEventListener([&playlist](const std::string &path, PlayEvent event)
     {
-        if (ec)
+        SmartShuffle *s = playlist.smartShuffle();
+        size_t i = 0;
+        if (!s || !playlist.indexOf(path, i))
+            return;
+        switch (event)
         {
-            std::cerr << "[WARN] Skipping entry: " << ec.message() << "\n";
-            ec.clear();
-            continue;
+        case PlayEvent::Play:     s->recordPlay(i); break;
+        case PlayEvent::Skip:     s->recordSkip(i); break;
+        case PlayEvent::Finished: s->recordFinish(i); break;
         }
+    });
+}
 
-        const fs::directory_entry &entry = *it;
-        if (!entry.is_regular_file())
-            continue;
-
-        const fs::path &path = entry.path();
-        if (!isAudioFile(path))
-            continue;
+// `aerial export-history <file>` / `aerial import-history <file>`:
+// bulk transfer of the play history, then exit. A .csv name exports CSV,
+// anything else the binary format; import detects which it got.
+static int runHistoryCommand(PlayDatabase &db, const std::string &command, const std::string &file)
+{
+    if (!db.ok())
+    {
+        AERIAL_WARN("DB", "No database; check db_path in the config.");
+        return 1;
+    }
 
-        // Log and store UTF-8 paths; avoids codepage issues on Windows
-        std::string utf8Path = path.u8string();
-        std::cout << "[DEBUG] Found audio file: " << utf8Path << "\n";
-        playlist->addTrack(utf8Path);
+    HistoryTransfer t;
+    bool ok = false;
+    if (command == "export-history")
+    {
+        const bool csv = file.size() >= 4 && file.compare(file.size() - 4, 4, ".csv") == 0;
+        ok = db.exportHistory(file, csv ? HistoryFormat::Csv : HistoryFormat::Binary, t);
+        std::cout << "[DB] Exported " << t.rows << " events, " << t.tracks << " tracks";
+    }
+    else
+    {
+        ok = db.importHistory(file, t);
+        std::cout << "[DB] Imported " << t.rows << " events, " << t.tracks << " new tracks";
+        if (t.skipped > 0)
+            std::cout << " (" << t.skipped << " malformed rows skipped)";
     }
 
-    std::cout << "[DEBUG] Playlist size: " << playlist->size() << "\n";
-    return playlist;
+    const double secs = t.seconds > 0 ? t.seconds : 1e-9;
+    std::cout << "; " << (t.bytes / (1024.0 * 1024.0)) << " MiB in " << t.seconds << " s ("
+              << static_cast<uint64_t>(t.rows / secs) << " rows/s)\n";
+    return ok ? 0 : 1;
 }
 
 // ───────────────────────────────
@@ -106,64 +319,210 @@ std::shared_ptr<Playlist> buildPlaylistFromFolder(const std::string &folderPath)
 
 int main(int argc, char *argv[])
 {
+    const uint64_t startNs = monotonic_ns();
+    tracing::setThreadName("main");
+
+    // Options are taken out of argv so the positional arguments below are
+    // unaffected.
+    //   --trace <file>  dump the span trace there on exit
+    //   --daemon        no console: no banner, no prompt, no stdin; control
+    //                   over TCP/HTTP/IPC only, until SIGINT/SIGTERM
+    //                   (a systemd service; SIGHUP reloads the config)
+    //   --headless      --daemon on the SDL dummy audio driver (load and
+    //                   soak testing)
+    bool daemon = false;
+    bool headless = false;
+    int kept = 1;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--trace")
+        {
+            if (i + 1 >= argc)
+            {
+                std::cout << "Usage: aerial --trace <file.json> <music_folder>\n";
+                return 1;
+            }
+            tracing::writeAtExit(argv[++i]);
+        }
+        else if (arg == "--daemon")
+        {
+            daemon = true;
+        }
+        else if (arg == "--headless")
+        {
+            daemon = true;
+            headless = true;
+        }
+        else
+        {
+            argv[kept++] = argv[i];
+        }
+    }
+    argv[kept] = nullptr;
+    argc = kept;
 
-    AerialConfig cfg = load_config();
+    // The startup snapshot; snapshots are never freed, so `cfg` stays
+    // valid after reloads. Code running later reads config() instead.
+    publish_config(load_config());
+    const AerialConfig &cfg = config();
+    applyLogLevel(cfg);
+    recordPhase(StartupPhase::Config, startNs);
 
-    std::cout << "[CONFIG] DB Path: " << cfg.db_path << "\n";
-    std::cout << "[CONFIG] Server Port: " << cfg.port << "\n";
+    AERIAL_INFO("CONFIG", "DB Path: ", cfg.db_path);
+    AERIAL_INFO("CONFIG", "Server Port: ", cfg.port);
 
-    // 🔹 Init DB (may be disabled if path invalid)
-    PlayDatabase db(cfg.db_path);
-    if (!db.ok())
-    {
-        std::cerr << "[DB] WARNING: DB not available; continuing without logging.\n";
-    }
+    const DbOptions dbOptions = dbOptionsFromConfig(cfg);
 
     try
     {
         if (argc < 2)
         {
-            std::cout << "Usage: aerial <music_folder>\n";
+            std::cout << "Usage: aerial [--daemon | --headless] [--trace <file.json>] <music_folder>\n";
+            std::cout << "       aerial export-history <file[.csv]>\n";
+            std::cout << "       aerial import-history <file>\n";
             return 1;
         }
 
         std::string folder = argv[1];
-        std::cout << "[DEBUG] Aerial starting with folder: " << folder << "\n";
+        if (folder == "export-history" || folder == "import-history")
+        {
+            if (argc < 3)
+            {
+                std::cout << "Usage: aerial " << folder << " <file>\n";
+                return 1;
+            }
+            PlayDatabase db(cfg.db_path, dbOptions);
+            return runHistoryCommand(db, folder, argv[2]);
+        }
+        AERIAL_DEBUG("MAIN", "Aerial starting with folder: ", folder);
+
+        // The database, the library and the audio device don't depend on
+        // each other, so they come up side by side. Audio stays on the
+        // main thread, where SDL expects to be initialised.
+        auto dbTask = std::async(std::launch::async, [&cfg, &dbOptions]()
+        {
+            tracing::setThreadName("startup-db");
+            const uint64_t t0 = monotonic_ns();
+            auto db = std::make_unique<PlayDatabase>(cfg.db_path, dbOptions);
+            recordPhase(StartupPhase::Database, t0);
+            return db;
+        });
+
+        const std::string cachePath = libraryCachePath(cfg);
+        std::vector<std::string> cachedPaths;
+        bool fromCache = false;
+        auto libraryTask = std::async(std::launch::async, [&]()
+        {
+            tracing::setThreadName("startup-library");
+            const uint64_t t0 = monotonic_ns();
+            auto playlist = loadLibrary(folder, cachePath, cachedPaths, fromCache);
+            recordPhase(StartupPhase::Library, t0);
+            return playlist;
+        });
+
+        std::unique_ptr<PlayDatabase> dbOwner;
+        Player player;
+        AERIAL_DEBUG("MAIN", "Initializing audio...");
+        const uint64_t audioStart = monotonic_ns();
+        const bool audioOk = player.init(headless ? "dummy" : nullptr);
+        recordPhase(StartupPhase::Audio, audioStart);
+
+        dbOwner = dbTask.get();
+        PlayDatabase &db = *dbOwner;
+        if (!db.ok())
+        {
+            AERIAL_WARN("DB", "DB not available; continuing without logging.");
+        }
 
-        auto playlist = buildPlaylistFromFolder(folder);
+        auto playlist = libraryTask.get();
         if (playlist->empty())
         {
             std::cout << "No supported audio files found in folder: " << folder << "\n";
             return 1;
         }
-
-        Player player;
-        std::cout << "[DEBUG] Initializing audio...\n";
-        if (!player.init())
+        if (!audioOk)
         {
             std::cerr << "Failed to initialize audio.\n";
             return 1;
         }
 
+        if (cfg.shuffle == "smart")
+        {
+            enableSmartShuffle(*playlist, db,
+                               static_cast<size_t>(std::max(cfg.shuffle_cooldown, 0)));
+        }
+
         player.setPlaylist(playlist);
+        init_zones(cfg.zones, playlist,
+                   static_cast<size_t>(std::max(cfg.zone_cache_mb, 1)) << 20);
+
+        const uint64_t serversStart = monotonic_ns();
+        const bool tcpOk = start_control_server(player, playlist, db.ok() ? &db : nullptr);
+        const bool httpOk = start_http_server(player, playlist, db.ok() ? &db : nullptr, cfg.http_port);
+        bool ipcOk = false;
+        if (!cfg.control_socket.empty())
+        {
+            ipcOk = start_ipc_server(player, playlist, db.ok() ? &db : nullptr, cfg.control_socket);
+        }
 
-        std::cout << "[DEBUG] Calling playCurrent()...\n";
-        if (!player.playCurrent())
+        // The console still works without them; a daemon has nothing else.
+        if (daemon && !tcpOk && !httpOk && !ipcOk)
         {
-            std::cerr << "Failed to start playback.\n";
+            AERIAL_ERROR("MAIN", "No control server could start (TCP port ", cfg.port, ", HTTP port ",
+                         cfg.http_port, cfg.control_socket.empty() ? ", no control_socket" : ", IPC ",
+                         cfg.control_socket, "); not running a daemon nothing can control.");
             return 1;
         }
+        std::string missing;
+        if (!tcpOk) missing += " TCP";
+        if (!httpOk) missing += " HTTP";
+        if (!cfg.control_socket.empty() && !ipcOk) missing += " IPC";
+        if (!missing.empty())
+        {
+            AERIAL_WARN("MAIN", "Control servers not running:", missing, "; see the errors above.");
+        }
+
+        on_config_change(applyConfigChange);
+        watch_config();
+        recordPhase(StartupPhase::Servers, serversStart);
+        recordPhase(StartupPhase::Ready, startNs);
+        logStartup(playlist->size(), fromCache);
 
-        // Initial DB log + UI
-        if (db.ok())
+        if (!cachePath.empty())
         {
-            db.logPlay(playlist->current());
+            std::thread(refreshLibrary, folder, cachePath, playlist, std::move(cachedPaths)).detach();
         }
-        updateNowPlayingUI(*playlist);
 
-        // 🔥 Start TCP control server in background
-        start_control_server(player, playlist, db.ok() ? &db : nullptr);
-        start_http_server(player, playlist, 8080);
+        // Clients may already be connected, hence the lock.
+        {
+            std::lock_guard<std::mutex> lock(control_mutex());
+            AERIAL_DEBUG("MAIN", "Calling playCurrent()...");
+            if (!player.playCurrent())
+            {
+                std::cerr << "Failed to start playback.\n";
+                return 1;
+            }
+
+            // Initial DB log (playCurrent() already showed the box)
+            if (db.ok())
+            {
+                db.logPlay(playlist->current());
+            }
+        }
+
+        if (daemon)
+        {
+            notifySystemd("READY=1");
+            AERIAL_INFO("MAIN", headless ? "Headless: " : "Daemon: ", playlist->size(),
+                        headless ? " tracks on the dummy audio driver" : " tracks",
+                        "; stop with SIGINT or SIGTERM, reload the config with SIGHUP.");
+            waitForStopSignal();
+            notifySystemd("STOPPING=1");
+            player.shutdown();
+            AERIAL_DEBUG("MAIN", "Shutdown complete.");
+            return 0;
+        }
 
         constexpr const char *AERIAL_VERSION = "0.1.3-dev (CLI)";
         std::cout << "Aerial Player " << AERIAL_VERSION << "\n\n";
@@ -185,6 +544,24 @@ int main(int argc, char *argv[])
         std::cout << "  stop        - stop\n";
         std::cout << "  quit/exit   - quit\n\n";
 
+        // Box + progress pinned below the prompt, fed under the same lock
+        // as the commands that change it.
+        StatusArea status(kNowPlayingRows, cfg.ui_fps);
+        status.setSource([&player, playlist](StatusFrame &frame)
+        {
+            std::lock_guard<std::mutex> lock(control_mutex());
+            drawNowPlaying(frame,
+                           playlist->currentTitle(),
+                           playlist->size() > 1 ? playlist->peekNextTitle() : std::string_view(),
+                           player.getPositionSeconds(),
+                           player.isPaused(),
+                           player.getVolumePercent());
+        });
+        if (cfg.ui_fps > 0)
+        {
+            status.start();
+        }
+
         // ===== Command loop =====
         std::string cmd;
         bool running = true;
@@ -212,10 +589,16 @@ int main(int argc, char *argv[])
                 continue; // just hit Enter, don't do anything
             }
 
+            AERIAL_SPAN("stdin command");
+            ScopedTimer timer(metrics().command(CommandSource::Stdin));
+
+            // Same lock the TCP/HTTP servers take, so a remote batch never
+            // interleaves with a console command.
+            std::unique_lock<std::mutex> lock(control_mutex());
+
             if (cmd == "play")
             {
                 player.playCurrent();
-                updateNowPlayingUI(*playlist);
                 if (db.ok())
                 {
                     db.logPlay(playlist->current());
@@ -239,7 +622,6 @@ int main(int argc, char *argv[])
                 }
 
                 player.playNext();
-                updateNowPlayingUI(*playlist);
 
                 if (db.ok())
                 {
@@ -253,7 +635,6 @@ int main(int argc, char *argv[])
             else if (cmd == "prev" || cmd == "previous")
             {
                 player.playPrevious();
-                updateNowPlayingUI(*playlist);
                 if (db.ok())
                 {
                     db.logPlay(playlist->current());
@@ -270,6 +651,9 @@ int main(int argc, char *argv[])
             else if (cmd == "search")
             {
                 // ---- SEARCH COMMAND ----
+                lock.unlock(); // don't block remote clients while prompting
+                timer.cancel(); // interactive; its latency is the user's
+
                 std::string term;
                 std::cout << "Search term: ";
                 std::getline(std::cin >> std::ws, term);
@@ -280,6 +664,9 @@ int main(int argc, char *argv[])
                     continue;
                 }
 
+                // The background library refresh appends to the playlist,
+                // so searching and listing titles need the lock again.
+                lock.lock();
                 auto matches = playlist->search(term);
                 if (matches.empty())
                 {
@@ -290,15 +677,9 @@ int main(int argc, char *argv[])
                 std::cout << "Found " << matches.size() << " match(es):\n";
                 for (size_t i = 0; i < matches.size(); ++i)
                 {
-                    size_t idx = matches[i];
-                    const std::string &fullPath = playlist->trackAt(idx);
-
-                    // Show just filename
-                    fs::path p = fs::u8path(fullPath);
-                    std::string name = p.filename().u8string();
-
-                    std::cout << "  [" << i << "] " << name << "\n";
+                    std::cout << "  [" << i << "] " << playlist->title(matches[i]) << "\n";
                 }
+                lock.unlock(); // indices stay valid: the refresh only appends
 
                 std::cout << "Enter number to play (blank = cancel): ";
                 std::string choice;
@@ -320,9 +701,9 @@ int main(int argc, char *argv[])
                     }
 
                     size_t realIndex = matches[sel];
+                    lock.lock();
                     playlist->jumpTo(realIndex);
                     player.playCurrent();
-                    updateNowPlayingUI(*playlist);
                     if (db.ok())
                     {
                         db.logPlay(playlist->current());
@@ -380,26 +761,43 @@ int main(int argc, char *argv[])
                 }
             }
 
-            
+            else if (Command shared; parse_command(cmd, shared))
+            {
+                // The rest of the shared command set: queue edits, and
+                // "@kitchen next" for other zones.
+                CommandContext ctx{player, playlist, db.ok() ? &db : nullptr};
+                OutBuffer ack(64);
+                lock.unlock(); // a zone's track decodes without the lock
+                prefetch_command(ctx, shared);
+                lock.lock();
+                execute_command(ctx, shared, ack);
+                std::cout << ack.view() << "\n";
+            }
             else if (cmd == "quit" || cmd == "exit")
             {
-                std::cout << "[DEBUG] Quit command received.\n";
+                AERIAL_DEBUG("MAIN", "Quit command received.");
                 running = false;
             }
             else
             {
                 std::cout << "Unknown command: " << cmd << "\n";
                 std::cout << "Commands: play, resume, pause, next, prev, ff, rew, stop, quit\n";
+                std::cout << "Queue: queue <n>, playnext <n>, qinsert <pos> <n>, qremove <pos>, qmove <from> <to>, qclear\n";
+                if (zone_count() > 0)
+                {
+                    std::cout << "Zones: @<zone> <command>, e.g. @" << zone_name(1) << " next\n";
+                }
             }
         }
 
+        status.stop();
         player.shutdown();
-        std::cout << "[DEBUG] Shutdown complete.\n";
+        AERIAL_DEBUG("MAIN", "Shutdown complete.");
         return 0;
     }
     catch (const std::exception &e)
     {
-        std::cerr << "[FATAL] Unhandled exception: " << e.what() << "\n";
+        AERIAL_ERROR("MAIN", "Unhandled exception: ", e.what());
         return 1;
     }
 }
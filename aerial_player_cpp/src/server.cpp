@@ -1,19 +1,39 @@
-#include "Server.hpp"
+#include "server.hpp"
 #include "Player.hpp"
 #include "Playlist.hpp"
 #include "UI.hpp"
 #include "DB.hpp"
+#include "Log.hpp"
+#include "Metrics.hpp"
+#include "Trace.hpp"
+#include "Commands.hpp"
+#include "Config.hpp"
+#include "OutBuffer.hpp"
+#include "aerial_ipc.h"
+#include "json.hpp"
+#include "Zone.hpp"
 
 #include <thread>
-#include <iostream>
-#include <sstream>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <filesystem>
+#include <mutex>
+#include <vector>
+#include <charconv>
 #include <algorithm>
 #include <cctype>
+#include <cstdio>
 #include <cstring>
+#include <ctime>
+#include <string_view>
 
 #ifdef _WIN32
 #include <winsock2.h>
 #include <ws2tcpip.h>
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
 using socket_t = SOCKET;
 static const socket_t INVALID_SOCKET_FD = INVALID_SOCKET;
 #else
@@ -21,9 +41,23 @@ static const socket_t INVALID_SOCKET_FD = INVALID_SOCKET;
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <unistd.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+#include <cerrno>
 using socket_t = int;
 static const socket_t INVALID_SOCKET_FD = -1;
+#ifdef MSG_NOSIGNAL
+static const int SEND_FLAGS = MSG_NOSIGNAL; // a vanished client must not SIGPIPE the player
+#else
+static const int SEND_FLAGS = 0;
+#endif
 #endif
 
 static void close_socket(socket_t s)
@@ -37,7 +71,7 @@ static void close_socket(socket_t s)
 #endif
 }
 
-static std::string trim(const std::string &s)
+static std::string_view trim(std::string_view s)
 {
     size_t start = 0;
     while (start < s.size() && std::isspace(static_cast<unsigned char>(s[start])))
@@ -52,8 +86,212 @@ static std::string trim(const std::string &s)
     return s.substr(start, end - start);
 }
 
+// Sends every byte of the given fragments. On POSIX this is one gathered
+// sendmsg() per round trip instead of one send() per fragment, so callers
+// can hand over cached fragments without first copying them together.
+static bool send_all(socket_t s, const std::string_view *parts, size_t count)
+{
+    constexpr size_t kMaxParts = 8;
+    if (count > kMaxParts)
+        return false;
+
+#ifdef _WIN32
+    WSABUF bufs[kMaxParts];
+#else
+    iovec bufs[kMaxParts];
+#endif
+    size_t n = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (parts[i].empty())
+            continue;
+#ifdef _WIN32
+        bufs[n].buf = const_cast<char *>(parts[i].data());
+        bufs[n].len = static_cast<ULONG>(parts[i].size());
+#else
+        bufs[n].iov_base = const_cast<char *>(parts[i].data());
+        bufs[n].iov_len = parts[i].size();
+#endif
+        ++n;
+    }
+
+    size_t first = 0;
+    while (first < n)
+    {
+#ifdef _WIN32
+        DWORD sent = 0;
+        if (WSASend(s, bufs + first, static_cast<DWORD>(n - first), &sent, 0, nullptr, nullptr) != 0)
+            return false;
+        size_t left = sent;
+#else
+        msghdr msg{};
+        msg.msg_iov = bufs + first;
+        msg.msg_iovlen = n - first;
+        ssize_t sent = sendmsg(s, &msg, SEND_FLAGS);
+        if (sent < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        size_t left = static_cast<size_t>(sent);
+#endif
+        // Skip fully-sent buffers, then trim the partially-sent one.
+        while (first < n)
+        {
+#ifdef _WIN32
+            size_t len = bufs[first].len;
+#else
+            size_t len = bufs[first].iov_len;
+#endif
+            if (left < len)
+            {
+#ifdef _WIN32
+                bufs[first].buf += left;
+                bufs[first].len -= static_cast<ULONG>(left);
+#else
+                bufs[first].iov_base = static_cast<char *>(bufs[first].iov_base) + left;
+                bufs[first].iov_len -= left;
+#endif
+                break;
+            }
+            left -= len;
+            ++first;
+        }
+    }
+    return true;
+}
+
+// A loopback TCP listener whose port follows the live config: when a
+// reload changes `key`, it binds the new port and only then closes the
+// old one, so a port that is taken leaves the server where it was. A
+// port given explicitly (the HTTP server's argument) holds until the
+// config value itself changes.
+class LiveListener
+{
+public:
+    LiveListener(const char *tag, int AerialConfig::*key, int port, int backlog)
+        : tag_(tag), key_(key), port_(port), backlog_(backlog),
+          wanted_(config().*key), generation_(config_generation())
+    {
+    }
+
+    ~LiveListener() { close(); }
+
+    LiveListener(const LiveListener &) = delete;
+    LiveListener &operator=(const LiveListener &) = delete;
+
+    bool open()
+    {
+        sock_ = bind_port(port_);
+        return sock_ != INVALID_SOCKET_FD;
+    }
+
+    void close()
+    {
+        close_socket(sock_);
+        sock_ = INVALID_SOCKET_FD;
+    }
+
+    // Waits for the next client, rebinding in between if the config
+    // moved the port. INVALID_SOCKET_FD if accept() failed.
+    socket_t accept()
+    {
+        while (true)
+        {
+            follow();
+#ifdef _WIN32
+            WSAPOLLFD pfd{sock_, POLLRDNORM, 0};
+            const int ready = WSAPoll(&pfd, 1, kPollMs);
+#else
+            pollfd pfd{sock_, POLLIN, 0};
+            const int ready = poll(&pfd, 1, kPollMs);
+#endif
+            if (ready == 0 || (ready < 0 && errno == EINTR))
+                continue;
+
+            sockaddr_in clientAddr{};
+#ifdef _WIN32
+            int clientLen = sizeof(clientAddr);
+#else
+            socklen_t clientLen = sizeof(clientAddr);
+#endif
+            return ::accept(sock_, reinterpret_cast<sockaddr *>(&clientAddr), &clientLen);
+        }
+    }
+
+private:
+    static constexpr int kPollMs = 250;
+
+    socket_t bind_port(int port)
+    {
+        socket_t sock = socket(AF_INET, SOCK_STREAM, 0);
+        if (sock == INVALID_SOCKET_FD)
+        {
+            AERIAL_ERROR(tag_, "Failed to create socket");
+            return INVALID_SOCKET_FD;
+        }
+
+        int opt = 1;
+        setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<char *>(&opt), sizeof(opt));
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(port));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK); // 127.0.0.1
+
+        if (bind(sock, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0)
+        {
+            AERIAL_ERROR(tag_, "bind failed on port ", port);
+            close_socket(sock);
+            return INVALID_SOCKET_FD;
+        }
+        if (listen(sock, backlog_) < 0)
+        {
+            AERIAL_ERROR(tag_, "listen failed");
+            close_socket(sock);
+            return INVALID_SOCKET_FD;
+        }
+        AERIAL_INFO(tag_, "Listening on 127.0.0.1:", port);
+        return sock;
+    }
+
+    // One atomic load per wakeup unless a reload happened.
+    void follow()
+    {
+        const uint64_t generation = config_generation();
+        if (generation == generation_)
+            return;
+        generation_ = generation;
+        const int want = config().*key_;
+        if (want == wanted_)
+            return;
+        wanted_ = want;
+
+        socket_t next = bind_port(want);
+        if (next == INVALID_SOCKET_FD)
+        {
+            AERIAL_WARN(tag_, "Staying on port ", port_);
+            return;
+        }
+        close_socket(sock_);
+        sock_ = next;
+        port_ = want;
+    }
+
+    const char *tag_;
+    int AerialConfig::*key_;
+    int port_;
+    const int backlog_;
+    int wanted_;
+    uint64_t generation_;
+    socket_t sock_ = INVALID_SOCKET_FD;
+};
+
 // ===================== TCP (telnet-style) =====================
 
+using Clock = std::chrono::steady_clock;
+
 static void handle_tcp_client(socket_t client,
                               Player &player,
                               std::shared_ptr<Playlist> playlist,
@@ -61,14 +299,34 @@ static void handle_tcp_client(socket_t client,
 {
     const char *welcome =
         "Aerial TCP Control\n"
-        "Commands: play, pause, resume, next, prev, ff, rew, stop, quit\n";
+        "Commands: play, pause, resume, next, prev, ff, rew, stop, seek <s>, vol <0-100>,\n"
+        "          jump <n>, status, quiet, verbose, quit\n"
+        "Queue: queue <n>, playnext <n>, qinsert <pos> <n>, qremove <pos>, qmove <from> <to>, qclear\n"
+        "Zones: @<zone> <command>, e.g. @kitchen next\n";
 
     send(client, welcome, static_cast<int>(std::strlen(welcome)), 0);
 
+    CommandContext ctx{player, playlist, db};
+    ConnectionScope connection(Server::Tcp);
+
+    // Everything below lives for the whole connection and is only
+    // cleared between commands, so steady-state replies don't allocate.
     char buf[1024];
     std::string pending;
+    std::string lower;
+    OutBuffer head(256);
+    OutBuffer tail(128);
+    OutBuffer acks(1024);
+    OutBuffer zoneBox(512);
+    NowPlayingCache nowPlaying;
     bool running = true;
 
+    // Quiet mode: one-line acks, no now-playing box, and every ack for
+    // commands that arrived in the same read goes out in a single send.
+    bool quiet = false;
+    uint64_t quietCommands = 0;
+    Clock::time_point quietSince{};
+
     while (running)
     {
         int n = recv(client, buf, sizeof(buf), 0);
@@ -76,219 +334,164 @@ static void handle_tcp_client(socket_t client,
             break; // client closed or error
 
         pending.append(buf, n);
+        acks.clear();
 
+        size_t consumed = 0;
         size_t pos;
-        while ((pos = pending.find('\n')) != std::string::npos)
+        while (running && (pos = pending.find('\n', consumed)) != std::string::npos)
         {
-            std::string line = pending.substr(0, pos);
-            pending.erase(0, pos + 1);
+            std::string_view line = trim(std::string_view(pending).substr(consumed, pos - consumed));
+            consumed = pos + 1;
 
-            line = trim(line);
             if (line.empty())
                 continue;
 
-            std::string lower = line;
+            lower.assign(line.data(), line.size());
             std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
 
-            std::ostringstream reply;
+            head.clear();
+            tail.clear();
+            bool withBox = !quiet;
+            const Zone *boxZone = nullptr; // box shows this zone, not main
 
-            if (lower == "play")
+            if (lower == "status")
             {
-                player.playCurrent();
-                reply << "OK play\r\n";
-
-                if (db && playlist && !playlist->empty())
+                // Box + progress, plus the volume line
+                std::lock_guard<std::mutex> lock(control_mutex());
+                appendProgressBar(tail, player.getPositionSeconds());
+                tail << "\r\nVolume: " << player.getVolumePercent() << "%\r\n";
+                withBox = true;
+            }
+            else if (lower == "quit" || lower == "exit")
+            {
+                head << "Bye";
+                if (quiet)
                 {
-                    db->logPlay(playlist->current());
+                    double secs = std::chrono::duration<double>(Clock::now() - quietSince).count();
+                    head << " (" << quietCommands << " commands, "
+                         << static_cast<long long>(secs > 0 ? quietCommands / secs : 0) << " cmd/s)";
                 }
+                head << "\r\n";
+                withBox = false;
+                running = false;
             }
-            else if (lower == "pause")
+            else if (lower == "ping")
             {
-                player.pause();
-                reply << "OK pause\r\n";
+                head << "PONG\r\n";
+                withBox = false;
             }
-            else if (lower == "resume")
+            else if (lower == "quiet")
             {
-                player.resume();
-                reply << "OK resume\r\n";
+                quiet = true;
+                quietCommands = 0;
+                quietSince = Clock::now();
+                head << "OK quiet\r\n";
+                withBox = false;
             }
-            else if (lower == "next")
+            else if (lower == "verbose")
             {
-                std::string prevTrack;
-
-                // Capture what was playing *before* skipping
-                if (db && playlist && !playlist->empty())
+                quiet = false;
+                head << "OK verbose\r\n";
+            }
+            else
+            {
+                AERIAL_SPAN("TCP command");
+                ScopedTimer timer(metrics().command(CommandSource::Tcp));
+                Command cmd;
+                if (parse_command(line, cmd))
                 {
-                    prevTrack = playlist->current();
+                    prefetch_command(ctx, cmd);
+                    std::lock_guard<std::mutex> lock(control_mutex());
+                    execute_command(ctx, cmd, head);
+                    boxZone = zone_at(cmd.zone);
                 }
-
-                player.playNext();
-                reply << "OK next\r\n";
-
-                if (db && playlist && !playlist->empty())
+                else
                 {
-                    if (!prevTrack.empty())
-                    {
-                        db->logSkip(prevTrack); // moved away from this track
-                    }
-                    db->logPlay(playlist->current()); // new current track
+                    timer.cancel();
+                    head << "ERR unknown command: " << line;
                 }
+                head << "\r\n";
+                ++quietCommands;
             }
-            else if (lower == "prev" || lower == "previous")
-            {
-                player.playPrevious();
-                reply << "OK prev\r\n";
 
-                if (db && playlist && !playlist->empty())
+            // 🔹 Append Now Playing / Up Next box + progress bar
+            std::string_view box;
+            if (withBox)
+            {
+                std::lock_guard<std::mutex> lock(control_mutex());
+                if (boxZone)
                 {
-                    db->logPlay(playlist->current()); // log the track we jumped back to
+                    // Rarely asked for, so rendered each time
+                    const bool haveTracks = !playlist->empty();
+                    zoneBox.clear();
+                    appendNowPlayingBoxTitles(zoneBox,
+                                              haveTracks ? playlist->title(boxZone->index()) : std::string_view(),
+                                              haveTracks ? playlist->title(boxZone->peekNextIndex()) : std::string_view());
+                    box = zoneBox.view();
+                    if (tail.empty())
+                        appendProgressBar(tail, boxZone->getPositionSeconds());
+                }
+                else
+                {
+                    box = nowPlaying.get(*playlist);
+                    if (tail.empty())
+                        appendProgressBar(tail, player.getPositionSeconds());
                 }
             }
 
-            else if (lower == "ff")
-            {
-                player.seekBy(10.0);
-                reply << "OK ff +10s\r\n";
-            }
-            else if (lower == "rew")
-            {
-                player.seekBy(-10.0);
-                reply << "OK rew -10s\r\n";
-            }
-            else if (lower == "stop")
-            {
-                player.stop();
-                reply << "OK stop\r\n";
-            } 
-            else if(lower == "status"){
-                if (lower != "quit" && lower != "exit") {
-    std::string nowPath;
-    std::string nextPath;
-
-    if (!playlist->empty()) {
-        nowPath  = playlist->current();
-        nextPath = playlist->peekNext();
-    }
-
-    reply << renderNowPlayingBoxPlain(nowPath, nextPath);
-
-    double posSeconds = player.getPositionSeconds();
-    reply << renderProgressBar(posSeconds);
-
-    // Optional: show volume too
-    reply << "\r\nVolume: " << player.getVolumePercent() << "%\r\n";
-}
-
-            }
-            else if (lower == "quit" || lower == "exit")
+            if (quiet || !acks.empty())
             {
-                reply << "Bye\r\n";
-                running = false;
-            }
-            else
-            {
-                reply << "ERR unknown command: " << line << "\r\n";
+                acks << head.view() << box << tail.view();
+                continue;
             }
 
-            // 🔹 Append Now Playing / Up Next box for non-quit commands
-            if (lower != "quit" && lower != "exit" && lower != "status")
-            {
-
-                std::string nowPath;
-                std::string nextPath;
-
-                if (!playlist->empty())
-                {
-                    nowPath = playlist->current();
-                    nextPath = playlist->peekNext();
-                }
+            const std::string_view parts[] = {head.view(), box, tail.view()};
+            send_all(client, parts, 3);
+        }
 
-                reply << renderNowPlayingBoxPlain(nowPath, nextPath);
-                // Progress bar
-                double posSeconds = player.getPositionSeconds();
-                reply << renderProgressBar(posSeconds);
-            }
+        pending.erase(0, consumed);
 
-            std::string out = reply.str();
-            if (!out.empty())
-            {
-                send(client, out.c_str(), static_cast<int>(out.size()), 0);
-            }
+        if (!acks.empty())
+        {
+            const std::string_view parts[] = {acks.view()};
+            send_all(client, parts, 1);
         }
     }
 
     close_socket(client);
 }
 
-void start_control_server(Player &player, std::shared_ptr<Playlist> playlist, PlayDatabase *db)
+bool start_control_server(Player &player, std::shared_ptr<Playlist> playlist, PlayDatabase *db)
 {
-    std::thread([&player, playlist, db]()
-                {
 #ifdef _WIN32
-                    WSADATA wsaData;
-                    int wsaInit = WSAStartup(MAKEWORD(2, 2), &wsaData);
-                    if (wsaInit != 0)
-                    {
-                        std::cerr << "[TCP] WSAStartup failed: " << wsaInit << "\n";
-                        return;
-                    }
-#endif
-
-                    socket_t serverSock = socket(AF_INET, SOCK_STREAM, 0);
-                    if (serverSock == INVALID_SOCKET_FD)
-                    {
-                        std::cerr << "[TCP] Failed to create socket\n";
-#ifdef _WIN32
-                        WSACleanup();
-#endif
-                        return;
-                    }
-
-                    int opt = 1;
-                    setsockopt(serverSock, SOL_SOCKET, SO_REUSEADDR,
-                               reinterpret_cast<char *>(&opt), sizeof(opt));
-
-                    sockaddr_in addr{};
-                    addr.sin_family = AF_INET;
-                    addr.sin_port = htons(5050);
-                    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK); // 127.0.0.1
-
-                    if (bind(serverSock, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0)
-                    {
-                        std::cerr << "[TCP] bind failed\n";
-                        close_socket(serverSock);
-#ifdef _WIN32
-                        WSACleanup();
+    WSADATA wsaData;
+    int wsaInit = WSAStartup(MAKEWORD(2, 2), &wsaData);
+    if (wsaInit != 0)
+    {
+        AERIAL_ERROR("TCP", "WSAStartup failed: ", wsaInit);
+        return false;
+    }
 #endif
-                        return;
-                    }
 
-                    if (listen(serverSock, 4) < 0)
-                    {
-                        std::cerr << "[TCP] listen failed\n";
-                        close_socket(serverSock);
+    // Bound before returning, so the caller knows the port is being served.
+    auto listener = std::make_shared<LiveListener>("TCP", &AerialConfig::port, config().port, 4);
+    if (!listener->open())
+    {
 #ifdef _WIN32
-                        WSACleanup();
+        WSACleanup();
 #endif
-                        return;
-                    }
-
-                    std::cout << "[TCP] Listening on 127.0.0.1:5050\n";
+        return false;
+    }
 
+    std::thread([&player, playlist, db, listener]()
+                {
+                    tracing::setThreadName("tcp");
                     while (true)
                     {
-                        sockaddr_in clientAddr{};
-#ifdef _WIN32
-                        int clientLen = sizeof(clientAddr);
-#else
-                        socklen_t clientLen = sizeof(clientAddr);
-#endif
-                        socket_t clientSock = accept(serverSock,
-                                                     reinterpret_cast<sockaddr *>(&clientAddr),
-                                                     &clientLen);
+                        socket_t clientSock = listener->accept();
                         if (clientSock == INVALID_SOCKET_FD)
                         {
-                            std::cerr << "[TCP] accept failed, shutting down TCP server thread\n";
+                            AERIAL_ERROR("TCP", "accept failed, shutting down TCP server thread");
                             break;
                         }
 
@@ -296,200 +499,1725 @@ void start_control_server(Player &player, std::shared_ptr<Playlist> playlist, Pl
                         handle_tcp_client(clientSock, player, playlist, db);
                     }
 
-                    close_socket(serverSock);
-
+                    listener->close();
 #ifdef _WIN32
                     WSACleanup();
 #endif
                 })
         .detach();
+    return true;
 }
 
 // ===================== HTTP server (for Postman/curl) =====================
 
+static const char *http_reason(int statusCode)
+{
+    switch (statusCode)
+    {
+    case 200: return "OK";
+    case 206: return "Partial Content";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 416: return "Range Not Satisfiable";
+    case 503: return "Service Unavailable";
+    default:  return "Error";
+    }
+}
+
 static void send_http_response(socket_t client, int statusCode,
-                               const std::string &bodyJson)
+                               std::string_view body,
+                               std::string_view contentType = "application/json")
 {
-    std::ostringstream oss;
-    oss << "HTTP/1.1 " << statusCode << " OK\r\n"
-        << "Content-Type: application/json\r\n"
-        << "Access-Control-Allow-Origin: *\r\n"
-        << "Content-Length: " << bodyJson.size() << "\r\n"
-        << "\r\n"
-        << bodyJson;
+    // The HTTP server handles one client at a time on its own thread,
+    // so a thread-local header buffer is reused for every response.
+    thread_local OutBuffer head(256);
+    head.clear();
+    head << "HTTP/1.1 " << statusCode << ' ' << http_reason(statusCode) << "\r\n"
+         << "Content-Type: " << contentType << "\r\n"
+         << "Access-Control-Allow-Origin: *\r\n"
+         << "Content-Length: " << body.size() << "\r\n"
+         << "\r\n";
+
+    const std::string_view parts[] = {head.view(), body};
+    send_all(client, parts, 2);
+}
 
-    const std::string resp = oss.str();
-    send(client, resp.c_str(), static_cast<int>(resp.size()), 0);
+static bool starts_with_nocase(std::string_view s, std::string_view prefix)
+{
+    if (s.size() < prefix.size())
+        return false;
+    for (size_t i = 0; i < prefix.size(); ++i)
+    {
+        if (std::tolower(static_cast<unsigned char>(s[i])) != prefix[i])
+            return false;
+    }
+    return true;
 }
 
-static void handle_http_client(socket_t client,
-                               Player &player,
-                               std::shared_ptr<Playlist> playlist)
+// Returns the trimmed value of header `lowerName` ("range", ...) from a
+// raw header block, or an empty view if it isn't present.
+static std::string_view find_header(std::string_view headers, std::string_view lowerName)
 {
-    char buf[4096];
-    int n = recv(client, buf, sizeof(buf) - 1, 0);
-    if (n <= 0)
+    size_t lineStart = headers.find("\r\n");
+    while (lineStart != std::string_view::npos)
     {
-        close_socket(client);
-        return;
+        lineStart += 2;
+        size_t lineEnd = headers.find("\r\n", lineStart);
+        std::string_view line = headers.substr(lineStart, lineEnd == std::string_view::npos
+                                                              ? std::string_view::npos
+                                                              : lineEnd - lineStart);
+        if (line.size() > lowerName.size() && line[lowerName.size()] == ':' &&
+            starts_with_nocase(line, lowerName))
+        {
+            return trim(line.substr(lowerName.size() + 1));
+        }
+        lineStart = lineEnd;
     }
-    buf[n] = '\0';
+    return {};
+}
+
+// Reads one request (headers plus a Content-Length body, if any) into
+// `req`. Returns false on a closed socket, an oversized request or a
+// Content-Length that isn't a plain number.
+static bool read_http_request(socket_t client, std::string &req,
+                              size_t &headerLen, size_t &bodyLen)
+{
+    constexpr size_t kMaxRequest = 64 * 1024;
+    char buf[4096];
 
-    std::string req(buf);
+    req.clear();
+    headerLen = std::string::npos;
+    bodyLen = 0;
 
-    // Extract request line
-    size_t lineEnd = req.find("\r\n");
-    if (lineEnd == std::string::npos)
+    while (true)
     {
-        close_socket(client);
-        return;
+        if (headerLen == std::string::npos)
+        {
+            size_t end = req.find("\r\n\r\n");
+            if (end != std::string::npos)
+            {
+                headerLen = end + 4;
+
+                // No Content-Length means no body; a malformed one, or one
+                // too large to fit, drops the request. Compared without
+                // adding, so a huge value can't wrap round.
+                std::string_view value = find_header(std::string_view(req.data(), end), "content-length");
+                if (!value.empty())
+                {
+                    auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), bodyLen);
+                    if (ec != std::errc() || ptr != value.data() + value.size())
+                        return false;
+                }
+                if (headerLen > kMaxRequest || bodyLen > kMaxRequest - headerLen)
+                    return false;
+            }
+        }
+
+        if (headerLen != std::string::npos && req.size() >= headerLen + bodyLen)
+            return true;
+
+        if (req.size() >= kMaxRequest)
+            return false;
+
+        int n = recv(client, buf, sizeof(buf), 0);
+        if (n <= 0)
+            return false;
+        req.append(buf, static_cast<size_t>(n));
     }
+}
 
-    std::string requestLine = req.substr(0, lineEnd);
-    std::istringstream iss(requestLine);
-    std::string method, path, version;
-    iss >> method >> path >> version;
+// ---- Query strings ----
 
-    std::string lowerMethod = method;
-    std::transform(lowerMethod.begin(), lowerMethod.end(), lowerMethod.begin(), ::tolower);
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
 
-    // Basic routing
-    if (lowerMethod == "get" && path == "/status")
+// Finds `key` in "a=1&b=2" and percent-decodes its value into `out`.
+static bool query_param(std::string_view query, std::string_view key, std::string &out)
+{
+    while (!query.empty())
     {
-        std::string now = player.nowPlaying();
-        // Simple JSON body
-        std::string body = std::string("{\"nowPlaying\":\"") + now + "\"}";
-        send_http_response(client, 200, body);
+        size_t amp = query.find('&');
+        std::string_view pair = query.substr(0, amp);
+        query = (amp == std::string_view::npos) ? std::string_view() : query.substr(amp + 1);
+
+        size_t eq = pair.find('=');
+        if (pair.substr(0, eq) != key)
+            continue;
+
+        std::string_view raw = (eq == std::string_view::npos) ? std::string_view() : pair.substr(eq + 1);
+        out.clear();
+        for (size_t i = 0; i < raw.size(); ++i)
+        {
+            if (raw[i] == '+')
+            {
+                out.push_back(' ');
+            }
+            else if (raw[i] == '%' && i + 2 < raw.size() && hex_value(raw[i + 1]) >= 0 && hex_value(raw[i + 2]) >= 0)
+            {
+                out.push_back(static_cast<char>(hex_value(raw[i + 1]) * 16 + hex_value(raw[i + 2])));
+                i += 2;
+            }
+            else
+            {
+                out.push_back(raw[i]);
+            }
+        }
+        return true;
     }
-    else if (lowerMethod == "post" && path == "/play")
+    return false;
+}
+
+static size_t query_size(std::string_view query, std::string_view key, size_t fallback)
+{
+    thread_local std::string value;
+    if (!query_param(query, key, value))
+        return fallback;
+    size_t n = fallback;
+    auto res = std::from_chars(value.data(), value.data() + value.size(), n);
+    return (res.ec == std::errc() && res.ptr == value.data() + value.size()) ? n : fallback;
+}
+
+// ---- Chunked responses ----
+
+// Streams a response body with Transfer-Encoding: chunked. Output is
+// staged in a fixed buffer and flushed as one chunk whenever it fills,
+// so arbitrarily long listings never exist in memory as a whole.
+class ChunkedWriter
+{
+public:
+    static constexpr size_t kChunkBytes = 16 * 1024;
+
+    explicit ChunkedWriter(socket_t client) : client_(client), out_(chunk_buffer())
     {
-        player.playCurrent();
-        send_http_response(client, 200, "{\"ok\":true,\"cmd\":\"play\"}");
+        thread_local OutBuffer head(256);
+        head.clear();
+        head << "HTTP/1.1 200 OK\r\n"
+             << "Content-Type: application/json\r\n"
+             << "Access-Control-Allow-Origin: *\r\n"
+             << "Transfer-Encoding: chunked\r\n"
+             << "\r\n";
+        const std::string_view parts[] = {head.view()};
+        ok_ = send_all(client_, parts, 1);
+        out_.clear();
     }
-    else if (lowerMethod == "post" && path == "/pause")
+
+    OutBuffer &buf() { return out_; }
+
+    bool ok() const { return ok_; }
+
+    // Sends the staged bytes as a chunk once enough have accumulated.
+    void maybeFlush()
     {
-        player.pause();
-        send_http_response(client, 200, "{\"ok\":true,\"cmd\":\"pause\"}");
+        if (out_.size() >= kChunkBytes)
+            flush();
     }
-    else if (lowerMethod == "post" && path == "/resume")
+
+    void flush()
     {
-        player.resume();
-        send_http_response(client, 200, "{\"ok\":true,\"cmd\":\"resume\"}");
+        if (!ok_ || out_.empty())
+            return;
+        char sizeLine[20];
+        int len = std::snprintf(sizeLine, sizeof(sizeLine), "%zx\r\n", out_.size());
+        const std::string_view parts[] = {std::string_view(sizeLine, static_cast<size_t>(len)),
+                                          out_.view(), "\r\n"};
+        ok_ = send_all(client_, parts, 3);
+        out_.clear();
     }
-    else if (lowerMethod == "post" && path == "/next")
+
+    void finish()
     {
-        player.playNext();
-        send_http_response(client, 200, "{\"ok\":true,\"cmd\":\"next\"}");
+        flush();
+        if (ok_)
+        {
+            const std::string_view parts[] = {"0\r\n\r\n"};
+            ok_ = send_all(client_, parts, 1);
+        }
     }
-    else if (lowerMethod == "post" && path == "/prev")
+
+private:
+    // One staging buffer per server thread, reused across responses.
+    static OutBuffer &chunk_buffer()
     {
-        player.playPrevious();
-        send_http_response(client, 200, "{\"ok\":true,\"cmd\":\"prev\"}");
+        thread_local OutBuffer chunk(kChunkBytes + 4096);
+        return chunk;
     }
-    else if (lowerMethod == "post" && path == "/ff")
+
+    socket_t client_;
+    OutBuffer &out_;
+    bool ok_ = false;
+};
+
+static void append_track_json(OutBuffer &out, const Playlist &playlist, size_t id)
+{
+    json::Writer w(out);
+    w.beginObject()
+        .field("id", id)
+        .field("title", playlist.title(id))
+        .field("path", playlist.trackAt(id))
+        .endObject();
+}
+
+// Track ids are positions in the library, which is append-only, so an id
+// cursor keeps pointing at the same track however the library grows.
+// The control lock is only held for one slice at a time and released
+// while the socket drains, so a slow reader can't stall playback control.
+static constexpr size_t kSliceTracks = 512;
+static constexpr size_t kMaxPageTracks = 100000;
+
+// GET /tracks?cursor=<id>&limit=<n>   ("offset" is accepted as an alias)
+static void handle_tracks(socket_t client, CommandContext &ctx, std::string_view query)
+{
+    size_t cursor = query_size(query, "cursor", query_size(query, "offset", 0));
+    size_t limit = std::min(query_size(query, "limit", 100), kMaxPageTracks);
+
+    ChunkedWriter w(client);
+    OutBuffer &out = w.buf();
+
+    size_t total = 0;
     {
-        player.seekBy(10.0);
-        send_http_response(client, 200, "{\"ok\":true,\"cmd\":\"ff\",\"delta\":10}");
+        std::lock_guard<std::mutex> lock(control_mutex());
+        total = ctx.playlist ? ctx.playlist->size() : 0;
     }
-    else if (lowerMethod == "post" && path == "/rew")
+    out << "{\"total\":" << total << ",\"cursor\":" << cursor << ",\"tracks\":[";
+
+    size_t next = cursor;
+    size_t emitted = 0;
+    bool more = true;
+    while (w.ok() && emitted < limit && more)
     {
-        player.seekBy(-10.0);
-        send_http_response(client, 200, "{\"ok\":true,\"cmd\":\"rew\",\"delta\":-10}");
+        {
+            std::lock_guard<std::mutex> lock(control_mutex());
+            const Playlist &playlist = *ctx.playlist;
+            size_t sliceEnd = std::min({playlist.size(), next + kSliceTracks, next + (limit - emitted)});
+            for (; next < sliceEnd; ++next, ++emitted)
+            {
+                if (emitted) out << ',';
+                append_track_json(out, playlist, next);
+            }
+            more = next < playlist.size();
+        }
+        w.flush();
     }
-    else if (lowerMethod == "post" && path == "/stop")
+
+    out << "],\"next_cursor\":";
+    if (more)
+        out << next;
+    else
+        out << "null";
+    out << '}';
+    w.finish();
+}
+
+// GET /search?q=<text>&cursor=<id>&limit=<n>
+static void handle_search(socket_t client, CommandContext &ctx, std::string_view query)
+{
+    thread_local std::string q;
+    if (!query_param(query, "q", q) || q.empty())
     {
-        player.stop();
-        send_http_response(client, 200, "{\"ok\":true,\"cmd\":\"stop\"}");
+        send_http_response(client, 400, "{\"error\":\"missing q\"}");
+        return;
     }
-    else
+    std::transform(q.begin(), q.end(), q.begin(), ::tolower);
+
+    size_t cursor = query_size(query, "cursor", 0);
+    size_t limit = std::min(query_size(query, "limit", 100), kMaxPageTracks);
+
+    ChunkedWriter w(client);
+    OutBuffer &out = w.buf();
+    out << "{\"query\":";
+    json::appendString(out, q);
+    out << ",\"cursor\":" << cursor << ",\"tracks\":[";
+
+    // Scan a bounded slice per lock hold; matches are serialized as found.
+    constexpr size_t kSliceScan = 8192;
+    size_t next = cursor;
+    size_t emitted = 0;
+    bool more = true;
+    while (w.ok() && emitted < limit && more)
     {
-        send_http_response(client, 404, "{\"error\":\"not found\"}");
+        {
+            std::lock_guard<std::mutex> lock(control_mutex());
+            const Playlist &playlist = *ctx.playlist;
+            size_t sliceEnd = std::min(playlist.size(), next + kSliceScan);
+            for (; next < sliceEnd && emitted < limit; ++next)
+            {
+                if (!playlist.trackMatches(next, q))
+                    continue;
+                if (emitted) out << ',';
+                append_track_json(out, playlist, next);
+                ++emitted;
+            }
+            more = next < playlist.size();
+        }
+        w.maybeFlush();
     }
 
-    close_socket(client);
+    out << "],\"next_cursor\":";
+    if (more)
+        out << next;
+    else
+        out << "null";
+    out << '}';
+    w.finish();
 }
 
-void start_http_server(Player &player, std::shared_ptr<Playlist> playlist, int port)
+// ---- Audio streaming (GET /stream/current, GET /stream/<id>) ----
+
+// Streams are driven by a single pump thread that polls every client
+// socket for writability and moves file bytes with sendfile() where the
+// platform has it, so hundreds of listeners cost one thread and no
+// userspace copies. The HTTP thread only parses the request, sends the
+// headers and hands the socket over.
+class StreamPump
 {
-    std::thread([&player, playlist, port]()
-                {
-#ifdef _WIN32
-                    WSADATA wsaData;
-                    int wsaInit = WSAStartup(MAKEWORD(2, 2), &wsaData);
-                    if (wsaInit != 0)
-                    {
-                        std::cerr << "[HTTP] WSAStartup failed: " << wsaInit << "\n";
-                        return;
-                    }
-#endif
+public:
+    static constexpr size_t kMaxStreams = 256;
 
-                    socket_t serverSock = socket(AF_INET, SOCK_STREAM, 0);
-                    if (serverSock == INVALID_SOCKET_FD)
-                    {
-                        std::cerr << "[HTTP] Failed to create socket\n";
-#ifdef _WIN32
-                        WSACleanup();
+    static StreamPump &instance()
+    {
+        static StreamPump pump;
+        return pump;
+    }
+
+    // Takes ownership of `client` (headers already sent) and `file`, and
+    // streams bytes [offset, offset + length). Returns false when full;
+    // the caller still owns both handles then.
+    bool add(socket_t client, int file, uint64_t offset, uint64_t length)
+    {
+        if (active_.load() >= kMaxStreams)
+            return false;
+
+        set_nonblocking(client);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            incoming_.push_back(Stream{client, file, offset, length, length, Clock::now()});
+        }
+        active_.fetch_add(1);
+        wake();
+        return true;
+    }
+
+    size_t active() const { return active_.load(); }
+
+private:
+    struct Stream
+    {
+        socket_t client;
+        int file;
+        uint64_t offset;
+        uint64_t remaining;
+        uint64_t total;
+        Clock::time_point started;
+    };
+
+    // Bytes moved per stream per wakeup, so one fast reader can't starve the rest.
+    static constexpr size_t kBudgetBytes = 512 * 1024;
+
+    StreamPump()
+    {
+#ifndef _WIN32
+        // sendfile() has no MSG_NOSIGNAL; a listener hanging up must not kill us.
+        std::signal(SIGPIPE, SIG_IGN);
+        int fds[2];
+        if (pipe(fds) == 0)
+        {
+            wakeRead_ = fds[0];
+            wakeWrite_ = fds[1];
+            fcntl(wakeRead_, F_SETFL, O_NONBLOCK);
+            fcntl(wakeWrite_, F_SETFL, O_NONBLOCK);
+        }
 #endif
-                        return;
-                    }
+        std::thread([this]() { run(); }).detach();
+    }
 
-                    int opt = 1;
-                    setsockopt(serverSock, SOL_SOCKET, SO_REUSEADDR,
-                               reinterpret_cast<char *>(&opt), sizeof(opt));
+    static void set_nonblocking(socket_t s)
+    {
+#ifdef _WIN32
+        u_long on = 1;
+        ioctlsocket(s, FIONBIO, &on);
+#else
+        fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK);
+#endif
+    }
 
-                    sockaddr_in addr{};
-                    addr.sin_family = AF_INET;
-                    addr.sin_port = htons(static_cast<uint16_t>(port));
-                    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK); // 127.0.0.1
+    void wake()
+    {
+#ifndef _WIN32
+        if (wakeWrite_ >= 0)
+        {
+            char c = 1;
+            (void)!write(wakeWrite_, &c, 1);
+        }
+#endif
+    }
 
-                    if (bind(serverSock, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0)
-                    {
-                        std::cerr << "[HTTP] bind failed on port " << port << "\n";
-                        close_socket(serverSock);
+    static bool would_block()
+    {
 #ifdef _WIN32
-                        WSACleanup();
+        return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+        return errno == EAGAIN || errno == EWOULDBLOCK;
 #endif
-                        return;
-                    }
+    }
 
-                    if (listen(serverSock, 8) < 0)
-                    {
-                        std::cerr << "[HTTP] listen failed\n";
-                        close_socket(serverSock);
+    // Moves up to kBudgetBytes. Returns false once the stream is done
+    // (fully sent, client gone, or read error).
+    static bool pump(Stream &s)
+    {
+        size_t budget = kBudgetBytes;
+        while (s.remaining > 0 && budget > 0)
+        {
+            size_t want = static_cast<size_t>(std::min<uint64_t>(s.remaining, budget));
+#if defined(__linux__)
+            off_t off = static_cast<off_t>(s.offset);
+            ssize_t n = sendfile(s.client, s.file, &off, want);
+#else
+            // Portable fallback: one bounce buffer for the pump thread.
+            static char bounce[64 * 1024];
+            want = std::min(want, sizeof(bounce));
 #ifdef _WIN32
-                        WSACleanup();
+            if (_lseeki64(s.file, static_cast<__int64>(s.offset), SEEK_SET) < 0)
+                return false;
+            int got = _read(s.file, bounce, static_cast<unsigned>(want));
+#else
+            ssize_t got = pread(s.file, bounce, want, static_cast<off_t>(s.offset));
 #endif
-                        return;
-                    }
+            if (got <= 0)
+                return false;
+            long long n = send(s.client, bounce, static_cast<int>(got), SEND_FLAGS);
+#endif
+            if (n > 0)
+            {
+                s.offset += static_cast<uint64_t>(n);
+                s.remaining -= static_cast<uint64_t>(n);
+                budget -= static_cast<size_t>(n);
+                continue;
+            }
+            if (n < 0 && would_block())
+                return true;
+#ifndef _WIN32
+            if (n < 0 && errno == EINTR)
+                continue;
+#endif
+            return false; // error, or the file shrank under us
+        }
+        return s.remaining > 0;
+    }
+
+    void finish(const Stream &s)
+    {
+        double secs = std::chrono::duration<double>(Clock::now() - s.started).count();
+        double sent = static_cast<double>(s.total - s.remaining);
+        AERIAL_INFO("HTTP", "stream ", (s.remaining ? "aborted" : "done"), ": ",
+                    static_cast<long long>(sent / 1024), " KiB in ",
+                    static_cast<long long>(secs * 1000), " ms (",
+                    static_cast<long long>(secs > 0 ? sent / secs / (1024 * 1024) : 0), " MiB/s), ",
+                    active_.load() - 1, " still active");
+        close_socket(s.client);
+#ifdef _WIN32
+        _close(s.file);
+#else
+        close(s.file);
+#endif
+        active_.fetch_sub(1);
+    }
 
-                    std::cout << "[HTTP] Listening on http://127.0.0.1:" << port << "\n";
+    void run()
+    {
+        std::vector<Stream> streams;
+        std::vector<pollfd> fds;
+#ifdef _WIN32
+        const int timeoutMs = 50; // WSAPoll can't watch a wake pipe
+#else
+        const int timeoutMs = -1;
+#endif
+
+        while (true)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                for (auto &st : incoming_)
+                    streams.push_back(st);
+                incoming_.clear();
+            }
+
+            fds.clear();
+#ifndef _WIN32
+            fds.push_back(pollfd{wakeRead_, POLLIN, 0});
+#endif
+            const size_t first = fds.size();
+            for (const auto &st : streams)
+                fds.push_back(pollfd{st.client, POLLOUT, 0});
 
-                    while (true)
-                    {
-                        sockaddr_in clientAddr{};
 #ifdef _WIN32
-                        int clientLen = sizeof(clientAddr);
+            if (fds.empty())
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+                continue;
+            }
+            int ready = WSAPoll(fds.data(), static_cast<ULONG>(fds.size()), timeoutMs);
 #else
-                        socklen_t clientLen = sizeof(clientAddr);
+            int ready = poll(fds.data(), fds.size(), timeoutMs);
 #endif
-                        socket_t clientSock = accept(serverSock,
-                                                     reinterpret_cast<sockaddr *>(&clientAddr),
-                                                     &clientLen);
+            if (ready < 0)
+                continue;
+
+#ifndef _WIN32
+            if (fds[0].revents & POLLIN)
+            {
+                char drain[64];
+                while (read(wakeRead_, drain, sizeof(drain)) > 0)
+                {
+                }
+            }
+#endif
+
+            // Walk backwards so swap-removal doesn't skip a stream.
+            for (size_t i = streams.size(); i-- > 0;)
+            {
+                short rev = fds[first + i].revents;
+                if (!(rev & (POLLOUT | POLLERR | POLLHUP)))
+                    continue;
+                if ((rev & (POLLERR | POLLHUP)) || !pump(streams[i]))
+                {
+                    finish(streams[i]);
+                    streams[i] = streams.back();
+                    streams.pop_back();
+                }
+            }
+        }
+    }
+
+    std::mutex mutex_;
+    std::vector<Stream> incoming_;
+    std::atomic<size_t> active_{0};
+    int wakeRead_ = -1;
+    int wakeWrite_ = -1;
+};
+
+static const char *audio_content_type(std::string_view path)
+{
+    size_t dot = path.rfind('.');
+    if (dot == std::string_view::npos)
+        return "application/octet-stream";
+    char ext[8] = {};
+    std::string_view raw = path.substr(dot + 1);
+    for (size_t i = 0; i < raw.size() && i < sizeof(ext) - 1; ++i)
+        ext[i] = static_cast<char>(std::tolower(static_cast<unsigned char>(raw[i])));
+    std::string_view e(ext);
+    if (e == "mp3")  return "audio/mpeg";
+    if (e == "ogg")  return "audio/ogg";
+    if (e == "flac") return "audio/flac";
+    if (e == "wav")  return "audio/wav";
+    if (e == "m4a")  return "audio/mp4";
+    return "application/octet-stream";
+}
+
+// Parses a single "bytes=first-last" / "bytes=first-" / "bytes=-suffix"
+// range against `size` into an inclusive [first, last]. Returns false if
+// the range can't be satisfied. Anything we don't understand (including
+// multi-range requests) is served as a plain 200 by leaving `partial` unset.
+static bool parse_byte_range(std::string_view header, uint64_t size,
+                             uint64_t &first, uint64_t &last, bool &partial)
+{
+    partial = false;
+    first = 0;
+    last = size ? size - 1 : 0;
+    if (header.empty() || !starts_with_nocase(header, "bytes=") ||
+        header.find(',') != std::string_view::npos)
+        return true;
+
+    std::string_view spec = trim(header.substr(6));
+    size_t dash = spec.find('-');
+    if (dash == std::string_view::npos)
+        return true;
+
+    std::string_view a = trim(spec.substr(0, dash));
+    std::string_view b = trim(spec.substr(dash + 1));
+    uint64_t x = 0, y = 0;
+    bool haveA = !a.empty() && std::from_chars(a.data(), a.data() + a.size(), x).ptr == a.data() + a.size();
+    bool haveB = !b.empty() && std::from_chars(b.data(), b.data() + b.size(), y).ptr == b.data() + b.size();
+
+    if (haveA)
+    {
+        if (haveB && y < x)
+            return true; // syntactically invalid: ignore the header
+        if (x >= size)
+            return false;
+        first = x;
+        last = haveB ? std::min(y, size - 1) : size - 1;
+    }
+    else if (haveB)
+    {
+        if (y == 0)
+            return false;
+        first = (y >= size) ? 0 : size - y;
+        last = size - 1;
+    }
+    else
+    {
+        return true;
+    }
+    partial = true;
+    return true;
+}
+
+static int open_track_file(const std::string &utf8Path, uint64_t &size)
+{
+#ifdef _WIN32
+    std::filesystem::path p = std::filesystem::u8path(utf8Path);
+    int fd = _wopen(p.c_str(), _O_RDONLY | _O_BINARY);
+    if (fd < 0)
+        return -1;
+    struct _stat64 st;
+    if (_fstat64(fd, &st) != 0)
+    {
+        _close(fd);
+        return -1;
+    }
+#else
+    int fd = open(utf8Path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+    {
+        close(fd);
+        return -1;
+    }
+#endif
+    size = static_cast<uint64_t>(st.st_size);
+    return fd;
+}
+
+// GET|HEAD /stream/current, /stream/<id>. Returns true if the socket was
+// handed to the stream pump (which then owns and closes it).
+static bool handle_stream(socket_t client, CommandContext &ctx, std::string_view which,
+                          std::string_view rangeHeader, bool headOnly)
+{
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(control_mutex());
+        const Playlist *playlist = ctx.playlist.get();
+        if (playlist && !playlist->empty())
+        {
+            if (which == "current")
+            {
+                path = playlist->current();
+            }
+            else
+            {
+                size_t id = 0;
+                auto res = std::from_chars(which.data(), which.data() + which.size(), id);
+                if (res.ec == std::errc() && res.ptr == which.data() + which.size() && id < playlist->size())
+                    path = playlist->trackAt(id);
+            }
+        }
+    }
+    if (path.empty())
+    {
+        send_http_response(client, 404, "{\"error\":\"no such track\"}");
+        return false;
+    }
+
+    uint64_t size = 0;
+    int file = open_track_file(path, size);
+    if (file < 0)
+    {
+        send_http_response(client, 404, "{\"error\":\"track file unavailable\"}");
+        return false;
+    }
+
+    auto close_file = [file]() {
+#ifdef _WIN32
+        _close(file);
+#else
+        close(file);
+#endif
+    };
+
+    thread_local OutBuffer head(512);
+    head.clear();
+
+    uint64_t first = 0, last = 0;
+    bool partial = false;
+    if (!parse_byte_range(rangeHeader, size, first, last, partial))
+    {
+        head << "HTTP/1.1 416 Range Not Satisfiable\r\n"
+             << "Content-Range: bytes */" << size << "\r\n"
+             << "Content-Length: 0\r\n"
+             << "Connection: close\r\n\r\n";
+        const std::string_view parts[] = {head.view()};
+        send_all(client, parts, 1);
+        close_file();
+        return false;
+    }
+
+    if (StreamPump::instance().active() >= StreamPump::kMaxStreams)
+    {
+        send_http_response(client, 503, "{\"error\":\"too many streams\"}");
+        close_file();
+        return false;
+    }
+
+    uint64_t length = size ? last - first + 1 : 0;
+    head << "HTTP/1.1 " << (partial ? "206 Partial Content" : "200 OK") << "\r\n"
+         << "Content-Type: " << audio_content_type(path) << "\r\n"
+         << "Content-Length: " << length << "\r\n"
+         << "Accept-Ranges: bytes\r\n"
+         << "Access-Control-Allow-Origin: *\r\n";
+    if (partial)
+        head << "Content-Range: bytes " << first << '-' << last << '/' << size << "\r\n";
+    head << "Connection: close\r\n\r\n";
+
+    const std::string_view parts[] = {head.view()};
+    if (!send_all(client, parts, 1) || headOnly || length == 0 ||
+        !StreamPump::instance().add(client, file, first, length))
+    {
+        close_file();
+        return false;
+    }
+    return true;
+}
+
+// Collects the strings of a top-level JSON array end to end in one arena,
+// so a warmed-up thread parses a batch without allocating. Anything but a
+// string at the top level marks the item invalid; the parse only stops
+// early once there are more items than a batch may hold.
+class BatchHandler : public json::Handler
+{
+public:
+    static constexpr size_t kNone = static_cast<size_t>(-1);
+
+    BatchHandler(std::string &arena, std::vector<size_t> &ends, size_t maxItems)
+        : arena_(arena), ends_(ends), maxItems_(maxItems)
+    {
+        arena_.clear();
+        ends_.clear();
+    }
+
+    bool isArray() const { return isArray_; }
+    bool tooMany() const { return tooMany_; }
+    size_t count() const { return ends_.size(); }
+    size_t firstInvalid() const { return firstInvalid_; }
+
+    std::string_view item(size_t i) const
+    {
+        const size_t begin = i ? ends_[i - 1] : 0;
+        return std::string_view(arena_).substr(begin, ends_[i] - begin);
+    }
+
+    bool onBeginArray() override
+    {
+        if (depth_++ == 0)
+        {
+            isArray_ = true;
+            return true;
+        }
+        return depth_ > 2 || add(false);
+    }
+    bool onEndArray() override { --depth_; return true; }
+    bool onBeginObject() override { return depth_++ != 1 || add(false); }
+    bool onEndObject() override { --depth_; return true; }
+    bool onNull() override { return depth_ != 1 || add(false); }
+    bool onBool(bool) override { return depth_ != 1 || add(false); }
+    bool onNumber(const json::Number &) override { return depth_ != 1 || add(false); }
+
+    bool onString(std::string_view s) override
+    {
+        if (depth_ != 1)
+            return true;
+        arena_.append(s.data(), s.size());
+        return add(true);
+    }
+
+private:
+    bool add(bool valid)
+    {
+        if (ends_.size() == maxItems_)
+        {
+            tooMany_ = true;
+            return false;
+        }
+        if (!valid && firstInvalid_ == kNone)
+            firstInvalid_ = ends_.size();
+        ends_.push_back(arena_.size());
+        return true;
+    }
+
+    std::string &arena_;
+    std::vector<size_t> &ends_;
+    const size_t maxItems_;
+    size_t firstInvalid_ = kNone;
+    int depth_ = 0;
+    bool isArray_ = false;
+    bool tooMany_ = false;
+};
+
+// POST /batch — body is a JSON array of command strings, e.g.
+//   ["jump 3", "seek 30", "vol 40", "play", "@kitchen next"]
+// Every command is validated before any runs; then the whole batch runs
+// under control_mutex() so no other client's command can interleave.
+// Zone tracks are decoded before the lock is taken (prefetch_command).
+static void handle_batch(socket_t client, CommandContext &ctx, std::string_view body)
+{
+    constexpr size_t kMaxBatch = 256;
+
+    thread_local OutBuffer out(1024);
+    thread_local OutBuffer results(1024);
+    thread_local OutBuffer ack(128);
+    thread_local json::Reader reader;
+    thread_local std::string arena;
+    thread_local std::vector<size_t> ends;
+    out.clear();
+
+    BatchHandler batch(arena, ends, kMaxBatch);
+    const bool parsed = reader.parse(body, batch);
+    if (!parsed && !batch.tooMany())
+    {
+        send_http_response(client, 400, "{\"error\":\"body must be a JSON array of commands\"}");
+        return;
+    }
+
+    if (!batch.isArray() || batch.tooMany() || batch.count() == 0)
+    {
+        send_http_response(client, 400, "{\"error\":\"body must be a JSON array of 1-256 commands\"}");
+        return;
+    }
+
+    Command cmds[kMaxBatch];
+    const size_t count = batch.count();
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (i == batch.firstInvalid() || !parse_command(batch.item(i), cmds[i]))
+        {
+            out << "{\"ok\":false,\"error\":\"invalid command\",\"index\":" << i << '}';
+            send_http_response(client, 400, out.view());
+            return;
+        }
+    }
+
+    // Each prefetch sees the state before the batch, so a second play on
+    // the same zone may still miss and decode under the lock.
+    for (size_t i = 0; i < count; ++i)
+        prefetch_command(ctx, cmds[i]);
+
+    bool allOk = true;
+    results.clear();
+    auto t0 = Clock::now();
+    {
+        std::lock_guard<std::mutex> lock(control_mutex());
+        for (size_t i = 0; i < count; ++i)
+        {
+            ack.clear();
+            ScopedTimer timer(metrics().command(CommandSource::Http));
+            bool ok = execute_command(ctx, cmds[i], ack);
+            timer.stop();
+            allOk = allOk && ok;
+            if (i) results << ',';
+            results << "{\"cmd\":";
+            json::appendString(results, batch.item(i));
+            results << ",\"ok\":" << (ok ? "true" : "false") << ",\"reply\":";
+            json::appendString(results, ack.view());
+            results << '}';
+        }
+    }
+    auto elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - t0).count();
+
+    // Per-command failures (e.g. a jump out of range) are reported in the
+    // body; the batch itself was accepted, so the status stays 200.
+    out << "{\"ok\":" << (allOk ? "true" : "false")
+        << ",\"count\":" << count
+        << ",\"results\":[" << results.view() << ']'
+        << ",\"elapsed_us\":" << static_cast<long long>(elapsedUs)
+        << ",\"commands_per_sec\":"
+        << static_cast<long long>(elapsedUs > 0 ? count * 1000000.0 / elapsedUs : 0) << '}';
+    send_http_response(client, 200, out.view());
+}
+
+// ---- Play history: GET /stats/... ----
+//
+//   /stats/top      ?limit=10 [&days=N | &from=<unix>&to=<unix>]
+//   /stats/skipped  same parameters
+//   /stats/recent   ?limit=20
+//   /stats/daily    ?days=30 or &from=&to=   (UTC days)
+//   /stats/track    ?path=<track path>
+//
+// Without a window, top/skipped rank all-time totals. All of them are
+// index lookups in PlayDatabase, so they don't depend on history size.
+
+static bool stats_window(std::string_view query, size_t defaultDays, StatsWindow &window)
+{
+    size_t days = query_size(query, "days", defaultDays);
+    if (days > 0)
+    {
+        int64_t now = static_cast<int64_t>(std::time(nullptr));
+        window.from = now - static_cast<int64_t>(days) * 86400;
+        window.to = now + 1;
+    }
+    window.from = static_cast<int64_t>(query_size(query, "from", static_cast<size_t>(window.from)));
+    window.to = static_cast<int64_t>(query_size(query, "to", static_cast<size_t>(window.to)));
+    return window.from < window.to;
+}
+
+static void append_stats_window(OutBuffer &out, const StatsWindow &window)
+{
+    if (!window.all())
+        out << ",\"from\":" << static_cast<long long>(window.from)
+            << ",\"to\":" << static_cast<long long>(window.to);
+}
+
+static void handle_stats(socket_t client, CommandContext &ctx,
+                         std::string_view which, std::string_view query)
+{
+    constexpr size_t kMaxStatsRows = 1000;
+
+    if (!ctx.db || !ctx.db->ok())
+    {
+        send_http_response(client, 503, "{\"error\":\"play database unavailable\"}");
+        return;
+    }
+
+    thread_local OutBuffer out(4096);
+    thread_local std::vector<TrackCount> tracks;
+    thread_local std::vector<RecentPlay> recent;
+    thread_local std::vector<DayCount> days;
+    thread_local std::string path;
+    out.clear();
+
+    const size_t limit = std::min(query_size(query, "limit", which == "recent" ? 20 : 10),
+                                  kMaxStatsRows);
+    StatsWindow window;
+    bool ok = true;
+    auto t0 = Clock::now();
+
+    if (which == "top" || which == "skipped")
+    {
+        if (!stats_window(query, 0, window))
+        {
+            send_http_response(client, 400, "{\"error\":\"from must be before to\"}");
+            return;
+        }
+        ok = (which == "top") ? ctx.db->topPlayed(limit, window, tracks)
+                              : ctx.db->mostSkipped(limit, window, tracks);
+        out << "{\"ok\":" << (ok ? "true" : "false");
+        append_stats_window(out, window);
+        out << ",\"tracks\":[";
+        for (size_t i = 0; i < tracks.size(); ++i)
+        {
+            if (i) out << ',';
+            json::Writer(out).beginObject()
+                .field("path", tracks[i].path)
+                .field("title", tracks[i].title)
+                .field("count", static_cast<long long>(tracks[i].count))
+                .endObject();
+        }
+        out << ']';
+    }
+    else if (which == "recent")
+    {
+        ok = ctx.db->recentlyPlayed(limit, recent);
+        out << "{\"ok\":" << (ok ? "true" : "false") << ",\"plays\":[";
+        for (size_t i = 0; i < recent.size(); ++i)
+        {
+            if (i) out << ',';
+            json::Writer(out).beginObject()
+                .field("path", recent[i].path)
+                .field("title", recent[i].title)
+                .field("ts", static_cast<long long>(recent[i].timestamp))
+                .endObject();
+        }
+        out << ']';
+    }
+    else if (which == "daily")
+    {
+        if (!stats_window(query, 30, window))
+        {
+            send_http_response(client, 400, "{\"error\":\"from must be before to\"}");
+            return;
+        }
+        ok = ctx.db->dailyCounts(window, days);
+        out << "{\"ok\":" << (ok ? "true" : "false");
+        append_stats_window(out, window);
+        out << ",\"days\":[";
+        for (size_t i = 0; i < days.size(); ++i)
+        {
+            if (i) out << ',';
+            out << "{\"day\":" << static_cast<long long>(days[i].day)
+                << ",\"plays\":" << static_cast<long long>(days[i].plays)
+                << ",\"skips\":" << static_cast<long long>(days[i].skips)
+                << ",\"finishes\":" << static_cast<long long>(days[i].finishes) << '}';
+        }
+        out << ']';
+    }
+    else if (which == "track")
+    {
+        TrackStats st;
+        if (!query_param(query, "path", path) || path.empty())
+        {
+            send_http_response(client, 400, "{\"error\":\"missing path\"}");
+            return;
+        }
+        if (!ctx.db->getTrackStats(path, st))
+        {
+            send_http_response(client, 404, "{\"error\":\"no history for track\"}");
+            return;
+        }
+        out << "{\"ok\":true,\"path\":";
+        json::appendString(out, path);
+        out << ",\"plays\":" << static_cast<long long>(st.plays)
+            << ",\"skips\":" << static_cast<long long>(st.skips)
+            << ",\"finishes\":" << static_cast<long long>(st.finishes)
+            << ",\"last_played\":";
+        json::appendString(out, st.lastPlayed);
+        out << ",\"score\":";
+        json::Writer(out).valueFixed(st.score, 1);
+    }
+    else
+    {
+        send_http_response(client, 404, "{\"error\":\"not found\"}");
+        return;
+    }
+
+    auto elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - t0).count();
+    out << ",\"elapsed_us\":" << static_cast<long long>(elapsedUs) << '}';
+    send_http_response(client, ok ? 200 : 503, out.view());
+}
+
+// ---- Play queue: /queue/... ----
+//
+//   GET  /queue          ?offset=0&limit=50    what plays next, front first
+//   POST /queue/add      ?track=N [&pos=P]     at the end, or at position P
+//   POST /queue/next     ?track=N              at the front ("play next")
+//   POST /queue/remove   ?pos=P
+//   POST /queue/move     ?from=P&to=Q
+//   POST /queue/clear
+//
+// The same routes exist per zone under /zones/<name>/queue. Edits run as
+// the queue commands of parse_command, so TCP and /batch behave alike.
+// `rest` is the path after "/queue".
+static void handle_queue(socket_t client, CommandContext &ctx, std::string_view method,
+                         std::string_view rest, std::string_view query, size_t zone)
+{
+    constexpr size_t kMaxItems = 1000;
+    thread_local OutBuffer out(4096);
+    thread_local std::vector<uint32_t> items;
+    out.clear();
+
+    if (method == "get" && (rest.empty() || rest == "/"))
+    {
+        const size_t offset = query_size(query, "offset", 0);
+        const size_t limit = std::min(query_size(query, "limit", 50), kMaxItems);
+        items.clear();
+        {
+            std::lock_guard<std::mutex> lock(control_mutex());
+            const Zone *z = zone_at(zone);
+            const Playlist *playlist = ctx.playlist.get();
+            const PlayQueue *queue = z ? &z->queue() : (playlist ? &playlist->queue() : nullptr);
+            const size_t size = queue ? queue->size() : 0;
+            if (queue && playlist)
+                queue->copyRange(offset, limit, items);
+
+            json::Writer w(out);
+            w.beginObject().field("zone", zone_name(zone)).field("size", size).field("offset", offset);
+            w.key("items").beginArray();
+            for (size_t i = 0; i < items.size(); ++i)
+                w.beginObject().field("pos", offset + i).field("id", items[i])
+                    .field("title", playlist->title(items[i])).endObject();
+            w.endArray().endObject();
+        }
+        send_http_response(client, 200, out.view());
+        return;
+    }
+
+    thread_local std::string text;
+    thread_local std::string first;
+    thread_local std::string second;
+    const bool post = method == "post";
+    bool known = post;
+    if (post && rest == "/add" && query_param(query, "pos", first) && query_param(query, "track", second))
+        text = "qinsert " + first + ' ' + second;
+    else if (post && rest == "/add" && query_param(query, "track", first))
+        text = "queue " + first;
+    else if (post && rest == "/next" && query_param(query, "track", first))
+        text = "playnext " + first;
+    else if (post && rest == "/remove" && query_param(query, "pos", first))
+        text = "qremove " + first;
+    else if (post && rest == "/move" && query_param(query, "from", first) && query_param(query, "to", second))
+        text = "qmove " + first + ' ' + second;
+    else if (post && rest == "/clear")
+        text = "qclear";
+    else
+        known = false;
+
+    ScopedTimer timer(metrics().command(CommandSource::Http));
+    Command cmd;
+    if (!known || !parse_command(text, cmd))
+    {
+        timer.cancel();
+        send_http_response(client, known ? 400 : 404,
+                           known ? "{\"error\":\"invalid queue position or track\"}"
+                                 : "{\"error\":\"not found\"}");
+        return;
+    }
+    cmd.zone = static_cast<uint16_t>(zone);
+
+    thread_local OutBuffer ack(128);
+    ack.clear();
+    bool ok;
+    {
+        std::lock_guard<std::mutex> lock(control_mutex());
+        ok = execute_command(ctx, cmd, ack);
+    }
+    timer.stop();
+
+    json::Writer w(out);
+    w.beginObject().field("ok", ok).field("zone", zone_name(zone)).field("reply", ack.view()).endObject();
+    send_http_response(client, ok ? 200 : 400, out.view());
+}
+
+// ---- Zones: /zones/... ----
+//
+//   GET  /zones                       every zone plus decode cache stats
+//   GET  /zones/<name>/status         one zone ("main" included)
+//   POST /zones/<name>/<command>      play, pause, next, ... as on /play etc.;
+//        ?value=N                     the argument of seek, vol and jump
+//   GET|POST /zones/<name>/queue/...  as /queue above, for that zone
+//
+// `rest` is the path after "/zones".
+static void handle_zones(socket_t client, CommandContext &ctx,
+                         std::string_view method, std::string_view rest, std::string_view query)
+{
+    thread_local OutBuffer out(1024);
+    out.clear();
+
+    if (rest.empty() || rest == "/")
+    {
+        if (method != "get")
+        {
+            send_http_response(client, 404, "{\"error\":\"not found\"}");
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(control_mutex());
+            appendZonesJson(out, ctx.player, ctx.playlist.get());
+        }
+        send_http_response(client, 200, out.view());
+        return;
+    }
+
+    rest.remove_prefix(1);
+    size_t slash = rest.find('/');
+    const size_t zone = find_zone(rest.substr(0, slash));
+    std::string_view action = (slash == std::string_view::npos) ? std::string_view() : rest.substr(slash + 1);
+    if (zone == kNoZone || action.empty())
+    {
+        send_http_response(client, 404, "{\"error\":\"unknown zone\"}");
+        return;
+    }
+
+    if (action == "queue" || action.substr(0, 6) == "queue/")
+    {
+        handle_queue(client, ctx, method, action.substr(5), query, zone);
+        return;
+    }
+
+    if (method == "get" && action == "status")
+    {
+        {
+            std::lock_guard<std::mutex> lock(control_mutex());
+            appendZoneJson(out, zone, ctx.player, ctx.playlist.get());
+        }
+        send_http_response(client, 200, out.view());
+        return;
+    }
+
+    if (method != "post" || action.size() > 16)
+    {
+        send_http_response(client, 404, "{\"error\":\"not found\"}");
+        return;
+    }
+
+    ScopedTimer timer(metrics().command(CommandSource::Http));
+    thread_local std::string text;
+    thread_local std::string value;
+    text.assign(action.data(), action.size());
+    if (query_param(query, "value", value))
+    {
+        text += ' ';
+        text += value;
+    }
+    Command cmd;
+    if (!parse_command(text, cmd))
+    {
+        timer.cancel();
+        send_http_response(client, 400, "{\"error\":\"invalid command\"}");
+        return;
+    }
+    cmd.zone = static_cast<uint16_t>(zone);
+
+    thread_local OutBuffer ack(128);
+    ack.clear();
+    bool ok;
+    prefetch_command(ctx, cmd);
+    {
+        std::lock_guard<std::mutex> lock(control_mutex());
+        ok = execute_command(ctx, cmd, ack);
+    }
+    timer.stop();
+
+    json::Writer w(out);
+    w.beginObject().field("ok", ok).field("zone", zone_name(zone)).field("reply", ack.view()).endObject();
+    send_http_response(client, ok ? 200 : 400, out.view());
+}
+
+static void handle_http_client(socket_t client,
+                               CommandContext &ctx)
+{
+    ConnectionScope connection(Server::Http);
+    AERIAL_SPAN("HTTP request");
+    thread_local std::string req;
+    size_t headerLen = 0;
+    size_t bodyLen = 0;
+    if (!read_http_request(client, req, headerLen, bodyLen))
+    {
+        close_socket(client);
+        return;
+    }
+
+    // Extract request line: "<METHOD> <PATH> <VERSION>"
+    std::string_view requestLine(req.data(), req.find("\r\n"));
+    size_t sp1 = requestLine.find(' ');
+    size_t sp2 = (sp1 == std::string_view::npos) ? sp1 : requestLine.find(' ', sp1 + 1);
+    if (sp2 == std::string_view::npos)
+    {
+        send_http_response(client, 400, "{\"error\":\"bad request\"}");
+        close_socket(client);
+        return;
+    }
+
+    // Methods are case-sensitive per RFC, but we've always accepted any case.
+    char methodBuf[8];
+    std::string_view rawMethod = requestLine.substr(0, sp1);
+    std::string_view lowerMethod;
+    if (rawMethod.size() <= sizeof(methodBuf))
+    {
+        for (size_t i = 0; i < rawMethod.size(); ++i)
+            methodBuf[i] = static_cast<char>(std::tolower(static_cast<unsigned char>(rawMethod[i])));
+        lowerMethod = std::string_view(methodBuf, rawMethod.size());
+    }
+    std::string_view target = requestLine.substr(sp1 + 1, sp2 - sp1 - 1);
+    std::string_view body(req.data() + headerLen, bodyLen);
+
+    // Split "/path?query"
+    size_t qmark = target.find('?');
+    std::string_view path = target.substr(0, qmark);
+    std::string_view query = (qmark == std::string_view::npos) ? std::string_view() : target.substr(qmark + 1);
+
+    // Single-command routes and their (historical) JSON replies.
+    struct Route { const char *path; const char *command; const char *reply; };
+    static const Route routes[] = {
+        {"/play",   "play",   "{\"ok\":true,\"cmd\":\"play\"}"},
+        {"/pause",  "pause",  "{\"ok\":true,\"cmd\":\"pause\"}"},
+        {"/resume", "resume", "{\"ok\":true,\"cmd\":\"resume\"}"},
+        {"/next",   "next",   "{\"ok\":true,\"cmd\":\"next\"}"},
+        {"/prev",   "prev",   "{\"ok\":true,\"cmd\":\"prev\"}"},
+        {"/ff",     "ff",     "{\"ok\":true,\"cmd\":\"ff\",\"delta\":10}"},
+        {"/rew",    "rew",    "{\"ok\":true,\"cmd\":\"rew\",\"delta\":-10}"},
+        {"/stop",   "stop",   "{\"ok\":true,\"cmd\":\"stop\"}"},
+    };
+
+    bool handedOff = false;
+
+    // Basic routing
+    if ((lowerMethod == "get" || lowerMethod == "head") && path.substr(0, 8) == "/stream/")
+    {
+        std::string_view headers(req.data(), headerLen);
+        handedOff = handle_stream(client, ctx, path.substr(8), find_header(headers, "range"),
+                                  lowerMethod == "head");
+    }
+    else if (lowerMethod == "get" && path == "/status")
+    {
+        thread_local OutBuffer out(512);
+        out.clear();
+        out << "{\"nowPlaying\":";
+        {
+            std::lock_guard<std::mutex> lock(control_mutex());
+            json::appendString(out, ctx.playlist && !ctx.playlist->empty()
+                                        ? std::string_view(ctx.playlist->current())
+                                        : std::string_view());
+        }
+        out << '}';
+        send_http_response(client, 200, out.view());
+    }
+    else if (lowerMethod == "get" && path == "/metrics")
+    {
+        thread_local OutBuffer out(16384);
+        out.clear();
+        appendPrometheus(out);
+        {
+            std::lock_guard<std::mutex> lock(control_mutex());
+            appendZoneMetrics(out);
+        }
+        send_http_response(client, 200, out.view(), "text/plain; version=0.0.4");
+    }
+    else if (lowerMethod == "get" && path == "/trace")
+    {
+        OutBuffer out(1 << 16);
+        tracing::appendChromeJson(out);
+        send_http_response(client, 200, out.view());
+    }
+    else if (lowerMethod == "get" && path == "/tracks")
+    {
+        handle_tracks(client, ctx, query);
+    }
+    else if (lowerMethod == "get" && path == "/search")
+    {
+        handle_search(client, ctx, query);
+    }
+    else if (lowerMethod == "get" && path.substr(0, 7) == "/stats/")
+    {
+        handle_stats(client, ctx, path.substr(7), query);
+    }
+    else if (lowerMethod == "post" && path == "/batch")
+    {
+        handle_batch(client, ctx, body);
+    }
+    else if (path == "/queue" || path.substr(0, 7) == "/queue/")
+    {
+        handle_queue(client, ctx, lowerMethod, path.substr(6), query, kMainZone);
+    }
+    else if (path == "/zones" || path.substr(0, 7) == "/zones/")
+    {
+        handle_zones(client, ctx, lowerMethod, path.substr(6), query);
+    }
+    else
+    {
+        const Route *route = nullptr;
+        if (lowerMethod == "post")
+        {
+            for (const auto &r : routes)
+            {
+                if (path == r.path)
+                {
+                    route = &r;
+                    break;
+                }
+            }
+        }
+
+        if (route)
+        {
+            ScopedTimer timer(metrics().command(CommandSource::Http));
+            Command cmd;
+            parse_command(route->command, cmd);
+            thread_local OutBuffer ack(64);
+            ack.clear();
+            {
+                std::lock_guard<std::mutex> lock(control_mutex());
+                execute_command(ctx, cmd, ack);
+            }
+            timer.stop();
+            send_http_response(client, 200, route->reply);
+        }
+        else
+        {
+            send_http_response(client, 404, "{\"error\":\"not found\"}");
+        }
+    }
+
+    if (!handedOff)
+        close_socket(client);
+}
+
+bool start_http_server(Player &player, std::shared_ptr<Playlist> playlist, PlayDatabase *db, int port)
+{
+#ifdef _WIN32
+    WSADATA wsaData;
+    int wsaInit = WSAStartup(MAKEWORD(2, 2), &wsaData);
+    if (wsaInit != 0)
+    {
+        AERIAL_ERROR("HTTP", "WSAStartup failed: ", wsaInit);
+        return false;
+    }
+#endif
+
+    auto listener = std::make_shared<LiveListener>("HTTP", &AerialConfig::http_port, port, 8);
+    if (!listener->open())
+    {
+#ifdef _WIN32
+        WSACleanup();
+#endif
+        return false;
+    }
+
+    std::thread([&player, playlist, db, listener]()
+                {
+                    tracing::setThreadName("http");
+                    CommandContext ctx{player, playlist, db};
+
+                    while (true)
+                    {
+                        socket_t clientSock = listener->accept();
                         if (clientSock == INVALID_SOCKET_FD)
                         {
-                            std::cerr << "[HTTP] accept failed, shutting down HTTP server thread\n";
+                            AERIAL_ERROR("HTTP", "accept failed, shutting down HTTP server thread");
                             break;
                         }
 
                         // For simplicity handle one client per accept synchronously.
-                        handle_http_client(clientSock, player, playlist);
+                        handle_http_client(clientSock, ctx);
                     }
 
-                    close_socket(serverSock);
-
+                    listener->close();
 #ifdef _WIN32
                     WSACleanup();
 #endif
                 })
         .detach();
+    return true;
+}
+
+// ===================== Unix domain socket (binary, see aerial_ipc.h) =====================
+
+#ifndef _WIN32
+
+static void append_u32(OutBuffer &out, uint32_t v)
+{
+    uint8_t b[4];
+    aerial_ipc_put_u32(b, v);
+    out.append(std::string_view(reinterpret_cast<const char *>(b), 4));
 }
+
+// Handles one request frame and appends the reply frame to `out`.
+static void handle_ipc_request(CommandContext &ctx, const uint8_t *req, uint32_t len,
+                               OutBuffer &body, OutBuffer &out)
+{
+    AERIAL_SPAN("IPC request");
+    const uint8_t op = req[0];
+    const uint8_t *args = req + 1;
+    const uint32_t argLen = len - 1;
+
+    uint8_t status = AERIAL_IPC_OK;
+    body.clear();
+
+    // Opcodes that map 1:1 onto a text command with no argument.
+    static const CommandOp simpleOps[] = {
+        CommandOp::Play, CommandOp::Pause, CommandOp::Resume, CommandOp::Next, CommandOp::Prev,
+        CommandOp::FastForward, CommandOp::Rewind, CommandOp::Stop,
+    };
+
+    Command cmd;
+    bool haveCommand = false;
+
+    if (op == AERIAL_OP_PING && argLen == 0)
+    {
+        body << "PONG";
+    }
+    else if (op >= AERIAL_OP_PLAY && op <= AERIAL_OP_STOP && argLen == 0)
+    {
+        cmd.op = simpleOps[op - AERIAL_OP_PLAY];
+        haveCommand = true;
+    }
+    else if ((op == AERIAL_OP_SEEK || op == AERIAL_OP_VOLUME || op == AERIAL_OP_JUMP) && argLen == 4)
+    {
+        uint32_t raw = aerial_ipc_get_u32(args);
+        if (op == AERIAL_OP_SEEK)
+        {
+            cmd.op = CommandOp::Seek;
+            cmd.arg = static_cast<int32_t>(raw) / 1000.0;
+        }
+        else if (op == AERIAL_OP_VOLUME)
+        {
+            cmd.op = CommandOp::Volume;
+            cmd.arg = static_cast<int32_t>(raw);
+        }
+        else
+        {
+            cmd.op = CommandOp::Jump;
+            cmd.arg = raw;
+        }
+        haveCommand = true;
+    }
+    else if (op == AERIAL_OP_STATUS && argLen == 0)
+    {
+        uint8_t fixed[AERIAL_IPC_STATUS_BODY_SIZE] = {};
+        std::lock_guard<std::mutex> lock(control_mutex());
+        const Playlist *playlist = ctx.playlist.get();
+        const bool haveTracks = playlist && !playlist->empty();
+        std::string_view path = haveTracks ? std::string_view(playlist->current()) : std::string_view();
+        if (path.size() > AERIAL_IPC_MAX_FRAME - 64)
+            path = path.substr(0, AERIAL_IPC_MAX_FRAME - 64);
+
+        aerial_ipc_put_u32(fixed + 0, haveTracks ? static_cast<uint32_t>(playlist->index()) : 0);
+        aerial_ipc_put_u32(fixed + 4, playlist ? static_cast<uint32_t>(playlist->size()) : 0);
+        aerial_ipc_put_u32(fixed + 8, static_cast<uint32_t>(static_cast<int32_t>(ctx.player.getPositionSeconds() * 1000.0)));
+        fixed[12] = static_cast<uint8_t>(ctx.player.getVolumePercent());
+        fixed[13] = static_cast<uint8_t>((ctx.player.isPlaying() ? 1 : 0) | (ctx.player.isPaused() ? 2 : 0));
+        aerial_ipc_put_u16(fixed + 14, static_cast<uint16_t>(path.size()));
+        body.append(std::string_view(reinterpret_cast<const char *>(fixed), sizeof(fixed)));
+        body.append(path);
+    }
+    else if (op == AERIAL_OP_TEXT)
+    {
+        std::string_view text(reinterpret_cast<const char *>(args), argLen);
+        if (parse_command(text, cmd))
+        {
+            haveCommand = true;
+        }
+        else
+        {
+            status = AERIAL_IPC_BAD_REQUEST;
+            body << "ERR unknown command";
+        }
+    }
+    else
+    {
+        status = AERIAL_IPC_BAD_REQUEST;
+        body << "ERR bad request";
+    }
+
+    if (haveCommand)
+    {
+        ScopedTimer timer(metrics().command(CommandSource::Ipc));
+        prefetch_command(ctx, cmd);
+        std::lock_guard<std::mutex> lock(control_mutex());
+        if (!execute_command(ctx, cmd, body))
+            status = AERIAL_IPC_FAILED;
+    }
+
+    append_u32(out, static_cast<uint32_t>(2 + body.size()));
+    out << static_cast<char>(op) << static_cast<char>(status);
+    out.append(body.view());
+}
+
+static void handle_ipc_client(int client, CommandContext ctx)
+{
+    // As with TCP, buffers live for the connection. All replies to the
+    // frames found in one read go back in one send: one recv + one send
+    // per request in the common case.
+    char buf[8192];
+    std::string pending;
+    OutBuffer body(512);
+    OutBuffer replies(4096);
+    ConnectionScope connection(Server::Ipc);
+    tracing::setThreadName("ipc-client");
+
+    while (true)
+    {
+        ssize_t n = recv(client, buf, sizeof(buf), 0);
+        if (n <= 0)
+            break;
+        pending.append(buf, static_cast<size_t>(n));
+        replies.clear();
+
+        size_t consumed = 0;
+        bool bad = false;
+        while (pending.size() - consumed >= 4)
+        {
+            const uint8_t *frame = reinterpret_cast<const uint8_t *>(pending.data() + consumed);
+            uint32_t len = aerial_ipc_get_u32(frame);
+            if (len == 0 || len > AERIAL_IPC_MAX_FRAME)
+            {
+                bad = true; // framing is lost; drop the client
+                break;
+            }
+            if (pending.size() - consumed - 4 < len)
+                break;
+            handle_ipc_request(ctx, frame + 4, len, body, replies);
+            consumed += 4 + len;
+        }
+        pending.erase(0, consumed);
+
+        if (!replies.empty())
+        {
+            const std::string_view parts[] = {replies.view()};
+            if (!send_all(client, parts, 1))
+                break;
+        }
+        if (bad)
+            break;
+    }
+
+    close_socket(client);
+}
+
+bool start_ipc_server(Player &player, std::shared_ptr<Playlist> playlist, PlayDatabase *db,
+                      const std::string &socketPath)
+{
+    // Bound before returning, like the TCP servers, so the caller knows.
+    sockaddr_un addr{};
+    if (socketPath.size() >= sizeof(addr.sun_path))
+    {
+        AERIAL_ERROR("IPC", "socket path too long: ", socketPath);
+        return false;
+    }
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    int serverSock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (serverSock < 0)
+    {
+        AERIAL_ERROR("IPC", "Failed to create socket");
+        return false;
+    }
+
+    unlink(socketPath.c_str()); // stale socket from a previous run
+
+    if (bind(serverSock, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0)
+    {
+        AERIAL_ERROR("IPC", "bind failed on ", socketPath);
+        close_socket(serverSock);
+        return false;
+    }
+
+    if (listen(serverSock, 8) < 0)
+    {
+        AERIAL_ERROR("IPC", "listen failed");
+        close_socket(serverSock);
+        return false;
+    }
+
+    AERIAL_INFO("IPC", "Listening on unix:", socketPath);
+
+    std::thread([&player, playlist, db, socketPath, serverSock]()
+                {
+                    CommandContext ctx{player, playlist, db};
+                    while (true)
+                    {
+                        int clientSock = accept(serverSock, nullptr, nullptr);
+                        if (clientSock < 0)
+                        {
+                            if (errno == EINTR)
+                                continue;
+                            AERIAL_ERROR("IPC", "accept failed, shutting down IPC server thread");
+                            break;
+                        }
+
+                        // Local clients are few and long-lived (e.g. a scheduler
+                        // daemon), so each gets its own thread.
+                        std::thread(handle_ipc_client, clientSock, ctx).detach();
+                    }
+
+                    close_socket(serverSock);
+                    unlink(socketPath.c_str());
+                })
+        .detach();
+    return true;
+}
+
+#else
+
+bool start_ipc_server(Player &, std::shared_ptr<Playlist>, PlayDatabase *, const std::string &socketPath)
+{
+    AERIAL_WARN("IPC", "Unix domain socket control is not supported on Windows; ignoring ",
+                socketPath);
+    return false;
+}
+
+#endif
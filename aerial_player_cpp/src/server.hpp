@@ -1,13 +1,25 @@
 #pragma once
 
 #include <memory>
+#include <string>
 
 class Player;
 class Playlist;
 class PlayDatabase;
 
-// Telnet-style raw TCP control: play, pause, next, etc.
-void start_control_server(Player& player, std::shared_ptr<Playlist> playlist, PlayDatabase* db);
+// Both TCP servers listen on 127.0.0.1 and move when a config reload
+// changes "port" / "http_port" (see LiveListener in server.cpp). They
+// bind before returning and return false, starting no thread, if they
+// could not.
 
-// HTTP control server for Postman/curl/etc. (default port 8080)
-void start_http_server(Player& player, std::shared_ptr<Playlist> playlist, int port = 8080);
+// Telnet-style raw TCP control: play, pause, next, etc. Port from config().
+bool start_control_server(Player& player, std::shared_ptr<Playlist> playlist, PlayDatabase* db);
+
+// HTTP control server for Postman/curl/etc. (config http_port, 8080 by default)
+bool start_http_server(Player& player, std::shared_ptr<Playlist> playlist, PlayDatabase* db, int port = 8080);
+
+// Local control over a Unix domain socket using the binary protocol in
+// aerial_ipc.h. Binds before returning; false if it could not, and always
+// on Windows, where it is not available.
+bool start_ipc_server(Player& player, std::shared_ptr<Playlist> playlist, PlayDatabase* db,
+                      const std::string& socketPath);
@@ -0,0 +1,452 @@
+/*
+   aerial_loadgen — load and soak generator for Aerial's TCP and HTTP
+   control servers.
+
+     aerial_loadgen [--clients N] [--mix SPEC] [--rate R] [--duration S]
+                    [--interval S] [--pid PID] [--csv FILE] [--search TERMS]
+                    [--host ADDR] [--tcp-port N] [--http-port N]
+
+   Every client thread picks operations from a weighted mix, e.g.
+
+     --mix http:status=6,tcp:status=2,tcp:next=1,http:search=1
+
+   TCP operations open a connection, send the command followed by "ping"
+   and wait for the PONG; HTTP operations are one request per connection,
+   as the server closes after every reply. Both servers handle one
+   client at a time, so queueing behind other clients is part of the
+   measured latency.
+
+   Every --interval seconds one line goes to stdout: throughput, errors,
+   p50/p99/p999 latency over that interval and, with --pid, the player's
+   RSS, open fds and thread count (from /proc). --csv appends the same
+   numbers per interval for plotting long soaks. A per-operation summary
+   follows at the end (or on Ctrl-C).
+
+   Run the player with `aerial --headless <folder>` to load it without a
+   sound device; tools/soak.sh does both.
+*/
+
+#include "Metrics.hpp"
+
+#include <arpa/inet.h>
+#include <dirent.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+enum class Proto { Tcp, Http };
+
+struct Op {
+    Proto proto;
+    std::string name;  // "next", "status", ...
+    unsigned weight;
+    Histogram latency;
+    Counter errors;
+};
+
+struct Options {
+    std::string host = "127.0.0.1";
+    int tcpPort = 5050;
+    int httpPort = 8080;
+    int clients = 8;
+    std::string mix = "http:status=6,tcp:status=2,tcp:next=1,http:search=1";
+    double rate = 0;        // per client; 0 = back to back
+    double duration = 60;   // 0 = until interrupted
+    double interval = 10;
+    int pid = 0;
+    std::string csv;
+    std::vector<std::string> searchTerms = {"track", "the", "01"};
+};
+
+static const char* const kTcpOps[] = {"next", "prev", "status", "ping", "vol", "seek", "pause", "resume"};
+static const char* const kHttpOps[] = {"status", "next", "prev", "search", "tracks", "metrics", "batch"};
+
+static std::atomic<bool> g_stop{false};
+
+static void on_signal(int) {
+    g_stop.store(true);
+}
+
+static void usage() {
+    std::fprintf(stderr,
+        "usage: aerial_loadgen [--clients N] [--mix SPEC] [--rate R] [--duration S]\n"
+        "                      [--interval S] [--pid PID] [--csv FILE] [--search TERMS]\n"
+        "                      [--host ADDR] [--tcp-port N] [--http-port N]\n"
+        "  SPEC: comma-separated proto:op=weight\n"
+        "    tcp ops:  next prev status ping vol seek pause resume\n"
+        "    http ops: status next prev search tracks metrics batch\n");
+}
+
+static std::vector<std::string> split(const std::string& s, char sep) {
+    std::vector<std::string> out;
+    size_t start = 0;
+    while (start <= s.size()) {
+        size_t end = s.find(sep, start);
+        if (end == std::string::npos) end = s.size();
+        if (end > start) out.push_back(s.substr(start, end - start));
+        start = end + 1;
+    }
+    return out;
+}
+
+template <size_t N>
+static bool known(const char* const (&names)[N], const std::string& op) {
+    for (const char* n : names)
+        if (op == n) return true;
+    return false;
+}
+
+static bool parse_mix(const std::string& spec, std::vector<std::unique_ptr<Op>>& ops) {
+    for (const std::string& item : split(spec, ',')) {
+        size_t colon = item.find(':');
+        if (colon == std::string::npos) return false;
+        const std::string proto = item.substr(0, colon);
+        std::string name = item.substr(colon + 1);
+        unsigned weight = 1;
+        size_t eq = name.find('=');
+        if (eq != std::string::npos) {
+            weight = static_cast<unsigned>(std::atoi(name.c_str() + eq + 1));
+            name.resize(eq);
+        }
+        auto op = std::make_unique<Op>();
+        if (proto == "tcp" && known(kTcpOps, name)) op->proto = Proto::Tcp;
+        else if (proto == "http" && known(kHttpOps, name)) op->proto = Proto::Http;
+        else return false;
+        op->name = name;
+        op->weight = weight;
+        if (weight > 0) ops.push_back(std::move(op));
+    }
+    return !ops.empty();
+}
+
+// ───────────── Network ─────────────
+
+static int connect_to(const Options& o, int port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    timeval tv{5, 0};  // a stuck server counts as an error, not a hang
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (inet_pton(AF_INET, o.host.c_str(), &addr.sin_addr) != 1 ||
+        ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool send_all(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+static bool tcp_op(const Options& o, const std::string& command, std::string& buf) {
+    int fd = connect_to(o, o.tcpPort);
+    if (fd < 0) return false;
+    bool ok = send_all(fd, command + "\nping\n");
+    buf.clear();
+    char chunk[4096];
+    while (ok) {
+        ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) {
+            ok = false;
+            break;
+        }
+        buf.append(chunk, static_cast<size_t>(n));
+        if (buf.find("PONG") != std::string::npos) break;
+    }
+    ::close(fd);
+    return ok && buf.find("ERR") == std::string::npos;
+}
+
+static bool http_op(const Options& o, const std::string& request, std::string& buf) {
+    int fd = connect_to(o, o.httpPort);
+    if (fd < 0) return false;
+    bool ok = send_all(fd, request);
+    buf.clear();
+    char chunk[16384];
+    while (ok) {
+        ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (n < 0) ok = false;
+        if (n <= 0) break;
+        buf.append(chunk, static_cast<size_t>(n));
+    }
+    ::close(fd);
+    // "HTTP/1.1 200 OK" or "HTTP/1.1 206 ..."
+    return ok && buf.size() > 12 && buf.compare(0, 9, "HTTP/1.1 ") == 0 && buf[9] == '2';
+}
+
+static std::string http_request(const char* method, const std::string& target, const std::string& body = "") {
+    std::string r = std::string(method) + ' ' + target + " HTTP/1.1\r\nHost: aerial\r\n";
+    if (!body.empty())
+        r += "Content-Type: application/json\r\nContent-Length: " + std::to_string(body.size()) + "\r\n";
+    return r + "\r\n" + body;
+}
+
+static bool run_op(const Options& o, const Op& op, std::mt19937& rng, std::string& buf) {
+    if (op.proto == Proto::Tcp) {
+        std::string command = op.name;
+        if (op.name == "vol") command += ' ' + std::to_string(rng() % 101);
+        else if (op.name == "seek") command += ' ' + std::to_string(rng() % 120);
+        return tcp_op(o, command, buf);
+    }
+    if (op.name == "status") return http_op(o, http_request("GET", "/status"), buf);
+    if (op.name == "next" || op.name == "prev") return http_op(o, http_request("POST", "/" + op.name), buf);
+    if (op.name == "search")
+        return http_op(o, http_request("GET", "/search?q=" + o.searchTerms[rng() % o.searchTerms.size()]), buf);
+    if (op.name == "tracks")
+        return http_op(o, http_request("GET", "/tracks?cursor=" + std::to_string(rng() % 1000) + "&limit=50"), buf);
+    if (op.name == "metrics") return http_op(o, http_request("GET", "/metrics"), buf);
+    return http_op(o, http_request("POST", "/batch", "[\"vol 50\",\"next\"]"), buf);
+}
+
+static void client_loop(const Options& o, const std::vector<std::unique_ptr<Op>>& ops, unsigned seed) {
+    std::mt19937 rng(seed);
+    unsigned total = 0;
+    for (const auto& op : ops) total += op->weight;
+
+    std::string buf;
+    buf.reserve(1 << 16);
+    auto next = Clock::now();
+    const auto period = o.rate > 0 ? std::chrono::duration_cast<Clock::duration>(
+                                         std::chrono::duration<double>(1.0 / o.rate))
+                                   : Clock::duration::zero();
+
+    while (!g_stop.load(std::memory_order_relaxed)) {
+        unsigned pick = rng() % total;
+        Op* op = ops.front().get();
+        for (const auto& candidate : ops) {
+            if (pick < candidate->weight) {
+                op = candidate.get();
+                break;
+            }
+            pick -= candidate->weight;
+        }
+
+        const uint64_t start = monotonic_ns();
+        const bool ok = run_op(o, *op, rng, buf);
+        op->latency.record(monotonic_ns() - start);
+        if (!ok) op->errors.add();
+
+        if (period != Clock::duration::zero()) {
+            next += period;
+            std::this_thread::sleep_until(next);
+        }
+    }
+}
+
+// ───────────── Reporting ─────────────
+
+struct ProcessStats {
+    long rssKb = -1;
+    long fds = -1;
+    long threads = -1;
+};
+
+static ProcessStats sample_process(int pid) {
+    ProcessStats s;
+    if (pid <= 0) return s;
+    const std::string base = "/proc/" + std::to_string(pid);
+
+    std::ifstream status(base + "/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmRSS:") == 0) s.rssKb = std::atol(line.c_str() + 6);
+        else if (line.compare(0, 8, "Threads:") == 0) s.threads = std::atol(line.c_str() + 8);
+    }
+    if (DIR* dir = opendir((base + "/fd").c_str())) {
+        s.fds = 0;
+        while (dirent* e = readdir(dir))
+            if (e->d_name[0] != '.') ++s.fds;
+        closedir(dir);
+    }
+    return s;
+}
+
+// Bucket counts summed over every op; kept to diff one interval from the last.
+using Buckets = std::vector<uint64_t>;
+
+static Buckets snapshot(const std::vector<std::unique_ptr<Op>>& ops, uint64_t& errors) {
+    Buckets b(Histogram::kBuckets, 0);
+    errors = 0;
+    for (const auto& op : ops) {
+        for (size_t i = 0; i < Histogram::kBuckets; ++i) b[i] += op->latency.bucketCount(i);
+        errors += op->errors.value();
+    }
+    return b;
+}
+
+static double quantile_ms(const Buckets& counts, uint64_t total, double q) {
+    if (total == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(total));
+    if (rank == 0) rank = 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        if (seen >= rank) return static_cast<double>(Histogram::bucketUpper(i)) / 1e6;
+    }
+    return static_cast<double>(Histogram::bucketUpper(counts.size() - 1)) / 1e6;
+}
+
+static void print_summary(const std::vector<std::unique_ptr<Op>>& ops, double seconds) {
+    std::printf("\n%-14s %10s %8s %10s %10s %10s %10s\n",
+                "op", "count", "errors", "ops/s", "p50 ms", "p99 ms", "p999 ms");
+    for (const auto& op : ops) {
+        const uint64_t n = op->latency.count();
+        std::printf("%-14s %10llu %8llu %10.1f %10.3f %10.3f %10.3f\n",
+                    ((op->proto == Proto::Tcp ? "tcp:" : "http:") + op->name).c_str(),
+                    static_cast<unsigned long long>(n),
+                    static_cast<unsigned long long>(op->errors.value()),
+                    seconds > 0 ? n / seconds : 0.0,
+                    op->latency.quantile(0.50) / 1e6,
+                    op->latency.quantile(0.99) / 1e6,
+                    op->latency.quantile(0.999) / 1e6);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Options o;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        auto take = [&]() -> const char* {
+            if (!value) {
+                usage();
+                std::exit(2);
+            }
+            ++i;
+            return value;
+        };
+        if (arg == "--host") o.host = take();
+        else if (arg == "--tcp-port") o.tcpPort = std::atoi(take());
+        else if (arg == "--http-port") o.httpPort = std::atoi(take());
+        else if (arg == "--clients") o.clients = std::atoi(take());
+        else if (arg == "--mix") o.mix = take();
+        else if (arg == "--rate") o.rate = std::atof(take());
+        else if (arg == "--duration") o.duration = std::atof(take());
+        else if (arg == "--interval") o.interval = std::atof(take());
+        else if (arg == "--pid") o.pid = std::atoi(take());
+        else if (arg == "--csv") o.csv = take();
+        else if (arg == "--search") o.searchTerms = split(take(), ',');
+        else {
+            usage();
+            return 2;
+        }
+    }
+
+    std::vector<std::unique_ptr<Op>> ops;
+    if (o.clients < 1 || o.interval <= 0 || o.searchTerms.empty() || !parse_mix(o.mix, ops)) {
+        usage();
+        return 2;
+    }
+
+    std::FILE* csv = nullptr;
+    if (!o.csv.empty()) {
+        csv = std::fopen(o.csv.c_str(), "a");
+        if (!csv) {
+            std::fprintf(stderr, "cannot open %s\n", o.csv.c_str());
+            return 1;
+        }
+        std::fprintf(csv, "elapsed_s,ops,ops_per_s,errors,p50_ms,p99_ms,p999_ms,rss_kb,fds,threads\n");
+    }
+
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+
+    std::printf("aerial_loadgen: %d clients, mix %s, %s\n", o.clients, o.mix.c_str(),
+                o.duration > 0 ? (std::to_string(static_cast<long>(o.duration)) + " s").c_str()
+                               : "until interrupted");
+    std::fflush(stdout);
+
+    const auto started = Clock::now();
+    std::vector<std::thread> clients;
+    for (int c = 0; c < o.clients; ++c)
+        clients.emplace_back(client_loop, std::cref(o), std::cref(ops), 0x5eed + c);
+
+    uint64_t lastErrors = 0;
+    Buckets last = snapshot(ops, lastErrors);
+    auto lastAt = started;
+    auto nextReport = started + std::chrono::duration_cast<Clock::duration>(
+                                    std::chrono::duration<double>(o.interval));
+
+    while (!g_stop.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        const auto now = Clock::now();
+        const double elapsed = std::chrono::duration<double>(now - started).count();
+        const bool done = o.duration > 0 && elapsed >= o.duration;
+        if (now < nextReport && !done) continue;
+
+        uint64_t errors = 0;
+        Buckets cur = snapshot(ops, errors);
+        Buckets delta(cur.size());
+        uint64_t n = 0;
+        for (size_t i = 0; i < cur.size(); ++i) {
+            delta[i] = cur[i] - last[i];
+            n += delta[i];
+        }
+        const double span = std::chrono::duration<double>(now - lastAt).count();
+        const ProcessStats ps = sample_process(o.pid);
+        const double p50 = quantile_ms(delta, n, 0.50);
+        const double p99 = quantile_ms(delta, n, 0.99);
+        const double p999 = quantile_ms(delta, n, 0.999);
+
+        std::printf("[%7.0fs] %9llu ops %9.1f ops/s  err %-6llu p50 %8.3f ms  p99 %8.3f ms  p999 %8.3f ms",
+                    elapsed, static_cast<unsigned long long>(n), span > 0 ? n / span : 0.0,
+                    static_cast<unsigned long long>(errors - lastErrors), p50, p99, p999);
+        if (o.pid > 0)
+            std::printf("  rss %.1f MiB  fds %ld  threads %ld", ps.rssKb / 1024.0, ps.fds, ps.threads);
+        std::printf("\n");
+        std::fflush(stdout);
+
+        if (csv) {
+            std::fprintf(csv, "%.1f,%llu,%.1f,%llu,%.3f,%.3f,%.3f,%ld,%ld,%ld\n",
+                         elapsed, static_cast<unsigned long long>(n), span > 0 ? n / span : 0.0,
+                         static_cast<unsigned long long>(errors - lastErrors), p50, p99, p999,
+                         ps.rssKb, ps.fds, ps.threads);
+            std::fflush(csv);
+        }
+
+        last = std::move(cur);
+        lastErrors = errors;
+        lastAt = now;
+        nextReport += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(o.interval));
+        if (done) g_stop.store(true);
+    }
+
+    for (auto& t : clients)
+        t.join();
+    print_summary(ops, std::chrono::duration<double>(Clock::now() - started).count());
+    if (csv) std::fclose(csv);
+
+    uint64_t errors = 0;
+    snapshot(ops, errors);
+    return errors ? 1 : 0;
+}
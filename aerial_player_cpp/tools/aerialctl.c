@@ -0,0 +1,279 @@
+/*
+   aerialctl — minimal client for Aerial's Unix domain socket control.
+
+     aerialctl [-s SOCKET] <command...>       e.g. next | vol 40 | status
+     aerialctl [-s SOCKET] --bench N [--tcp PORT]
+
+   --bench sends N PING frames over the Unix socket and reports round-trip
+   latency. With --tcp it also sends N "ping" lines to the text control
+   server on 127.0.0.1:PORT, for a side-by-side comparison.
+*/
+#define _POSIX_C_SOURCE 200809L
+
+#include "aerial_ipc.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+static int connect_unix(const char* path) {
+    struct sockaddr_un addr;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int write_all(int fd, const uint8_t* p, size_t n) {
+    while (n > 0) {
+        ssize_t w = write(fd, p, n);
+        if (w <= 0) return -1;
+        p += w;
+        n -= (size_t)w;
+    }
+    return 0;
+}
+
+static int read_all(int fd, uint8_t* p, size_t n) {
+    while (n > 0) {
+        ssize_t r = read(fd, p, n);
+        if (r <= 0) return -1;
+        p += r;
+        n -= (size_t)r;
+    }
+    return 0;
+}
+
+/* Sends one request frame and reads the reply payload into `reply`.
+   Returns the reply payload length, or -1 on error. */
+static int roundtrip(int fd, uint8_t op, const void* args, uint32_t argLen,
+                     uint8_t* reply, uint32_t replyCap) {
+    uint8_t frame[AERIAL_IPC_MAX_FRAME + 4];
+    uint32_t len = 1 + argLen;
+    if (len > AERIAL_IPC_MAX_FRAME) return -1;
+
+    aerial_ipc_put_u32(frame, len);
+    frame[4] = op;
+    if (argLen) memcpy(frame + 5, args, argLen);
+    if (write_all(fd, frame, 4 + len) < 0) return -1;
+
+    uint8_t hdr[4];
+    if (read_all(fd, hdr, 4) < 0) return -1;
+    uint32_t rlen = aerial_ipc_get_u32(hdr);
+    if (rlen < 2 || rlen > replyCap) return -1;
+    if (read_all(fd, reply, rlen) < 0) return -1;
+    return (int)rlen;
+}
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int cmp_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static void report(const char* label, double* samples, int n) {
+    double sum = 0;
+    qsort(samples, (size_t)n, sizeof(double), cmp_double);
+    for (int i = 0; i < n; ++i) sum += samples[i];
+    printf("%-6s n=%d  min=%.1fus  p50=%.1fus  p99=%.1fus  max=%.1fus  mean=%.1fus\n",
+           label, n, samples[0], samples[n / 2], samples[(int)(n * 0.99)],
+           samples[n - 1], sum / n);
+}
+
+static int bench_unix(const char* path, int n) {
+    uint8_t reply[AERIAL_IPC_MAX_FRAME];
+    double* samples = malloc(sizeof(double) * (size_t)n);
+    int fd = connect_unix(path);
+    if (fd < 0 || !samples) {
+        fprintf(stderr, "cannot connect to %s\n", path);
+        free(samples);
+        return 1;
+    }
+    for (int i = 0; i < n; ++i) {
+        double t0 = now_us();
+        if (roundtrip(fd, AERIAL_OP_PING, NULL, 0, reply, sizeof(reply)) < 0) {
+            fprintf(stderr, "unix: roundtrip failed\n");
+            close(fd);
+            free(samples);
+            return 1;
+        }
+        samples[i] = now_us() - t0;
+    }
+    close(fd);
+    report("unix", samples, n);
+    free(samples);
+    return 0;
+}
+
+/* Reads one '\n'-terminated line (discarding it). */
+static int read_line(int fd) {
+    char c;
+    for (;;) {
+        ssize_t r = read(fd, &c, 1);
+        if (r <= 0) return -1;
+        if (c == '\n') return 0;
+    }
+}
+
+/* Reads lines until one starts with `prefix`; -1 on EOF or after
+   max_lines lines without it. */
+static int read_until(int fd, const char* prefix, int max_lines) {
+    size_t want = strlen(prefix);
+    for (int line = 0; line < max_lines; ++line) {
+        size_t have = 0;
+        int match = 1;
+        char c;
+        for (;;) {
+            ssize_t r = read(fd, &c, 1);
+            if (r <= 0) return -1;
+            if (c == '\n') break;
+            if (have < want && c != prefix[have]) match = 0;
+            ++have;
+        }
+        if (match && have >= want) return 0;
+    }
+    return -1;
+}
+
+static int bench_tcp(int port, int n) {
+    struct sockaddr_in addr;
+    int one = 1;
+    double* samples = malloc(sizeof(double) * (size_t)n);
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd < 0 || !samples || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        fprintf(stderr, "cannot connect to 127.0.0.1:%d\n", port);
+        if (fd >= 0) close(fd);
+        free(samples);
+        return 1;
+    }
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    /* Skip the welcome banner, however many lines it has, up to the
+       "quiet" ack. */
+    if (write_all(fd, (const uint8_t*)"quiet\n", 6) < 0 || read_until(fd, "OK quiet", 64) < 0) {
+        fprintf(stderr, "tcp: handshake failed\n");
+        close(fd);
+        free(samples);
+        return 1;
+    }
+
+    for (int i = 0; i < n; ++i) {
+        double t0 = now_us();
+        if (write_all(fd, (const uint8_t*)"ping\n", 5) < 0 || read_line(fd) < 0) {
+            fprintf(stderr, "tcp: roundtrip failed\n");
+            close(fd);
+            free(samples);
+            return 1;
+        }
+        samples[i] = now_us() - t0;
+    }
+    close(fd);
+    report("tcp", samples, n);
+    free(samples);
+    return 0;
+}
+
+static void print_status(const uint8_t* body, int len) {
+    if (len < (int)AERIAL_IPC_STATUS_BODY_SIZE) {
+        printf("(short status reply)\n");
+        return;
+    }
+    uint32_t index = aerial_ipc_get_u32(body);
+    uint32_t size = aerial_ipc_get_u32(body + 4);
+    int32_t posMs = (int32_t)aerial_ipc_get_u32(body + 8);
+    unsigned volume = body[12];
+    unsigned flags = body[13];
+    uint16_t pathLen = aerial_ipc_get_u16(body + 14);
+    if ((int)(AERIAL_IPC_STATUS_BODY_SIZE + pathLen) > len) pathLen = 0;
+
+    printf("track:    %u / %u\n", index, size);
+    printf("path:     %.*s\n", (int)pathLen, (const char*)body + AERIAL_IPC_STATUS_BODY_SIZE);
+    printf("position: %.1fs\n", posMs / 1000.0);
+    printf("volume:   %u%%\n", volume);
+    printf("state:    %s\n", (flags & 2) ? "paused" : (flags & 1) ? "playing" : "stopped");
+}
+
+int main(int argc, char** argv) {
+    const char* path = AERIAL_IPC_DEFAULT_SOCKET;
+    int argi = 1;
+
+    if (argi + 1 < argc && strcmp(argv[argi], "-s") == 0) {
+        path = argv[argi + 1];
+        argi += 2;
+    }
+    if (argi >= argc) {
+        fprintf(stderr, "usage: %s [-s SOCKET] <command...> | --bench N [--tcp PORT]\n", argv[0]);
+        return 2;
+    }
+
+    if (strcmp(argv[argi], "--bench") == 0) {
+        int n = (argi + 1 < argc) ? atoi(argv[argi + 1]) : 10000;
+        if (n <= 0) n = 10000;
+        int rc = bench_unix(path, n);
+        if (argi + 3 < argc && strcmp(argv[argi + 2], "--tcp") == 0)
+            rc |= bench_tcp(atoi(argv[argi + 3]), n);
+        return rc;
+    }
+
+    /* Join the remaining words into one command string. */
+    char text[512];
+    size_t used = 0;
+    for (int i = argi; i < argc; ++i) {
+        size_t len = strlen(argv[i]);
+        if (used + len + 2 > sizeof(text)) break;
+        if (used) text[used++] = ' ';
+        memcpy(text + used, argv[i], len);
+        used += len;
+    }
+    text[used] = '\0';
+
+    int fd = connect_unix(path);
+    if (fd < 0) {
+        fprintf(stderr, "cannot connect to %s\n", path);
+        return 1;
+    }
+
+    uint8_t reply[AERIAL_IPC_MAX_FRAME];
+    int rlen;
+    if (strcmp(text, "status") == 0)
+        rlen = roundtrip(fd, AERIAL_OP_STATUS, NULL, 0, reply, sizeof(reply));
+    else if (strcmp(text, "ping") == 0)
+        rlen = roundtrip(fd, AERIAL_OP_PING, NULL, 0, reply, sizeof(reply));
+    else
+        rlen = roundtrip(fd, AERIAL_OP_TEXT, text, (uint32_t)used, reply, sizeof(reply));
+    close(fd);
+
+    if (rlen < 0) {
+        fprintf(stderr, "request failed\n");
+        return 1;
+    }
+
+    if (reply[0] == AERIAL_OP_STATUS && reply[1] == AERIAL_IPC_OK)
+        print_status(reply + 2, rlen - 2);
+    else
+        printf("%.*s\n", rlen - 2, (const char*)reply + 2);
+
+    return reply[1] == AERIAL_IPC_OK ? 0 : 1;
+}
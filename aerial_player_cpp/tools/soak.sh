@@ -0,0 +1,48 @@
+#!/bin/sh
+# soak.sh — run the player headless under aerial_loadgen for a long soak.
+#
+#   tools/soak.sh <music_folder> [hours] [aerial_loadgen options...]
+#
+# Starts `aerial --headless`, waits for the HTTP server, then runs the load
+# generator against it with --pid so RSS / fd / thread counts are sampled
+# every minute into soak-<timestamp>.csv. The player's own output goes to
+# soak-<timestamp>.log. AERIAL and LOADGEN override the binaries (default:
+# ./aerial and ./aerial_loadgen, i.e. run from the build directory).
+
+set -eu
+
+if [ $# -lt 1 ]; then
+    echo "usage: $0 <music_folder> [hours] [aerial_loadgen options...]" >&2
+    exit 2
+fi
+
+folder=$1
+hours=${2:-1}
+[ $# -ge 2 ] && shift 2 || shift 1
+
+AERIAL=${AERIAL:-./aerial}
+LOADGEN=${LOADGEN:-./aerial_loadgen}
+stamp=$(date +%Y%m%d-%H%M%S)
+
+"$AERIAL" --headless "$folder" > "soak-$stamp.log" 2>&1 &
+player=$!
+trap 'kill "$player" 2>/dev/null || true' EXIT INT TERM
+
+tries=0
+until curl -fs http://127.0.0.1:8080/status > /dev/null 2>&1; do
+    tries=$((tries + 1))
+    if [ "$tries" -gt 100 ] || ! kill -0 "$player" 2>/dev/null; then
+        echo "player did not come up; see soak-$stamp.log" >&2
+        exit 1
+    fi
+    sleep 0.1
+done
+
+seconds=$(awk "BEGIN { print int($hours * 3600) }")
+status=0
+"$LOADGEN" --pid "$player" --duration "$seconds" --interval 60 \
+           --csv "soak-$stamp.csv" "$@" || status=$?
+
+kill -TERM "$player" 2>/dev/null || true
+wait "$player" 2>/dev/null || true
+exit "$status"